@@ -9,12 +9,31 @@
 
 #include <vector>
 #include <algorithm>
+#include <unordered_map>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
 
 
 namespace bpp
 {
 	namespace _priv
 	{
+		/**
+		 * Number of bits set in a 64-bit word.
+		 */
+		inline std::size_t popcount(std::uint64_t x)
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return (std::size_t)__builtin_popcountll(x);
+#else
+			std::size_t count = 0;
+			for (; x != 0; x &= x - 1) ++count;
+			return count;
+#endif
+		}
+
+
 		std::pair<std::size_t, std::size_t> computeWindow(std::size_t r, std::size_t rowSize, std::size_t maxWindowSize)
 		{
 			std::size_t fromI = 0, toI = rowSize;
@@ -74,6 +93,9 @@ namespace bpp
 
 		/**
 		 * Internal implementation of longest common subsequence algorithm which founds exactly one common subsequence.
+		 * The LCS matrix is not kept in memory. Only every k-th row (k ~ sqrt of the rows) is stored while the matrix
+		 * is filled in, the rows between them are recomputed block by block while the result path is collected.
+		 * The memory is O(size1 * sqrt(size2)) instead of O(size1 * size2) at the cost of computing the rows twice.
 		 * \tparam RES The result type (must be an integral type).
 		 * \tparam CONTAINER Class holding the sequence. The class must have size() method
 		 *         and the comparator must be able to get values from the container based on their indices.
@@ -84,89 +106,66 @@ namespace bpp
 		void longest_common_subsequence(const CONTAINER& sequence1, const CONTAINER& sequence2,
 			std::vector<std::pair<IDX, IDX>>& common, COMPARATOR comparator, std::size_t maxWindowSize = 0)
 		{
-			struct Node {
-				std::pair<IDX, IDX> previous;
-				IDX length;
-				bool match;
-			public:
-				Node() : length(0), match(false) {}
-			};
-
-			
-			class NodeMatrix
-			{
-			private:
-				std::size_t mSize1;
-				std::vector<Node> mNodes;
-			public:
-				NodeMatrix(std::size_t size1, std::size_t size2) : mSize1(size1 + 1)
-				{
-					mNodes.resize((size1 + 1) * (size2 + 1));
-					for (std::size_t i = 1; i <= size1; ++i) {
-						at(i, 0).previous.first = 1;
-					}
-					for (std::size_t i = 1; i <= size2; ++i) {
-						at(0, i).previous.second = 1;
-					}
-				}
-
-				Node& at(std::size_t c, std::size_t r)
-				{
-					return mNodes[r * mSize1 + c];
-				}
-			};
-
-
 			common.clear();
 			if (sequence1.size() == 0 || sequence2.size() == 0) return;
 
 			const std::size_t size1 = sequence1.size();
 			const std::size_t size2 = sequence2.size();
-			NodeMatrix matrix(size1, size2);
-
-			// Fill in the LCS matrix by dynamic programming
-			for (std::size_t r = 0; r < size2; ++r) { // iterate over rows
-				auto window = computeWindow(r, size1, maxWindowSize);
-				for (std::size_t c = window.first; c < window.second; ++c) { // iterate over cols
-					bool match = matrix.at(c+1, r+1).match = comparator(sequence1, c, sequence2, r);
-
-					if (match) {
-						// Matching tokens should prolong the sequence...
-						matrix.at(c + 1, r + 1).length = matrix.at(c, r).length + 1;
-						matrix.at(c + 1, r + 1).previous.first = 1;
-						matrix.at(c + 1, r + 1).previous.second = 1;
-					}
-					else {
-						IDX leftLength = matrix.at(c, r + 1).length;
-						IDX upperLength = matrix.at(c + 1, r).length;
-						if (leftLength >= upperLength) {
-							matrix.at(c + 1, r + 1).previous.first = 1;
-							matrix.at(c + 1, r + 1).length = leftLength;
-						}
-						else {
-							matrix.at(c + 1, r + 1).previous.second = 1;
-							matrix.at(c + 1, r + 1).length = upperLength;
-						}
-					}
+
+			// Compute one row (r is its index in the matrix) from the previous one, cells outside window remain 0.
+			auto computeRow = [&](const std::vector<IDX>& upper, std::vector<IDX>& row, std::size_t r) {
+				row.assign(size1 + 1, 0);
+				auto window = computeWindow(r - 1, size1, maxWindowSize);
+				for (std::size_t c = window.first; c < window.second; ++c) {
+					row[c + 1] = (comparator(sequence1, c, sequence2, r - 1))
+						? upper[c] + 1
+						: std::max(row[c], upper[c + 1]);
 				}
+			};
+
+			std::size_t step = 1;
+			while (step * step < size2) ++step;
+
+			// Fill in the LCS matrix by dynamic programming, keep only rows at the beginnings of the blocks
+			std::vector<std::vector<IDX>> checkpoints(1, std::vector<IDX>(size1 + 1, 0));
+			std::vector<IDX> row = checkpoints.back();
+			for (std::size_t r = 1; r <= (size2 - 1) / step * step; ++r) {
+				std::vector<IDX> upper;
+				upper.swap(row);
+				computeRow(upper, row, r);
+				if (r % step == 0) checkpoints.push_back(row);
 			}
 
-			// Collect the result path from the matrix...
+			// Collect the result path from the matrix, rows of each block are recomputed from its checkpoint...
 			std::size_t c = size1;
 			std::size_t r = size2;
+			std::vector<std::vector<IDX>> block;
 			while (c > 0 && r > 0) {
-				const Node& node = matrix.at(c, r);
-				if (node.match) {
-					common.push_back(std::make_pair<IDX, IDX>(c - 1, r - 1));
+				std::size_t first = (r - 1) / step * step;
+				block.resize(r - first + 1);
+				block[0] = checkpoints[first / step];
+				for (std::size_t i = 1; i < block.size(); ++i) {
+					computeRow(block[i - 1], block[i], first + i);
 				}
 
-				if (node.previous.first + node.previous.second > 0) {
-					c -= node.previous.first;
-					r -= node.previous.second;
-				}
-				else { // let's make sure we will not get stuck (if approx. version of LCS is running)
-					if (c >= r) --c;
-					if (c <= r) --r;
+				while (c > 0 && r > first) {
+					auto window = computeWindow(r - 1, size1, maxWindowSize);
+					bool computed = c - 1 >= window.first && c - 1 < window.second;
+
+					if (computed && comparator(sequence1, c - 1, sequence2, r - 1)) {
+						// Matching tokens prolong the sequence...
+						common.push_back(std::make_pair<IDX, IDX>(c - 1, r - 1));
+						--c;
+						--r;
+					}
+					else if (computed) {
+						if (block[r - first][c - 1] >= block[r - first - 1][c]) --c;
+						else --r;
+					}
+					else { // let's make sure we will not get stuck (if approx. version of LCS is running)
+						if (c >= r) --c;
+						if (c <= r) --r;
+					}
 				}
 			}
 
@@ -175,6 +174,100 @@ namespace bpp
 		}
 	}
 
+	/**
+	 * Implements a longest common subsequence algorithm, which founds only the length of the LCS itself.
+	 * Bit-parallel algorithm of Allison and Dix (as improved by Hyyro) is used, which processes 64 items
+	 * of the shorter sequence in one step, so it is exact and much faster than the classic dynamic programming.
+	 * The comparator must be an equivalence and items which are equal must have the same hash.
+	 * \tparam RES The result type (must be an integral type).
+	 * \tparam CONTAINER Class holding a sequence. The class must have size() method
+	 *         and the comparator must be able to get values from the container based on their indices.
+	 * \tparam HASHER Hasher class holds a static method hash(seq, i) -> std::size_t.
+	 * \tparam COMPARATOR Comparator class holds a static method compare(seq1, i1, seq2, i2) -> bool.
+	 *         I.e., the comparator is also responsible for fetching values from the seq. containers.
+	 */
+	template<typename RES = std::size_t, class CONTAINER, typename HASHER, typename COMPARATOR>
+	RES longest_common_subsequence_length_bitparallel(const CONTAINER &sequence1, const CONTAINER &sequence2,
+		HASHER hasher, COMPARATOR comparator)
+	{
+		if (sequence1.size() == 0 || sequence2.size() == 0) return (RES)0;
+
+		// Make sure in seq1 is the shorter sequence (its items are represented by bits) ...
+		const CONTAINER &seq1 = sequence1.size() <= sequence2.size() ? sequence1 : sequence2;
+		const CONTAINER &seq2 = sequence1.size() <= sequence2.size() ? sequence2 : sequence1;
+		const std::size_t size1 = (std::size_t)seq1.size();
+		const std::size_t size2 = (std::size_t)seq2.size();
+		const std::size_t words = (size1 + 63) / 64;
+		const std::size_t NO_MASK = ~(std::size_t)0;
+
+		// Equal items of seq1 share one match mask, the first of them represents the mask ...
+		std::unordered_multimap<std::size_t, std::pair<std::size_t, std::size_t>> classes; // hash -> (item, mask)
+		std::vector<std::uint64_t> masks;
+		auto findMask = [&](const CONTAINER &seq, std::size_t i, std::size_t hash) -> std::size_t {
+			auto range = classes.equal_range(hash);
+			for (auto it = range.first; it != range.second; ++it) {
+				if (comparator(seq1, it->second.first, seq, i)) return it->second.second;
+			}
+			return NO_MASK;
+		};
+
+		for (std::size_t i = 0; i < size1; ++i) {
+			std::size_t hash = hasher(seq1, i);
+			std::size_t mask = findMask(seq1, i, hash);
+			if (mask == NO_MASK) {
+				mask = masks.size() / words;
+				masks.resize(masks.size() + words, 0);
+				classes.insert(std::make_pair(hash, std::make_pair(i, mask)));
+			}
+			masks[mask * words + i / 64] |= (std::uint64_t)1 << (i % 64);
+		}
+
+		// Row of the LCS matrix is encoded in bits of V, zero bits mark positions where the LCS grows.
+		std::vector<std::uint64_t> V(words, ~(std::uint64_t)0);
+		for (std::size_t r = 0; r < size2; ++r) {
+			std::size_t mask = findMask(seq2, r, hasher(seq2, r));
+			if (mask == NO_MASK) continue; // item matches nothing, the row is not changed
+
+			// V = (V + (V & M)) | (V & ~M) computed over all words with carry propagation
+			const std::uint64_t *M = &masks[mask * words];
+			std::uint64_t carry = 0;
+			for (std::size_t k = 0; k < words; ++k) {
+				std::uint64_t u = V[k] & M[k];
+				std::uint64_t sum = V[k] + u;
+				std::uint64_t nextCarry = sum < u ? 1 : 0;
+				sum += carry;
+				nextCarry |= sum < carry ? 1 : 0;
+				carry = nextCarry;
+				V[k] = sum | (V[k] & ~M[k]);
+			}
+		}
+
+		// Bits above size1 in the last word are not part of the row.
+		std::size_t ones = 0;
+		for (std::size_t k = 0; k < words; ++k) {
+			std::uint64_t v = V[k];
+			if (k == words - 1 && size1 % 64 != 0) v &= ((std::uint64_t)1 << (size1 % 64)) - 1;
+			ones += _priv::popcount(v);
+		}
+		return (RES)(size1 - ones);
+	}
+
+
+	// Only an overload that uses default hasher and comparator.
+	template<typename RES = std::size_t, class CONTAINER>
+	RES longest_common_subsequence_length_bitparallel(const CONTAINER &sequence1, const CONTAINER &sequence2)
+	{
+		return longest_common_subsequence_length_bitparallel<RES>(sequence1, sequence2,
+			[](const CONTAINER &seq, std::size_t i) -> std::size_t {
+				return std::hash<typename std::decay<decltype(seq[i])>::type>()(seq[i]);
+			},
+			[](const CONTAINER &seq1, std::size_t i1, const CONTAINER &seq2, std::size_t i2) -> bool {
+				return seq1[i1] == seq2[i2];
+			}
+		);
+	}
+
+
 	/**
 	 * Implements a longest common subsequence algorithm, which founds only the length of the LCS itself.
 	 * \tparam RES The result type (must be an integral type).
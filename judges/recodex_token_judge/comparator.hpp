@@ -6,43 +6,20 @@
 #include <algo/lcs.hpp>
 #include <cli/logger.hpp>
 
-#include <map>
+#include <vector>
+#include <utility>
 #include <algorithm>
 #include <string>
 #include <limits>
 #include <memory>
 
 #include <cmath>
+#include <cctype>
 #include <cstdlib>
+#include <cstring>
 #include <cstdint>
 #include <cassert>
 
-/**
- * Try to parse long int out of a string. Return true if the string contains only an integer, false otherwise.
- * \param str String to be parsed.
- * \param res Reference to a variable where the parsed number will be stored.
- */
-template <typename STRING> bool try_get_int(const STRING &str, long int &res)
-{
-	char *end;
-	res = std::strtol(str.c_str(), &end, 10);
-	return (end - str.c_str() == (int) str.length());
-}
-
-
-/**
- * Try to parse double out of a string. Return true if the string contains only a double, false otherwise.
- * \param str String to be parsed.
- * \param res Reference to a variable where the parsed number will be stored.
- */
-template <typename STRING> bool try_get_double(const STRING &str, double &res)
-{
-	char *end;
-	res = std::strtod(str.c_str(), &end);
-	return (end - str.c_str() == (int) str.length());
-}
-
-
 /**
  * Comparator that compares tokens for equality based on given configuration switches.
  */
@@ -52,68 +29,13 @@ public:
 	using char_t = CHAR;
 	using offset_t = OFFSET;
 
-private:
 	/**
-	 * Internal structure where tokens are loaded if more commplex comparison is required.
+	 * Numeric value of a token (see Reader::NumericToken).
 	 */
-	struct TokenPair {
-		using string_t = std::basic_string<CHAR, std::char_traits<CHAR>, std::allocator<CHAR>>;
-
-	public:
-		string_t token[2];
-
-		TokenPair(const char_t *t1, offset_t len1, const char_t *t2, offset_t len2)
-		{
-			token[0].assign(t1, len1);
-			token[1].assign(t2, len2);
-		}
-
-		string_t &first()
-		{
-			return token[0];
-		}
-
-		const string_t &first() const
-		{
-			return token[0];
-		}
-
-		string_t &second()
-		{
-			return token[1];
-		}
-
-		const string_t &second() const
-		{
-			return token[1];
-		}
-
-
-		/**
-		 * Atempt to parse both tokens as integers.
-		 * \param num1 Result number of the first token.
-		 * \param num2 Result number of the second token.
-		 * \return True if both values are ints, false otherwise.
-		 */
-		bool tryGetInts(long int &num1, long int &num2)
-		{
-			return try_get_int(first(), num1) && try_get_int(second(), num2);
-		}
-
-
-		/**
-		 * Atempt to parse both tokens as doubles.
-		 * \param num1 Result number of the first token.
-		 * \param num2 Result number of the second token.
-		 * \return True if both values are doubles, false otherwise.
-		 */
-		bool tryGetFloats(double &num1, double &num2)
-		{
-			return try_get_double(first(), num1) && try_get_double(second(), num2);
-		}
-	};
+	using NumericToken = typename Reader<CHAR, OFFSET>::NumericToken;
 
 
+private:
 	/**
 	 * Direct comparison of both strings as const-chars. Saves time as the const chars may point directly to mmaped
 	 * data.
@@ -178,25 +100,183 @@ public:
 	 */
 	bool compare(const char_t *t1, offset_t len1, const char_t *t2, offset_t len2) const
 	{
-		if (mNumeric && len1 < 32 && len2 < 32) { // no number should have more than 32 chars
-			TokenPair tokenPair(t1, len1, t2, len2);
+		if (mNumeric) { return compare(t1, len1, parseNumber(t1, len1), t2, len2, parseNumber(t2, len2)); }
+		return mIgnoreCase ? compareDirectLowercased(t1, len1, t2, len2) : compareDirect(t1, len1, t2, len2);
+	}
 
-			long int i1, i2;
-			if (tokenPair.tryGetInts(i1, i2)) { return i1 == i2; }
 
-			double d1, d2;
-			if (tokenPair.tryGetFloats(d1, d2)) {
-				// Divisor (normalizer) must not be zero, so we apply lower bound on it.
-				double divisorLimit = std::max(mFloatTolerance, 0.0001);
-				double divisor = std::max(std::abs(d1) + std::abs(d2), divisorLimit);
+	/**
+	 * Parse numeric value of a token for the comparison. Tokens with 32 or more chars are not parsed at all
+	 * (no number should have more than 32 chars), so they are compared as strings.
+	 */
+	NumericToken parseNumber(const char_t *t, offset_t len) const
+	{
+		return len < 32 ? NumericToken(t, len) : NumericToken();
+	}
 
-				double err = std::abs(d1 - d2) / divisor;
-				return err <= mFloatTolerance;
-			}
+
+	/**
+	 * Compare two tokens with already parsed numeric values (used only if numeric comparisons are on).
+	 * \param t1 Pointer to the raw data representing the first token.
+	 * \param len1 Number of characters of the first token.
+	 * \param num1 Numeric value of the first token.
+	 * \param t2 Pointer to the raw data representing the second token.
+	 * \param len2 Number of characters of the second token.
+	 * \param num2 Numeric value of the second token.
+	 * \return True if the tokens are matching, false otherwise.
+	 */
+	bool compare(const char_t *t1,
+		offset_t len1,
+		const NumericToken &num1,
+		const char_t *t2,
+		offset_t len2,
+		const NumericToken &num2) const
+	{
+		if (num1.isInt() && num2.isInt()) { return num1.intValue() == num2.intValue(); }
+
+		if (num1.isFloat() && num2.isFloat()) {
+			double d1 = num1.floatValue(), d2 = num2.floatValue();
+			// Divisor (normalizer) must not be zero, so we apply lower bound on it.
+			double divisorLimit = std::max(mFloatTolerance, 0.0001);
+			double divisor = std::max(std::abs(d1) + std::abs(d2), divisorLimit);
+
+			double err = std::abs(d1 - d2) / divisor;
+			return err <= mFloatTolerance;
 		}
 
 		return mIgnoreCase ? compareDirectLowercased(t1, len1, t2, len2) : compareDirect(t1, len1, t2, len2);
 	}
+
+
+	/**
+	 * Get the largest difference of two floats (either of them given) which may still be matched with tolerance.
+	 * It also bounds the difference of the smallest values of two sets of floats which are matched pairwise.
+	 * \param value The value of one of the floats.
+	 * \return The difference (slightly overestimated), infinity if the tolerance is too large to bound it.
+	 */
+	double floatMatchRadius(double value) const
+	{
+		// Matched floats satisfy |d1 - d2| <= k * (2|d1| + limit) where k = tol / (1 - tol), the smallest values
+		// of two matched sets then differ at most by k * (2|d1| + limit) / (1 - 2k).
+		if (mFloatTolerance * 3.0 >= 1.0) return std::numeric_limits<double>::infinity();
+		double divisorLimit = std::max(mFloatTolerance, 0.0001);
+		double radius = mFloatTolerance * (2.0 * std::abs(value) + divisorLimit) / (1.0 - 3.0 * mFloatTolerance);
+		return radius * (1.0 + 1e-9) + std::numeric_limits<double>::min();
+	}
+
+
+	/**
+	 * Compute hash of a token (FNV-1a) which is consistent with compare() if numeric comparisons are off,
+	 * i.e., matching tokens have the same hash.
+	 * \param t Pointer to the raw data representing the token.
+	 * \param len Number of characters of the token.
+	 * \return The hash value.
+	 */
+	std::size_t hash(const char_t *t, offset_t len) const
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+		for (offset_t i = 0; i < len; ++i) {
+			hash ^= (std::uint64_t)(mIgnoreCase ? std::tolower(t[i]) : t[i]);
+			hash *= 1099511628211ull;
+		}
+		return (std::size_t) hash;
+	}
+};
+
+
+/**
+ * Flat hash table with open addressing (linear probing) which counts occurrences of keys, i.e., a multiset.
+ * Unordered comparisons use it instead of std::map, so no allocation per token is needed.
+ * \tparam KEY Type of the keys (a small copyable value).
+ */
+template <typename KEY> class TokenCounter
+{
+public:
+	struct Record {
+		KEY key;
+		std::size_t hash;
+		int count;
+		bool used;
+	};
+
+private:
+	std::vector<Record> mRecords;
+	std::size_t mSize; ///< Number of used records.
+
+	/**
+	 * Double the capacity of the table and insert all used records again.
+	 */
+	void grow()
+	{
+		std::vector<Record> old(mRecords.size() * 2);
+		old.swap(mRecords);
+		std::size_t mask = mRecords.size() - 1;
+		for (auto &&record : old) {
+			if (!record.used) continue;
+			std::size_t i = record.hash & mask;
+			while (mRecords[i].used) i = (i + 1) & mask;
+			mRecords[i] = record;
+		}
+	}
+
+public:
+	TokenCounter() : mRecords(16), mSize(0)
+	{
+	}
+
+
+	/**
+	 * Add a difference to the counter of given key.
+	 * \param key The key being counted.
+	 * \param hash Hash of the key.
+	 * \param diff Value added to the counter.
+	 * \param equal Predicate which compares two keys with the same hash.
+	 */
+	template <typename EQUAL> void add(const KEY &key, std::size_t hash, int diff, const EQUAL &equal)
+	{
+		if ((mSize + 1) * 2 > mRecords.size()) grow();
+
+		std::size_t mask = mRecords.size() - 1;
+		std::size_t i = hash & mask;
+		while (mRecords[i].used && (mRecords[i].hash != hash || !equal(mRecords[i].key, key))) i = (i + 1) & mask;
+
+		Record &record = mRecords[i];
+		if (!record.used) {
+			record.key = key;
+			record.hash = hash;
+			record.count = 0;
+			record.used = true;
+			++mSize;
+		}
+		record.count += diff;
+	}
+
+
+	/**
+	 * Get the sum of absolute values of all counters.
+	 */
+	std::size_t absoluteSum() const
+	{
+		std::size_t sum = 0;
+		for (auto &&record : mRecords) {
+			if (record.used) sum += (std::size_t) std::abs(record.count);
+		}
+		return sum;
+	}
+
+
+	/**
+	 * Get all records with non-zero counters as pairs (key, count).
+	 * \param convert Functor which converts the key into the type of the pair key.
+	 */
+	template <typename T, typename CONVERT> std::vector<std::pair<T, int>> nonZero(const CONVERT &convert) const
+	{
+		std::vector<std::pair<T, int>> res;
+		for (auto &&record : mRecords) {
+			if (record.used && record.count != 0) res.push_back(std::make_pair(convert(record.key), record.count));
+		}
+		return res;
+	}
 };
 
 
@@ -212,12 +292,81 @@ public:
 	using line_t = typename Reader<CHAR, OFFSET>::Line;
 	using lineview_t = typename Reader<CHAR, OFFSET>::LineView;
 	using token_t = typename Reader<CHAR, OFFSET>::TokenRef;
+	using numeric_t = typename TokenComparator<CHAR, OFFSET>::NumericToken;
 
 private:
+	/**
+	 * Minimal size of LCS matrix (product of numbers of tokens) for which the bit-parallel LCS is used.
+	 * Hashing of the tokens does not pay off for shorter lines.
+	 */
+	static const std::size_t BITPARALLEL_LCS_MIN_CELLS = 1024;
+
 	TokenComparator<CHAR, OFFSET> &mTokenComparator; ///< Token comparator used for comparing tokens on the lines.
 	bool mShuffledTokens; ///< Whether the tokens on each line may be in arbitrary order.
 	std::size_t mApproxLcsMaxWindow; ///< Tuning (performance) parameter, when should LCS fall back to approx version
 
+	/**
+	 * Get the value by which a token is matched when numeric comparisons are on (consistently with compare()).
+	 * \param token Pointer to the raw data representing the token.
+	 * \param length Number of characters of the token.
+	 * \param value Set to the value of the token (negative zero is normalized), if it is matched by value.
+	 * \return 1 if the token is matched by its value (NaNs and infinities never match if tokens are ordered and
+	 *         they match only the same value if tokens are shuffled), 0 if it is not numeric (it is matched as
+	 *         a string), -1 if it is numeric, but its value does not determine matching (saturated integers which
+	 *         are compared as integers but not as floats).
+	 */
+	int numericValue(const char_t *token, offset_t length, double &value) const
+	{
+		if (mShuffledTokens) {
+			// Unordered comparison parses tokens of any length, integral floats become ints and NaN is a string
+			// (see fillCounters()).
+			numeric_t number(token, length);
+			if (number.isInt()) {
+				value = (double) number.intValue() + 0.0;
+				return 1;
+			}
+			if (!number.isFloat() || std::isnan(number.floatValue())) return 0;
+			value = number.floatValue() + 0.0;
+			return 1;
+		}
+
+		auto number = mTokenComparator.parseNumber(token, length);
+		if (!number.isFloat()) return 0;
+		if (number.isInt() &&
+			(number.intValue() == std::numeric_limits<long int>::max() ||
+				number.intValue() == std::numeric_limits<long int>::min())) {
+			return -1;
+		}
+		value = number.floatValue() + 0.0;
+		return 1;
+	}
+
+
+	/**
+	 * Compute hash of a numeric value (matching of the same values is checked by numericValue()).
+	 */
+	static std::uint64_t valueHash(double value)
+	{
+		std::uint64_t hash;
+		std::memcpy(&hash, &value, sizeof(hash));
+		return (hash ^ (hash >> 29)) * 0xbf58476d1ce4e5b9ull;
+	}
+
+
+	/**
+	 * Add hash of a token to the fingerprint of a line (commutatively if the tokens are shuffled).
+	 */
+	std::uint64_t combineFingerprint(std::uint64_t fingerprint, std::uint64_t hash) const
+	{
+		if (mShuffledTokens) {
+			// commutative combination, so the order of tokens does not matter
+			hash *= 11400714819323198485ull;
+			return fingerprint + (hash ^ (hash >> 32));
+		}
+		return (fingerprint ^ hash) * 1099511628211ull;
+	}
+
+
 	/**
 	 * Log one error of unordered token comparison (a token is superfluous or missing).
 	 * \tparam T Type of the token value.
@@ -239,18 +388,19 @@ private:
 
 
 	/**
-	 * Perform verification of map of values from the unordered comparison and log all errors.
+	 * Perform verification of token values and their counts from the unordered comparison and log all errors.
 	 * \tparam T Type of the token value.
 	 * \tparam LOGGING If false, the check is performed silently. Otherwise, the errors are logged using bpp::log().
-	 * \param mapValues The the map of values and their diffs to be checked.
+	 * \param values The values and their diffs to be checked (sorted by the values).
 	 * \param errorCount Accumulator incremented every time an error is encountererd.
 	 * \param line The index of the line where the error occured.
 	 * \param quote Whether the token value should be quoted (strings are quoted, ints and floats are not).
 	 */
 	template <typename T, bool LOGGING>
-	void checkMapValues(const std::map<T, int> &mapValues, result_t &errorCount, offset_t line, bool quote) const
+	void checkValues(
+		const std::vector<std::pair<T, int>> &values, result_t &errorCount, offset_t line, bool quote) const
 	{
-		for (auto &&it : mapValues) {
+		for (auto &&it : values) {
 			if (LOGGING && it.second != 0) {
 				// Ensure correct prefix and separation of individual errors ...
 				if (errorCount == 0) {
@@ -268,17 +418,39 @@ private:
 
 
 	/**
-	 * Filter token map, remove empty (zero occurences) records.
-	 * \tparam T Type of the keys in the token map.
-	 * \param m A map to be filtered.
+	 * Sort token values and their counts by the values and merge records with the same value.
+	 * \tparam T Type of the token value.
+	 * \param values Vector of pairs (value, count) to be sorted.
 	 */
-	template <typename T> static void mapRemoveEmpty(std::map<T, int> &m)
+	template <typename T> static void sortValues(std::vector<std::pair<T, int>> &values)
 	{
-		std::map<T, int> old;
-		old.swap(m);
-		for (auto it = old.begin(); it != old.end(); ++it) {
-			if (it->second != 0) { m[it->first] = it->second; }
+		std::stable_sort(values.begin(),
+			values.end(),
+			[](const std::pair<T, int> &a, const std::pair<T, int> &b) { return a.first < b.first; });
+
+		std::size_t last = 0;
+		for (std::size_t i = 1; i < values.size(); ++i) {
+			if (values[last].first < values[i].first) {
+				values[++last] = values[i];
+			} else {
+				values[last].second += values[i].second;
+			}
 		}
+		if (!values.empty()) values.resize(last + 1);
+	}
+
+
+	/**
+	 * Filter token values, remove empty (zero occurences) records.
+	 * \tparam T Type of the token value.
+	 * \param values Vector of pairs (value, count) to be filtered.
+	 */
+	template <typename T> static void removeEmpty(std::vector<std::pair<T, int>> &values)
+	{
+		values.erase(std::remove_if(values.begin(),
+						 values.end(),
+						 [](const std::pair<T, int> &value) { return value.second == 0; }),
+			values.end());
 	}
 
 
@@ -302,11 +474,13 @@ private:
 	 * Get the iterator to a record in double tokens, which is closest to given key (within float tolerance)
 	 * and which has count with the same sign as D.
 	 * \tparam D Sing of the count value, incidently identifying from which file the token is.
-	 * \param tokens Map of double tokens and their counts.
-	 * \param key Key being searched in the map.
+	 * \param tokens Double tokens and their counts sorted by the tokens.
+	 * \param key Key being searched in the tokens.
 	 * \return Iterator into the double tokens (end iterator if no valid record is found).
 	 */
-	template <int D> std::map<double, int>::iterator findClosest(std::map<double, int> &tokens, double key) const
+	template <int D>
+	std::vector<std::pair<double, int>>::iterator findClosest(
+		std::vector<std::pair<double, int>> &tokens, double key) const
 	{
 		// Compute key range by given tolerance...
 		const double epsilon = mTokenComparator.floatTolerance();
@@ -314,7 +488,10 @@ private:
 		double upper = key * (1 + epsilon) / (1 - epsilon);
 
 		// Find the best candidate closest to key...
-		auto it = tokens.upper_bound(lower);
+		auto it = std::upper_bound(tokens.begin(),
+			tokens.end(),
+			lower,
+			[](double value, const std::pair<double, int> &token) { return value < token.first; });
 		auto bestIt = tokens.end();
 		while (it != tokens.end() && it->first <= upper) {
 			if (it->second != 0 && it->second / std::abs(it->second) == D) {
@@ -331,43 +508,62 @@ private:
 
 
 	/**
-	 * Fill token maps with values from a line.
+	 * Key of a string token in the token counter (refers directly to the data of the line).
+	 */
+	struct StringKey {
+		const char_t *data;
+		offset_t length;
+	};
+
+
+	/**
+	 * Fill token counters with values from a line.
 	 * \tparam D Increment/decrement (+1/-1) value which is added to counter for each token found.
 	 * \param line Parsed line being processed.
-	 * \param stringTokens Map with string tokens to be filled up.
-	 * \param intTokens Map with integer tokens to be filled up.
+	 * \param stringTokens Counter of string tokens to be filled up.
+	 * \param intTokens Counter of integer tokens to be filled up.
 	 * \param handleDoubles Lambda callback which handles double values (since they require more
 	 *                      attention and have to be handled differently for correst and result lines).
 	 */
 	template <int D, typename FNC>
-	void fillMaps(const line_t &line,
-		std::map<std::string, int> &stringTokens,
-		std::map<long long int, int> &intTokens,
+	void fillCounters(const line_t &line,
+		TokenCounter<StringKey> &stringTokens,
+		TokenCounter<long long int> &intTokens,
 		const FNC &&handleDoubles) const
 	{
-		// Fill in the sets with the first line ...
+		auto stringsEqual = [](const StringKey &a, const StringKey &b) {
+			return a.length == b.length && std::equal(a.data, a.data + a.length, b.data);
+		};
+		auto intsEqual = [](long long int a, long long int b) { return a == b; };
+		auto intHash = [](long long int x) {
+			std::uint64_t hash = (std::uint64_t) x * 11400714819323198485ull;
+			return (std::size_t)(hash ^ (hash >> 32));
+		};
+
+		// Fill in the counters with the line ...
 		for (offset_t i = 0; i < line.size(); ++i) {
-			std::string token = line.getTokenAsString(i);
+			const char_t *token = line.getTokenCStr(i);
+			offset_t length = line.getTokenLength(i);
 			if (mTokenComparator.numeric()) {
-				// Try to process the token as a number first ...
+				// Try to process the token as a number first (NaN cannot be matched by value, so it remains string)...
+				numeric_t number(token, length);
 				long int ival;
-				double dval;
-				if (try_get_int(token, ival)) {
-					intTokens[ival] += D;
-				} else if (try_get_double(token, dval)) {
-					if (tryFloat2Int(dval, ival)) { // check whether it is not integer after all ...
-						intTokens[ival] += D;
+				if (number.isInt()) {
+					intTokens.add(number.intValue(), intHash(number.intValue()), D, intsEqual);
+					continue;
+				} else if (number.isFloat() && !std::isnan(number.floatValue())) {
+					if (tryFloat2Int(number.floatValue(), ival)) { // check whether it is not integer after all ...
+						intTokens.add(ival, intHash(ival), D, intsEqual);
 					} else {
-						handleDoubles(dval);
+						handleDoubles(number.floatValue());
 					}
-				} else {
-					// If everything fails, it is a string token ...
-					stringTokens[token] += D;
+					continue;
 				}
-			} else {
-				// Regular string tokens only.
-				stringTokens[token] += D;
 			}
+
+			// Regular string tokens (or numeric tokens when everything fails) ...
+			StringKey key = {token, length};
+			stringTokens.add(key, mTokenComparator.hash(token, length), D, stringsEqual);
 		}
 	}
 
@@ -381,28 +577,47 @@ private:
 	 */
 	template <bool LOGGING = false> result_t compareUnordered(const line_t &line1, const line_t &line2) const
 	{
-		// Token maps hold tokens represented by they type as keys and occurence counters as values.
-		std::map<std::string, int> stringTokens;
-		std::map<long long int, int> intTokens;
-		std::map<double, int> doubleTokens;
-
-		// Fill and cross fill token maps ...
-		fillMaps<1>(line1, stringTokens, intTokens, [&](double dval) { doubleTokens[dval]++; });
-		fillMaps<-1>(line2, stringTokens, intTokens, [&](double dval) {
+		// Token counters hold tokens represented by their type and their occurence counters (correct - result).
+		TokenCounter<StringKey> stringTokens;
+		TokenCounter<long long int> intTokens;
+		std::vector<std::pair<double, int>> doubleTokens; // sorted by values, so the closest ones can be found
+
+		// Fill and cross fill token counters ...
+		fillCounters<1>(
+			line1, stringTokens, intTokens, [&](double dval) { doubleTokens.push_back(std::make_pair(dval, 1)); });
+		sortValues(doubleTokens);
+
+		std::vector<std::pair<double, int>> unmatchedDoubles;
+		fillCounters<-1>(line2, stringTokens, intTokens, [&](double dval) {
 			auto it = findClosest<1>(doubleTokens, dval);
+			if (it == doubleTokens.end()) {
+				// no close value, but the same value may be present in the tokens
+				it = std::lower_bound(doubleTokens.begin(),
+					doubleTokens.end(),
+					dval,
+					[](const std::pair<double, int> &token, double value) { return token.first < value; });
+				if (it != doubleTokens.end() && dval < it->first) it = doubleTokens.end();
+			}
+
 			if (it != doubleTokens.end()) {
 				it->second -= 1;
 			} else {
-				doubleTokens[dval]--;
+				unmatchedDoubles.push_back(std::make_pair(dval, -1));
 			}
 		});
+		doubleTokens.insert(doubleTokens.end(), unmatchedDoubles.begin(), unmatchedDoubles.end());
+		sortValues(doubleTokens);
+
+		// Only ints with non-zero counts are important (they are sorted as their order matters for crossmatching) ...
+		auto intValues = intTokens.template nonZero<long long int>([](long long int x) { return x; });
+		sortValues(intValues);
 
 		// If some tolerance is set, we need to crossmatch ints and doubles ...
-		if (mTokenComparator.floatTolerance() > 0.0 && !doubleTokens.empty() && !intTokens.empty()) {
+		if (mTokenComparator.floatTolerance() > 0.0 && !doubleTokens.empty() && !intValues.empty()) {
 			// Remove zero occurences to optimize searches...
-			mapRemoveEmpty(doubleTokens);
+			removeEmpty(doubleTokens);
 
-			for (auto &&iTok : intTokens) {
+			for (auto &&iTok : intValues) {
 				// Try to match this int with closest double within tolerance
 				while (iTok.second != 0) {
 					// direction (whether we look for result or correct records)
@@ -420,15 +635,22 @@ private:
 			}
 		}
 
-		// Count errors and optionally log them ...
+		// Count errors and optionally log them (strings are converted and sorted only for logging) ...
 		result_t errorCount = 0;
-		checkMapValues<std::string, LOGGING>(stringTokens, errorCount, line2.lineNumber(), true);
+		if (LOGGING) {
+			auto stringValues = stringTokens.template nonZero<std::string>(
+				[](const StringKey &key) { return std::string(key.data, key.length); });
+			sortValues(stringValues);
+			checkValues<std::string, LOGGING>(stringValues, errorCount, line2.lineNumber(), true);
+		} else {
+			errorCount += (result_t) stringTokens.absoluteSum();
+		}
 		if (mTokenComparator.numeric()) {
-			checkMapValues<long long int, LOGGING>(intTokens, errorCount, line2.lineNumber(), false);
-			checkMapValues<double, LOGGING>(doubleTokens, errorCount, line2.lineNumber(), false);
+			checkValues<long long int, LOGGING>(intValues, errorCount, line2.lineNumber(), false);
+			checkValues<double, LOGGING>(doubleTokens, errorCount, line2.lineNumber(), false);
 		}
 		if (LOGGING && errorCount > 0) {
-			bpp::log().error() << "\n"; // all checkMapValues log errors on one line, so let's end it
+			bpp::log().error() << "\n"; // all checkValues log errors on one line, so let's end it
 		}
 
 		return (result_t) errorCount;
@@ -461,14 +683,17 @@ private:
 	 * \param line1 Line to be compared
 	 * \param line2 Line to be compared
 	 * \param comparator Token comparator
+	 * \param prefixLen Length of the common prefix, the suffix must not overlap with it.
 	 * \return Number of tokens which are the same on both lines from the end.
 	 */
-	std::size_t getCommonLineSuffixLength(
-		const line_t &line1, const line_t &line2, TokenComparator<CHAR, OFFSET> &comparator) const
+	std::size_t getCommonLineSuffixLength(const line_t &line1,
+		const line_t &line2,
+		TokenComparator<CHAR, OFFSET> &comparator,
+		std::size_t prefixLen) const
 	{
 		std::size_t idx1 = line1.size() - 1, idx2 = line2.size() - 1;
 		std::size_t len = 0;
-		while (len < line1.size() && len < line2.size() &&
+		while (len + prefixLen < line1.size() && len + prefixLen < line2.size() &&
 			comparator.compare(line1.getTokenCStr(idx1),
 				line1.getTokenLength(idx1),
 				line2.getTokenCStr(idx2),
@@ -606,10 +831,31 @@ private:
 		std::size_t prefixLen = getCommonLinePrefixLength(line1, line2, comparator);
 		if (prefixLen == line1.size() && prefixLen == line2.size()) return 0; // both lines are identical
 
-		std::size_t suffixLen = getCommonLineSuffixLength(line1, line2, comparator);
+		std::size_t suffixLen = getCommonLineSuffixLength(line1, line2, comparator, prefixLen);
 		lineview_t lineView1(line1, prefixLen, line1.size() - prefixLen - suffixLen);
 		lineview_t lineView2(line2, prefixLen, line2.size() - prefixLen - suffixLen);
 
+		// LCS compares every token with many others, so numeric values are parsed in advance. They are kept with
+		// the lines, so a line compared with many others (by LCS of lines) is parsed only once.
+		if (comparator.numeric()) {
+			auto parse = [&comparator](const char_t *t, offset_t len) { return comparator.parseNumber(t, len); };
+			line1.parseNumbers(parse);
+			line2.parseNumbers(parse);
+		}
+		auto tokenComparator = [&comparator](
+								   const lineview_t &line1, std::size_t i1, const lineview_t &line2, std::size_t i2) {
+			if (comparator.numeric()) {
+				return comparator.compare(line1.getTokenCStr(i1),
+					line1.getTokenLength(i1),
+					line1.getTokenNumber(i1),
+					line2.getTokenCStr(i2),
+					line2.getTokenLength(i2),
+					line2.getTokenNumber(i2));
+			}
+			return comparator.compare(
+				line1.getTokenCStr(i1), line1.getTokenLength(i1), line2.getTokenCStr(i2), line2.getTokenLength(i2));
+		};
+
 		if (LOGGING) {
 			bpp::log().error() << "-" << line1.lineNumber() << "/+" << line2.lineNumber() << ":";
 			result_t res;
@@ -620,15 +866,7 @@ private:
 				logApproxErrors(lineView1, lineView2);
 			} else {
 				std::vector<std::pair<std::size_t, std::size_t>> lcs;
-				bpp::longest_common_subsequence(lineView1,
-					lineView2,
-					lcs,
-					[&comparator](const lineview_t &line1, std::size_t i1, const lineview_t &line2, std::size_t i2) {
-						return comparator.compare(line1.getTokenCStr(i1),
-							line1.getTokenLength(i1),
-							line2.getTokenCStr(i2),
-							line2.getTokenLength(i2));
-					});
+				bpp::longest_common_subsequence(lineView1, lineView2, lcs, tokenComparator);
 
 				// If there are no errors, return immediately.
 				res = (result_t)(lineView1.size() - lcs.size() + lineView2.size() - lcs.size());
@@ -651,25 +889,21 @@ private:
 			bpp::log().error() << "\n";
 			return res;
 		} else {
-			std::size_t lcs =
-				(mApproxLcsMaxWindow > 0 && std::min(lineView1.size(), lineView2.size()) > mApproxLcsMaxWindow) ?
-				bpp::longest_common_subsequence_approx_length(lineView1,
+			std::size_t lcs;
+			if (mApproxLcsMaxWindow > 0 && std::min(lineView1.size(), lineView2.size()) > mApproxLcsMaxWindow) {
+				lcs = bpp::longest_common_subsequence_approx_length(
+					lineView1, lineView2, tokenComparator, mApproxLcsMaxWindow);
+			} else if (!comparator.numeric() && lineView1.size() * lineView2.size() >= BITPARALLEL_LCS_MIN_CELLS) {
+				// Numeric comparison with tolerance is not an equivalence, so only plain tokens can be hashed.
+				lcs = bpp::longest_common_subsequence_length_bitparallel(lineView1,
 					lineView2,
-					[&comparator](const lineview_t &line1, std::size_t i1, const lineview_t &line2, std::size_t i2) {
-						return comparator.compare(line1.getTokenCStr(i1),
-							line1.getTokenLength(i1),
-							line2.getTokenCStr(i2),
-							line2.getTokenLength(i2));
+					[&comparator](const lineview_t &line, std::size_t i) {
+						return comparator.hash(line.getTokenCStr(i), line.getTokenLength(i));
 					},
-					mApproxLcsMaxWindow) :
-				bpp::longest_common_subsequence_length(lineView1,
-					lineView2,
-					[&comparator](const lineview_t &line1, std::size_t i1, const lineview_t &line2, std::size_t i2) {
-						return comparator.compare(line1.getTokenCStr(i1),
-							line1.getTokenLength(i1),
-							line2.getTokenCStr(i2),
-							line2.getTokenLength(i2));
-					});
+					tokenComparator);
+			} else {
+				lcs = bpp::longest_common_subsequence_length(lineView1, lineView2, tokenComparator);
+			}
 
 			return (result_t)(lineView1.size() - lcs + lineView2.size() - lcs);
 		}
@@ -692,6 +926,111 @@ public:
 	}
 
 
+	/**
+	 * Compute fingerprint (hash) of a line. Lines with the same tokens (in any order if tokens are shuffled) have
+	 * the same fingerprint. If numeric comparisons are on, numeric tokens are represented by their values, so
+	 * differently formatted numbers (e.g., 0 and 0.0) do not change the fingerprint, but lines matched only thanks
+	 * to float tolerance may have different ones.
+	 * \param line The line to be processed.
+	 * \param matchable Set to false if the line cannot match any line (NaNs or infinities in ordered tokens).
+	 * \return The fingerprint value.
+	 */
+	std::size_t fingerprint(const line_t &line, bool &matchable) const
+	{
+		std::uint64_t fingerprint = (std::uint64_t) line.size();
+		matchable = true;
+		for (std::size_t i = 0; i < line.size(); ++i) {
+			const char_t *token = line.getTokenCStr(i);
+			offset_t length = line.getTokenLength(i);
+
+			double value;
+			std::uint64_t hash;
+			if (mTokenComparator.numeric() && numericValue(token, length, value) > 0) {
+				if (!mShuffledTokens && !std::isfinite(value)) matchable = false;
+				hash = valueHash(value);
+			} else {
+				hash = (std::uint64_t) mTokenComparator.hash(token, length);
+			}
+			fingerprint = combineFingerprint(fingerprint, hash);
+		}
+		return (std::size_t) fingerprint;
+	}
+
+
+	/**
+	 * Compute fingerprint of a line in which all numeric tokens are replaced by the same placeholder, so lines
+	 * matched thanks to numeric comparison have the same text fingerprint. Lines are also given numeric keys,
+	 * the keys of matching lines at the same index differ at most by TokenComparator::floatMatchRadius() of any
+	 * of them. If tokens are ordered, the keys are the values of the numeric tokens. If tokens are shuffled,
+	 * the keys are the smallest and the largest value (values of two sets matched pairwise are bounded as well).
+	 * Infinities are matched only by the same value if tokens are shuffled, so they are a part of the text
+	 * fingerprint (rather than the keys). Lines with NaNs or infinities in ordered tokens never match.
+	 * \param line The line to be processed.
+	 * \param keys Vector where the keys are stored, NaN is used where a value does not determine matching
+	 *        (saturated integers and NaNs or infinities in lines which never match).
+	 * \param matchable Set to false if the line cannot match any line.
+	 * \return The fingerprint value.
+	 */
+	std::size_t textFingerprint(const line_t &line, std::vector<double> &keys, bool &matchable) const
+	{
+		const double none = std::numeric_limits<double>::quiet_NaN();
+		double smallest = std::numeric_limits<double>::infinity(), largest = -smallest;
+		bool bounded = true, anyNumber = false;
+		keys.clear();
+		matchable = true;
+
+		std::uint64_t fingerprint = (std::uint64_t) line.size();
+		for (std::size_t i = 0; i < line.size(); ++i) {
+			const char_t *token = line.getTokenCStr(i);
+			offset_t length = line.getTokenLength(i);
+
+			double value;
+			int numeric = mTokenComparator.numeric() ? numericValue(token, length, value) : 0;
+			if (numeric == 0) {
+				fingerprint = combineFingerprint(fingerprint, (std::uint64_t) mTokenComparator.hash(token, length));
+				continue;
+			}
+
+			fingerprint = combineFingerprint(fingerprint, 0x9e3779b97f4a7c15ull);
+			if (numeric > 0 && !std::isfinite(value)) {
+				if (mShuffledTokens) {
+					fingerprint = combineFingerprint(fingerprint, valueHash(value));
+					continue;
+				}
+				matchable = false;
+				value = none;
+			} else if (numeric < 0) {
+				anyNumber = true;
+				bounded = false;
+				value = none;
+			} else {
+				anyNumber = true;
+				smallest = std::min(smallest, value);
+				largest = std::max(largest, value);
+			}
+			if (!mShuffledTokens) keys.push_back(value);
+		}
+
+		if (mShuffledTokens && anyNumber) {
+			keys.push_back(bounded ? smallest : none);
+			keys.push_back(bounded ? largest : none);
+		}
+		return (std::size_t) fingerprint;
+	}
+
+
+	bool numeric() const
+	{
+		return mTokenComparator.numeric();
+	}
+
+
+	double floatMatchRadius(double value) const
+	{
+		return mTokenComparator.floatMatchRadius(value);
+	}
+
+
 	/**
 	 * Compare the lines and log all the mismatched tokens to global log.
 	 * \return Zero if the lines match completely, number of mismatched tokens otherwise.
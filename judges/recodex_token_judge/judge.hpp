@@ -8,6 +8,10 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <cmath>
 #include <cstddef>
 
 
@@ -436,13 +440,273 @@ private:
 	}
 
 
+	/**
+	 * Read all remaining lines of a file.
+	 * \param reader Reader of the file.
+	 * \param lines Vector where the lines are appended.
+	 */
+	static void readAllLines(reader_t &reader, std::vector<std::unique_ptr<line_t>> &lines)
+	{
+		while (!reader.eof()) {
+			auto line = reader.readLine();
+			if (line) lines.push_back(std::move(line));
+		}
+	}
+
+
+	/**
+	 * Pair lines with the same fingerprint (fingerprints only select candidates, pairs are verified by comparator).
+	 * \param correctLines All lines of the correct file.
+	 * \param resultLines All lines of the result file.
+	 * \param correctMatched Flags of correct lines which have been matched (updated).
+	 * \param resultMatched Flags of result lines which have been matched (updated).
+	 */
+	void matchLinesByFingerprints(const std::vector<std::unique_ptr<line_t>> &correctLines,
+		const std::vector<std::unique_ptr<line_t>> &resultLines,
+		std::vector<bool> &correctMatched,
+		std::vector<bool> &resultMatched)
+	{
+		// Pairs (fingerprint, line index) sorted by fingerprints, so equal fingerprints form continuous groups.
+		// Lines which cannot match any line are left out.
+		std::vector<std::pair<std::size_t, std::size_t>> correct, result;
+		bool matchable;
+		for (std::size_t i = 0; i < correctLines.size(); ++i) {
+			std::size_t fingerprint = mLineComparator.fingerprint(*correctLines[i].get(), matchable);
+			if (matchable) correct.push_back(std::make_pair(fingerprint, i));
+		}
+		for (std::size_t i = 0; i < resultLines.size(); ++i) {
+			std::size_t fingerprint = mLineComparator.fingerprint(*resultLines[i].get(), matchable);
+			if (matchable) result.push_back(std::make_pair(fingerprint, i));
+		}
+		std::sort(correct.begin(), correct.end());
+		std::sort(result.begin(), result.end());
+
+		std::size_t c = 0;
+		for (std::size_t r = 0; r < result.size(); ++r) {
+			while (c < correct.size() && correct[c].first < result[r].first) ++c;
+
+			// Find an unmatched correct line in the group with the same fingerprint...
+			// (the matched lines at the beginning of the group are skipped permanently)
+			while (c < correct.size() && correct[c].first == result[r].first && correctMatched[correct[c].second]) ++c;
+			for (std::size_t i = c; i < correct.size() && correct[i].first == result[r].first; ++i) {
+				std::size_t ci = correct[i].second, ri = result[r].second;
+				if (!correctMatched[ci] &&
+					mLineComparator.compare(*correctLines[ci].get(), *resultLines[ri].get()) == 0) {
+					correctMatched[ci] = resultMatched[ri] = true;
+					break;
+				}
+			}
+		}
+	}
+
+
+	/**
+	 * Pair remaining lines using the comparator (e.g., lines which match thanks to float tolerance).
+	 * Without numeric comparison, matching lines have the same fingerprints, so they are already paired. Otherwise,
+	 * only lines with the same text fingerprint (which includes the number of tokens) are compared. Within each such
+	 * group, correct lines are sorted by the numeric key which tells them apart best and only the lines whose keys
+	 * are close enough (see LineComparator::textFingerprint()) are compared.
+	 * \param correctLines All lines of the correct file.
+	 * \param resultLines All lines of the result file.
+	 * \param correctMatched Flags of correct lines which have been matched (updated).
+	 * \param resultMatched Flags of result lines which have been matched (updated).
+	 */
+	void matchRemainingLines(const std::vector<std::unique_ptr<line_t>> &correctLines,
+		const std::vector<std::unique_ptr<line_t>> &resultLines,
+		std::vector<bool> &correctMatched,
+		std::vector<bool> &resultMatched)
+	{
+		if (!mLineComparator.numeric()) return;
+
+		// Unmatched correct lines with their numeric keys (stored in one vector).
+		struct Candidate {
+			std::size_t text;
+			double number; ///< Sorting key within the group (lines without it go first).
+			std::size_t keys;
+			std::size_t keyCount;
+			std::size_t index;
+		};
+		const double none = -std::numeric_limits<double>::infinity();
+		std::vector<Candidate> correct;
+		std::vector<double> keys, lineKeys;
+		bool matchable;
+		for (std::size_t i = 0; i < correctLines.size(); ++i) {
+			if (correctMatched[i]) continue;
+			std::size_t text = mLineComparator.textFingerprint(*correctLines[i].get(), lineKeys, matchable);
+			if (!matchable) continue;
+			correct.push_back({text, none, keys.size(), lineKeys.size(), i});
+			keys.insert(keys.end(), lineKeys.begin(), lineKeys.end());
+		}
+		std::sort(correct.begin(), correct.end(), [](const Candidate &c1, const Candidate &c2) {
+			return c1.text != c2.text ? c1.text < c2.text : c1.index < c2.index;
+		});
+
+		// Groups of candidates with the same text fingerprint, each sorted by its most distinctive key.
+		struct Group {
+			std::size_t text;
+			std::size_t begin;
+			std::size_t end;
+			std::size_t key;
+		};
+		std::vector<Group> groups;
+		std::vector<double> values;
+		for (std::size_t begin = 0, end; begin < correct.size(); begin = end) {
+			end = begin + 1;
+			while (end < correct.size() && correct[end].text == correct[begin].text) ++end;
+
+			std::size_t keyCount = correct[begin].keyCount, bestKey = keyCount, bestDistinct = 0;
+			for (std::size_t k = 0; k < keyCount; ++k) {
+				values.clear();
+				for (std::size_t i = begin; i < end; ++i) {
+					if (correct[i].keyCount != keyCount) continue; // hash collision
+					double value = keys[correct[i].keys + k];
+					if (!std::isnan(value)) values.push_back(value);
+				}
+				std::sort(values.begin(), values.end());
+				std::size_t distinct = std::unique(values.begin(), values.end()) - values.begin();
+				if (distinct > bestDistinct) {
+					bestKey = k;
+					bestDistinct = distinct;
+				}
+			}
+
+			if (bestKey < keyCount) {
+				for (std::size_t i = begin; i < end; ++i) {
+					double value = correct[i].keyCount == keyCount ? keys[correct[i].keys + bestKey] : none;
+					correct[i].number = std::isnan(value) ? none : value;
+				}
+				std::stable_sort(correct.begin() + begin,
+					correct.begin() + end,
+					[](const Candidate &c1, const Candidate &c2) { return c1.number < c2.number; });
+			}
+			groups.push_back({correct[begin].text, begin, end, bestKey});
+		}
+
+		// Matched candidates are skipped by following links to the next (possibly) unmatched candidate in either
+		// direction (links to previous candidates are shifted by one, zero is the sentinel).
+		std::vector<std::size_t> next(correct.size() + 1), previous(correct.size() + 1);
+		for (std::size_t i = 0; i < next.size(); ++i) next[i] = previous[i] = i;
+		auto skipMatched = [](std::vector<std::size_t> &links, std::size_t i) {
+			while (links[i] != i) {
+				links[i] = links[links[i]];
+				i = links[i];
+			}
+			return i;
+		};
+
+		// Keys of matching lines are close, so the comparison may be skipped when they are not.
+		auto keysMatch = [&](const Candidate &candidate) {
+			if (candidate.keyCount != lineKeys.size()) return true;
+			for (std::size_t k = 0; k < lineKeys.size(); ++k) {
+				double value = keys[candidate.keys + k];
+				if (!std::isnan(value) && !std::isnan(lineKeys[k]) &&
+					std::abs(value - lineKeys[k]) > mLineComparator.floatMatchRadius(lineKeys[k])) {
+					return false;
+				}
+			}
+			return true;
+		};
+
+		auto tryCandidate = [&](std::size_t r, std::size_t i) {
+			if (!keysMatch(correct[i]) ||
+				mLineComparator.compare(*correctLines[correct[i].index].get(), *resultLines[r].get()) != 0) {
+				return false;
+			}
+			correctMatched[correct[i].index] = resultMatched[r] = true;
+			next[i] = i + 1;
+			previous[i + 1] = i;
+			return true;
+		};
+
+		auto tryCandidates = [&](std::size_t r, std::size_t from, std::size_t to, double maxNumber) {
+			for (std::size_t i = skipMatched(next, from); i < to && correct[i].number <= maxNumber;) {
+				if (tryCandidate(r, i)) return true;
+				i = skipMatched(next, i + 1);
+			}
+			return false;
+		};
+
+		// Candidates are tried from the closest key outwards, so a line is not paired with a neighbour of its
+		// counterpart (which would leave lines unpaired when the tolerance is larger than the distance of lines).
+		auto tryNearestCandidates = [&](std::size_t r, std::size_t from, std::size_t to, double number) {
+			double radius = mLineComparator.floatMatchRadius(number);
+			auto closest = std::lower_bound(correct.begin() + from,
+				correct.begin() + to,
+				number,
+				[](const Candidate &c, double number) { return c.number < number; });
+			std::size_t middle = closest - correct.begin();
+			std::size_t right = skipMatched(next, middle), left = skipMatched(previous, middle);
+			while (true) {
+				bool rightOk = right < to && correct[right].number - number <= radius;
+				bool leftOk = left > from && number - correct[left - 1].number <= radius;
+				if (rightOk && (!leftOk || correct[right].number - number <= number - correct[left - 1].number)) {
+					if (tryCandidate(r, right)) return true;
+					right = skipMatched(next, right + 1);
+				} else if (leftOk) {
+					if (tryCandidate(r, left - 1)) return true;
+					left = skipMatched(previous, left - 1);
+				} else {
+					return false;
+				}
+			}
+		};
+
+		const double infinity = std::numeric_limits<double>::infinity();
+		for (std::size_t r = 0; r < resultLines.size(); ++r) {
+			if (resultMatched[r]) continue;
+			std::size_t text = mLineComparator.textFingerprint(*resultLines[r].get(), lineKeys, matchable);
+			if (!matchable) continue;
+
+			auto group = std::lower_bound(groups.begin(), groups.end(), text, [](const Group &g, std::size_t text) {
+				return g.text < text;
+			});
+			if (group == groups.end() || group->text != text) continue;
+
+			if (group->key >= lineKeys.size() || std::isnan(lineKeys[group->key])) {
+				tryCandidates(r, group->begin, group->end, infinity);
+				continue;
+			}
+
+			// Candidates without the key first, then the ones with close enough keys.
+			double number = lineKeys[group->key];
+			if (tryCandidates(r, group->begin, group->end, none)) continue;
+			tryNearestCandidates(r, group->begin, group->end, number);
+		}
+	}
+
+
 	/**
 	 * Compare both files without any regards to line ordering.
+	 * Lines with the same fingerprints are paired first, the comparator is used on the remaining lines only.
 	 * \return True if both files match, false if errors were found.
 	 */
 	bool compareUnordered()
 	{
-		throw bpp::RuntimeError("Not implemented yet.");
+		std::vector<std::unique_ptr<line_t>> correctLines, resultLines;
+		readAllLines(mCorrectReader, correctLines);
+		readAllLines(mResultReader, resultLines);
+
+		std::vector<bool> correctMatched(correctLines.size(), false);
+		std::vector<bool> resultMatched(resultLines.size(), false);
+		matchLinesByFingerprints(correctLines, resultLines, correctMatched, resultMatched);
+		matchRemainingLines(correctLines, resultLines, correctMatched, resultMatched);
+
+		// Log lines which were not paired ...
+		bool allMatched = true;
+		for (std::size_t i = 0; i < correctLines.size(); ++i) {
+			if (correctMatched[i]) continue;
+			allMatched = false;
+			if (bpp::log().isFull(bpp::LogSeverity::ERROR)) break;
+			logImpairedCorrectLine(*correctLines[i].get());
+		}
+		for (std::size_t i = 0; i < resultLines.size(); ++i) {
+			if (resultMatched[i]) continue;
+			allMatched = false;
+			if (bpp::log().isFull(bpp::LogSeverity::ERROR)) break;
+			logImpairedResultLine(*resultLines[i].get());
+		}
+
+		return allMatched;
 	}
 
 public:
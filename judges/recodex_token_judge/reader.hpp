@@ -10,9 +10,18 @@
 #include <vector>
 #include <limits>
 #include <cstdint>
-#include <cctype>
+#include <cstdlib>
+#include <cstring>
 #include <cstddef>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RECODEX_TOKEN_JUDGE_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 
 /**
  * Reader is a wrapper that mmaps file for reading and provide parsing function.
@@ -66,6 +75,128 @@ public:
 	};
 
 
+	/**
+	 * Numeric value of a token. The token is parsed once, so it can be compared many times (e.g., by LCS).
+	 */
+	class NumericToken
+	{
+	private:
+		bool mIsInt; ///< Whether the token is an integer (as parsed by strtol).
+		bool mIsFloat; ///< Whether the token is a float (as parsed by strtod), integers are floats as well.
+		long int mIntValue;
+		double mFloatValue;
+
+	public:
+		NumericToken() : mIsInt(false), mIsFloat(false), mIntValue(0), mFloatValue(0.0)
+		{
+		}
+
+		/**
+		 * Parse the token.
+		 * \param t Pointer to the raw data representing the token (not null-terminated).
+		 * \param len Number of characters of the token.
+		 */
+		NumericToken(const char_t *t, offset_t len) : NumericToken()
+		{
+			if (len == 0) return;
+			mIsInt = tryGetInt(t, len);
+			if (mIsInt) {
+				// Saturated values are parsed again, so they get the same float value as strtod would give.
+				bool saturated = mIntValue == std::numeric_limits<long int>::max() ||
+					mIntValue == std::numeric_limits<long int>::min();
+				mIsFloat = true;
+				mFloatValue = saturated ? parseFloat(t, len, mIsFloat) : (double) mIntValue;
+			} else {
+				mFloatValue = parseFloat(t, len, mIsFloat);
+			}
+		}
+
+		bool isInt() const
+		{
+			return mIsInt;
+		}
+
+		bool isFloat() const
+		{
+			return mIsFloat;
+		}
+
+		long int intValue() const
+		{
+			return mIntValue;
+		}
+
+		double floatValue() const
+		{
+			return mFloatValue;
+		}
+
+	private:
+		/**
+		 * Parse decimal integer directly from the token data. Behaves like strtol applied on the whole token
+		 * (including saturation of values out of range).
+		 */
+		bool tryGetInt(const char_t *t, offset_t len)
+		{
+			bool negative = t[0] == (char_t) '-';
+			offset_t i = (negative || t[0] == (char_t) '+') ? 1 : 0;
+			if (i == len) return false;
+
+			const unsigned long int limit =
+				(unsigned long int) std::numeric_limits<long int>::max() + (negative ? 1 : 0);
+			unsigned long int value = 0;
+			bool overflow = false;
+			for (; i < len; ++i) {
+				if (t[i] < (char_t) '0' || t[i] > (char_t) '9') return false;
+				unsigned long int digit = (unsigned long int)(t[i] - (char_t) '0');
+				if (value > (limit - digit) / 10) {
+					overflow = true;
+				} else {
+					value = value * 10 + digit;
+				}
+			}
+
+			if (overflow) {
+				mIntValue = negative ? std::numeric_limits<long int>::min() : std::numeric_limits<long int>::max();
+			} else {
+				mIntValue = negative ? (long int)(0 - value) : (long int) value;
+			}
+			return true;
+		}
+
+		/**
+		 * Parse float from the token using strtod on a copy of the token on stack (no allocation is needed
+		 * unless the token is very long). Tokens which cannot start a float are rejected without calling strtod.
+		 */
+		static double parseFloat(const char_t *t, offset_t len, bool &ok)
+		{
+			ok = false;
+			offset_t first = (t[0] == (char_t) '-' || t[0] == (char_t) '+') ? 1 : 0;
+			if (first == len) return 0.0;
+			char_t c = t[first];
+			if (!((c >= (char_t) '0' && c <= (char_t) '9') || c == (char_t) '.' || c == (char_t) 'i' ||
+					c == (char_t) 'I' || c == (char_t) 'n' || c == (char_t) 'N')) {
+				return 0.0;
+			}
+
+			char stackBuf[32];
+			std::string heapBuf;
+			char *buf = stackBuf;
+			if (len >= sizeof(stackBuf)) {
+				heapBuf.resize(len + 1);
+				buf = &heapBuf[0];
+			}
+			for (offset_t i = 0; i < len; ++i) buf[i] = (char) t[i];
+			buf[len] = 0;
+
+			char *end;
+			double res = std::strtod(buf, &end);
+			ok = end == buf + len;
+			return res;
+		}
+	};
+
+
 	/**
 	 * Wrapper representing one parsed line of tokens.
 	 * Provide various accessors to token data.
@@ -80,10 +211,13 @@ public:
 		std::vector<TokenRef> mTokens;
 		const char_t *mRawData;
 		offset_t mRawLength;
+		mutable std::vector<NumericToken> mNumbers; ///< Numeric values of the tokens (parsed by parseNumbers()).
+		mutable bool mNumbersParsed;
 
 	public:
 		Line(Reader<CHAR, OFFSET> &reader, offset_t lineNumber, const char_t *rawData, offset_t rawLength = 0)
-			: mReader(reader), mLineNumber(lineNumber), mRawData(rawData), mRawLength(rawLength)
+			: mReader(reader), mLineNumber(lineNumber), mRawData(rawData), mRawLength(rawLength),
+			  mNumbersParsed(false)
 		{
 		}
 
@@ -166,6 +300,31 @@ public:
 		{
 			return std::string(getTokenCStr(idx), getTokenLength(idx));
 		}
+
+
+		/**
+		 * Parse numeric values of all tokens, unless they have been parsed already. The values are kept with
+		 * the line, so a line compared with many others (e.g., by LCS of lines) is parsed only once.
+		 * \param parse Function which parses a token (raw data and length) to NumericToken.
+		 */
+		template <typename FNC> void parseNumbers(const FNC &parse) const
+		{
+			if (mNumbersParsed) return;
+			mNumbers.reserve(size());
+			for (std::size_t i = 0; i < size(); ++i) {
+				mNumbers.push_back(parse(getTokenCStr(i), getTokenLength(i)));
+			}
+			mNumbersParsed = true;
+		}
+
+
+		/**
+		 * Get numeric value of a token with given index (parseNumbers() must be called first).
+		 */
+		const NumericToken &getTokenNumber(std::size_t idx) const
+		{
+			return mNumbers[idx];
+		}
 	};
 
 	class LineView
@@ -212,6 +371,14 @@ public:
 			return mLine.getTokenAsString(idx + mOffset);
 		}
 
+		/**
+		 * Get numeric value of a token with given index (numbers of the line must be parsed first).
+		 */
+		const NumericToken &getTokenNumber(std::size_t idx) const
+		{
+			return mLine.getTokenNumber(idx + mOffset);
+		}
+
 		/**
 		 * Returns the number of tokens on the line.
 		 */
@@ -236,12 +403,83 @@ private:
 	offset_t mLineOffset; ///< Offset of the beginning of current line.
 
 
+	/**
+	 * Whether given character is a whitespace. The set is the same as the one of std::isspace in default "C" locale,
+	 * but the test does not depend on current locale and it can be inlined.
+	 */
+	static bool isWhitespace(char_t c)
+	{
+		return c == (char_t) ' ' || (c >= (char_t) '\t' && c <= (char_t) '\r');
+	}
+
+
+#ifdef RECODEX_TOKEN_JUDGE_SSE2
+	/**
+	 * Index of the lowest set bit of a non-zero mask.
+	 */
+	static unsigned lowestBit(unsigned mask)
+	{
+#ifdef _MSC_VER
+		unsigned long idx;
+		_BitScanForward(&idx, mask);
+		return (unsigned) idx;
+#else
+		return (unsigned) __builtin_ctz(mask);
+#endif
+	}
+
+
+	/**
+	 * Compute 16-bit masks of whitespace and newline characters in a block of 16 characters (1 bit per char).
+	 */
+	static void blockMasks(const char_t *data, unsigned &whitespace, unsigned &newlines)
+	{
+		const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+		// '\t' .. '\r' are shifted to 0 .. 4, everything else (including chars bellow '\t') is above 4 as unsigned
+		const __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+		const __m128i controls = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+		const __m128i spaces = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+		whitespace = (unsigned) _mm_movemask_epi8(_mm_or_si128(controls, spaces));
+		newlines = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')));
+	}
+#endif
+
+
+	/**
+	 * Find the first character from given offset, which terminates a sequence of whitespace (any non-whitespace or
+	 * newline char) or a token (any whitespace char) respectively.
+	 * \tparam TOKEN Whether a token is skipped (otherwise, whitespace without newlines are skipped).
+	 * \return Offset of the terminating character or the length of the data if no such character exists.
+	 */
+	template <bool TOKEN> offset_t scan(offset_t offset) const
+	{
+#ifdef RECODEX_TOKEN_JUDGE_SSE2
+		// Whole blocks are tested by SSE2 instructions (they never reach beyond the end of the data).
+		if (sizeof(char_t) == 1) {
+			while (offset < mLength && mLength - offset >= 16) {
+				unsigned whitespace, newlines;
+				blockMasks(mData + offset, whitespace, newlines);
+				unsigned stops = TOKEN ? whitespace : ((~whitespace & 0xffff) | newlines);
+				if (stops != 0) return offset + (offset_t) lowestBit(stops);
+				offset += 16;
+			}
+		}
+#endif
+		// Scalar fallback for the remaining characters.
+		while (offset < mLength && (TOKEN ? !isWhitespace(mData[offset])
+										  : (isWhitespace(mData[offset]) && mData[offset] != (char_t) '\n'))) {
+			++offset;
+		}
+		return offset;
+	}
+
+
 	/**
 	 * Whether the end of line has been reached.
 	 */
 	bool eol()
 	{
-		return !eof() && mData[mOffset] == (char) '\n';
+		return !eof() && mData[mOffset] == (char_t) '\n';
 	}
 
 
@@ -250,7 +488,7 @@ private:
 	 */
 	void skipWhitespace()
 	{
-		while (!eof() && !eol() && std::isspace((char) mData[mOffset])) ++mOffset;
+		mOffset = scan<false>(mOffset);
 	}
 
 
@@ -259,7 +497,7 @@ private:
 	 */
 	void skipToken()
 	{
-		while (!eof() && !std::isspace((char) mData[mOffset])) ++mOffset;
+		mOffset = scan<true>(mOffset);
 	}
 
 
@@ -268,7 +506,12 @@ private:
 	 */
 	void skipRestOfLine()
 	{
-		while (!eof() && !eol()) ++mOffset;
+		if (sizeof(char_t) == 1 && !eof()) {
+			const void *newline = std::memchr(mData + mOffset, '\n', mLength - mOffset);
+			mOffset = newline != nullptr ? (offset_t)((const char_t *) newline - mData) : mLength;
+		} else {
+			while (!eof() && !eol()) ++mOffset;
+		}
 		if (!eof()) ++mOffset; // skip newline char
 		++mLineNumber;
 		mLineOffset = mOffset;
@@ -289,7 +532,7 @@ private:
 	 */
 	bool isTokenStart()
 	{
-		return !eof() && !std::isspace((char) mData[mOffset]) && (!mAllowComments || mData[mOffset] != (char_t) '#');
+		return !eof() && !isWhitespace(mData[mOffset]) && (!mAllowComments || mData[mOffset] != (char_t) '#');
 	}
 
 
@@ -332,7 +575,7 @@ public:
 
 		if (mIgnoreTrailingWhitespace) {
 			// Reduce the file length to ignore all whitespace at the end ...
-			while (mLength > 0 && std::isspace(mData[mLength - 1])) { --mLength; }
+			while (mLength > 0 && isWhitespace(mData[mLength - 1])) { --mLength; }
 		}
 	}
 
@@ -0,0 +1,15 @@
+#!/usr/bin/env bats
+
+load bats-shared
+
+@test "exact lcs on long lines" {
+	run $EXE_FILE --token-lcs-approx-max-window 0 $CORRECT_FILE $CORRECT_FILE
+	[ "$status" -eq 0 ]
+	[ "${lines[0]}" -eq 1 ]
+}
+
+@test "exact lcs on long lines (negative test)" {
+	run $EXE_FILE --token-lcs-approx-max-window 0 $CORRECT_FILE $RESULT_FILE
+	[ "$status" -eq 1 ]
+	echo "$output" | diff -abB - $ERROR_FILE
+}
@@ -0,0 +1,9 @@
+#!/usr/bin/env bats
+
+load bats-shared
+
+@test "numeric tokens matched by lcs" {
+	run $EXE_FILE --numeric --token-lcs-approx-max-window 0 $CORRECT_FILE $RESULT_FILE
+	[ "$status" -eq 1 ]
+	echo "$output" | diff -abB - $ERROR_FILE
+}
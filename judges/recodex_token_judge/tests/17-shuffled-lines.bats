@@ -0,0 +1,15 @@
+#!/usr/bin/env bats
+
+load bats-shared
+
+@test "shuffled lines" {
+	run $EXE_FILE --shuffled-lines --numeric $CORRECT_FILE $CORRECT_FILE
+	[ "$status" -eq 0 ]
+	[ "${lines[0]}" -eq 1 ]
+}
+
+@test "shuffled lines (negative test)" {
+	run $EXE_FILE --shuffled-lines --numeric $CORRECT_FILE $RESULT_FILE
+	[ "$status" -eq 1 ]
+	echo "$output" | diff -abB - $ERROR_FILE
+}
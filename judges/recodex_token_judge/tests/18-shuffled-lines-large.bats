@@ -0,0 +1,34 @@
+#!/usr/bin/env bats
+
+load bats-shared
+
+# Large inputs are generated, lines are reversed and formatted differently, so they are compared numerically.
+setup() {
+	LARGE_CORRECT_FILE=$BATS_TMPDIR/18.correct.in
+	LARGE_RESULT_FILE=$BATS_TMPDIR/18.result.in
+	LARGE_WRONG_FILE=$BATS_TMPDIR/18.wrong.in
+	awk 'BEGIN { for (i = 0; i < 20000; ++i) print i, "value", (i * 7) % 1000 + 0.5 }' > $LARGE_CORRECT_FILE
+	awk 'BEGIN { for (i = 19999; i >= 0; --i) print i ".0", "value", (i * 7) % 1000 + 0.5001 }' > $LARGE_RESULT_FILE
+	awk 'BEGIN { for (i = 19999; i >= 0; --i) print i ".0", "value", (i * 7) % 1000 + (i % 10 ? 0.25 : 0.5) }' \
+		> $LARGE_WRONG_FILE
+}
+
+teardown() {
+	rm -f $LARGE_CORRECT_FILE $LARGE_RESULT_FILE $LARGE_WRONG_FILE
+}
+
+@test "shuffled lines with large mostly wrong output" {
+	start=$SECONDS
+	run $EXE_FILE --shuffled-lines --numeric --log-limit 1000 $LARGE_CORRECT_FILE $LARGE_WRONG_FILE
+	[ "$status" -eq 1 ]
+	[ "${lines[0]}" -eq 0 ]
+	[ $((SECONDS - start)) -lt 10 ]
+}
+
+@test "shuffled lines with large output matched numerically" {
+	start=$SECONDS
+	run $EXE_FILE --shuffled-lines --numeric --float-tolerance 0.001 $LARGE_CORRECT_FILE $LARGE_RESULT_FILE
+	[ "$status" -eq 0 ]
+	[ "${lines[0]}" -eq 1 ]
+	[ $((SECONDS - start)) -lt 10 ]
+}
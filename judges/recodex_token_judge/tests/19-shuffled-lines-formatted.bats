@@ -0,0 +1,31 @@
+#!/usr/bin/env bats
+
+load bats-shared
+
+# Large inputs whose lines differ only in formatting of numbers, so their text fingerprints are all the same.
+setup() {
+	FORMATTED_CORRECT_FILE=$BATS_TMPDIR/19.correct.in
+	FORMATTED_RESULT_FILE=$BATS_TMPDIR/19.result.in
+	awk 'BEGIN { for (i = 0; i < 20000; ++i) print 0, i }' > $FORMATTED_CORRECT_FILE
+	awk 'BEGIN { for (i = 19999; i >= 0; --i) print "0.0", i }' > $FORMATTED_RESULT_FILE
+}
+
+teardown() {
+	rm -f $FORMATTED_CORRECT_FILE $FORMATTED_RESULT_FILE
+}
+
+@test "shuffled lines with large differently formatted output" {
+	start=$SECONDS
+	run $EXE_FILE --shuffled-lines --numeric $FORMATTED_CORRECT_FILE $FORMATTED_RESULT_FILE
+	[ "$status" -eq 0 ]
+	[ "${lines[0]}" -eq 1 ]
+	[ $((SECONDS - start)) -lt 10 ]
+}
+
+@test "shuffled lines with large differently formatted output and tolerance" {
+	start=$SECONDS
+	run $EXE_FILE --shuffled-lines --numeric --float-tolerance 0.0001 $FORMATTED_CORRECT_FILE $FORMATTED_RESULT_FILE
+	[ "$status" -eq 0 ]
+	[ "${lines[0]}" -eq 1 ]
+	[ $((SECONDS - start)) -lt 10 ]
+}
@@ -0,0 +1,32 @@
+#!/usr/bin/env bats
+
+load bats-shared
+
+# Large inputs whose lines hold infinities, they cannot be told apart by their numeric values.
+setup() {
+	INFINITE_CORRECT_FILE=$BATS_TMPDIR/20.correct.in
+	INFINITE_RESULT_FILE=$BATS_TMPDIR/20.result.in
+	awk 'BEGIN { for (i = 0; i < 20000; ++i) print "inf" }' > $INFINITE_CORRECT_FILE
+	awk 'BEGIN { for (i = 0; i < 20000; ++i) print "-inf" }' > $INFINITE_RESULT_FILE
+}
+
+teardown() {
+	rm -f $INFINITE_CORRECT_FILE $INFINITE_RESULT_FILE
+}
+
+@test "shuffled lines with large infinite output" {
+	start=$SECONDS
+	run $EXE_FILE --shuffled-lines --numeric --log-limit 1000 $INFINITE_CORRECT_FILE $INFINITE_RESULT_FILE
+	[ "$status" -eq 1 ]
+	[ "${lines[0]}" -eq 0 ]
+	[ $((SECONDS - start)) -lt 10 ]
+}
+
+@test "shuffled lines and tokens with large infinite output" {
+	start=$SECONDS
+	run $EXE_FILE --shuffled-lines --shuffled-tokens --numeric --log-limit 1000 $INFINITE_CORRECT_FILE \
+		$INFINITE_CORRECT_FILE
+	[ "$status" -eq 0 ]
+	[ "${lines[0]}" -eq 1 ]
+	[ $((SECONDS - start)) -lt 10 ]
+}
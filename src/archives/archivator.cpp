@@ -3,9 +3,24 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <vector>
+#include <cerrno>
+#include <ctime>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-void archivator::compress(const std::string &dir, const std::string &destination)
+
+void archivator::compress(const std::string &dir,
+	const std::string &destination,
+	archive_type format,
+	int level,
+	std::size_t threads,
+	std::shared_ptr<spdlog::logger> logger)
 {
 	std::map<fs::path, fs::path> files;
 	fs::path dir_path;
@@ -14,7 +29,8 @@ void archivator::compress(const std::string &dir, const std::string &destination
 		if (fs::is_directory(dir_path)) {
 			for (auto i = fs::recursive_directory_iterator(dir_path); i != fs::recursive_directory_iterator(); ++i) {
 				fs::path file = *i;
-				if (fs::is_regular_file(file)) {
+				// type of the file is known from the directory listing, it is not stated again
+				if (fs::is_regular_file(i->status())) {
 					// find out where the two paths diverge - boost::filesystem::relative() is too new now to use it
 					fs::path::const_iterator itr_dir = dir_path.begin();
 					fs::path::const_iterator itr_file = file.begin();
@@ -40,49 +56,181 @@ void archivator::compress(const std::string &dir, const std::string &destination
 
 	std::unique_ptr<archive, decltype(&archive_write_free)> a = {archive_write_new(), archive_write_free};
 	if (a == nullptr) { throw archive_exception("Cannot create destination archive."); }
-	if (archive_write_set_format_zip(a.get()) != ARCHIVE_OK) {
-		throw archive_exception("Cannot set ZIP format on destination archive.");
+	if (format == archive_type::ZIP) {
+		if (archive_write_set_format_zip(a.get()) != ARCHIVE_OK) {
+			throw archive_exception("Cannot set ZIP format on destination archive.");
+		}
+	} else {
+		if (archive_write_set_format_pax_restricted(a.get()) != ARCHIVE_OK) {
+			throw archive_exception("Cannot set TAR format on destination archive.");
+		}
+		if (archive_write_add_filter_zstd(a.get()) != ARCHIVE_OK) {
+			throw archive_exception("Cannot set ZSTD compression on destination archive.");
+		}
+		if (level != 0 &&
+			archive_write_set_filter_option(a.get(), "zstd", "compression-level", std::to_string(level).c_str()) !=
+				ARCHIVE_OK) {
+			throw archive_exception("Cannot set compression level " + std::to_string(level) + ".");
+		}
+		// zstd splits the data into jobs compressed by its own threads, entries are still written in order,
+		// older libarchive or external zstd program do not know the option, the archive is then compressed
+		// by one thread
+		if (threads > 1) {
+			auto res = archive_write_set_filter_option(a.get(), "zstd", "threads", std::to_string(threads).c_str());
+			if (res == ARCHIVE_FATAL) {
+				throw archive_exception("Cannot set " + std::to_string(threads) + " compression threads.");
+			}
+			if (res != ARCHIVE_OK && logger != nullptr) {
+				logger->warn("Archive {} is compressed by one thread, {} compression threads are not supported.",
+					destination,
+					threads);
+			}
+		}
 	}
 	if (archive_write_open_filename(a.get(), destination.c_str()) != ARCHIVE_OK) {
 		throw archive_exception("Cannot open destination archive.");
 	}
 
-	for (auto &file : files) {
-		std::unique_ptr<archive_entry, decltype(&archive_entry_free)> entry = {archive_entry_new(), archive_entry_free};
+	// root directory is named as the archive without its suffix
+	std::string root = fs::path(destination).filename().string();
+	std::string suffix = "." + get_format_name(format);
+	if (root.size() > suffix.size() && root.compare(root.size() - suffix.size(), suffix.size(), suffix) == 0) {
+		root.resize(root.size() - suffix.size());
+	} else {
+		root = fs::path(destination).stem().string();
+	}
 
-		archive_entry_set_pathname(entry.get(), (fs::path(destination).stem() / file.second).string().c_str());
-		archive_entry_set_size(entry.get(), fs::file_size(file.first));
-		archive_entry_set_mtime(entry.get(), fs::last_write_time(file.first), 0); // 0 nanoseconds
-		archive_entry_set_filetype(entry.get(), AE_IFREG);
-		archive_entry_set_perm(entry.get(), 0644);
+	for (auto &file : files) { write_file(a.get(), file.first, (fs::path(root) / file.second).string()); }
 
-		int r = archive_write_header(a.get(), entry.get());
-		if (r < ARCHIVE_OK) { throw archive_exception(archive_error_string(a.get())); }
+	if (archive_write_close(a.get()) != ARCHIVE_OK) { throw archive_exception(archive_error_string(a.get())); }
+}
 
-		std::ifstream ifs((file.first).string(), std::ios::in | std::ios::binary);
-		if (ifs.is_open()) {
-			// read data by small blocks to avoid memory overfill on possibly large files
-			char buff[4096];
 
-			while (true) {
-				ifs.read(buff, sizeof(buff));
+archive_type archivator::parse_format(const std::string &name)
+{
+	if (name == "zip") { return archive_type::ZIP; }
+	if (name == "tar.zst") { return archive_type::TAR_ZSTD; }
+	throw archive_exception("Unknown archive format '" + name + "'.");
+}
+
+
+std::string archivator::get_format_name(archive_type format)
+{
+	return format == archive_type::ZIP ? "zip" : "tar.zst";
+}
 
-				auto read_len = ifs.gcount();
-				if (ifs.eof() && read_len == 0) {
-					break;
-				} else if (read_len <= 0) {
-					throw archive_exception("Error reading input file.");
-				}
 
-				r = archive_write_data(a.get(), buff, static_cast<std::size_t>(ifs.gcount()));
-				if (r < ARCHIVE_OK) { throw archive_exception(archive_error_string(a.get())); }
+namespace
+{
+	/** Files are handed over to libarchive by large blocks, so that the compressor is not called too often. */
+	const std::size_t write_block_size = 1 << 20;
+
+#ifndef _WIN32
+	/**
+	 * Regular file opened for reading and mapped to memory, it is unmapped and closed in destructor.
+	 */
+	class mapped_file
+	{
+	public:
+		explicit mapped_file(const fs::path &file)
+		{
+			struct stat info;
+			fd_ = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd_ < 0 || fstat(fd_, &info) != 0) {
+				if (fd_ >= 0) { close(fd_); }
+				throw archive_exception("Cannot open file " + file.string() + " for reading.");
+			}
+			size_ = static_cast<std::size_t>(info.st_size);
+			mtime_ = info.st_mtime;
+
+			if (size_ > 0) {
+				data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+				if (data_ == MAP_FAILED) {
+					close(fd_);
+					throw archive_exception("Cannot map file " + file.string() + " to memory.");
+				}
+				madvise(data_, size_, MADV_SEQUENTIAL);
 			}
-		} else {
-			throw archive_exception("Cannot open file " + (file.first).string() + " for reading.");
 		}
+
+		~mapped_file()
+		{
+			if (size_ > 0) { munmap(data_, size_); }
+			close(fd_);
+		}
+
+		const char *data() const
+		{
+			return static_cast<const char *>(data_);
+		}
+
+		std::size_t size() const
+		{
+			return size_;
+		}
+
+		std::time_t mtime() const
+		{
+			return mtime_;
+		}
+
+	private:
+		int fd_ = -1;
+		void *data_ = nullptr;
+		std::size_t size_ = 0;
+		std::time_t mtime_ = 0;
+	};
+#endif
+} // namespace
+
+
+void archivator::write_file(archive *a, const fs::path &file, const std::string &pathname)
+{
+	std::unique_ptr<archive_entry, decltype(&archive_entry_free)> entry = {archive_entry_new(), archive_entry_free};
+	archive_entry_set_pathname(entry.get(), pathname.c_str());
+	archive_entry_set_filetype(entry.get(), AE_IFREG);
+	archive_entry_set_perm(entry.get(), 0644);
+
+#ifndef _WIN32
+	// file is stated only once and its content is not copied through intermediate buffers
+	mapped_file input(file);
+	archive_entry_set_size(entry.get(), static_cast<la_int64_t>(input.size()));
+	archive_entry_set_mtime(entry.get(), input.mtime(), 0); // 0 nanoseconds
+
+	int r = archive_write_header(a, entry.get());
+	if (r < ARCHIVE_OK) { throw archive_exception(archive_error_string(a)); }
+
+	for (std::size_t offset = 0; offset < input.size();) {
+		auto written = archive_write_data(a, input.data() + offset, std::min(write_block_size, input.size() - offset));
+		if (written <= 0) { throw archive_exception(archive_error_string(a)); }
+		offset += static_cast<std::size_t>(written);
 	}
+#else
+	archive_entry_set_size(entry.get(), fs::file_size(file));
+	archive_entry_set_mtime(entry.get(), fs::last_write_time(file), 0); // 0 nanoseconds
 
-	archive_write_close(a.get());
+	int r = archive_write_header(a, entry.get());
+	if (r < ARCHIVE_OK) { throw archive_exception(archive_error_string(a)); }
+
+	std::ifstream ifs(file.string(), std::ios::in | std::ios::binary);
+	if (!ifs.is_open()) { throw archive_exception("Cannot open file " + file.string() + " for reading."); }
+
+	// read data by blocks to avoid memory overfill on possibly large files
+	std::vector<char> buff(write_block_size);
+	while (true) {
+		ifs.read(buff.data(), buff.size());
+
+		auto read_len = ifs.gcount();
+		if (ifs.eof() && read_len == 0) {
+			break;
+		} else if (read_len <= 0) {
+			throw archive_exception("Error reading input file.");
+		}
+
+		r = archive_write_data(a, buff.data(), static_cast<std::size_t>(read_len));
+		if (r < ARCHIVE_OK) { throw archive_exception(archive_error_string(a)); }
+	}
+#endif
 }
 
 
@@ -95,13 +243,73 @@ void archivator::decompress(const std::string &filename, const std::string &dest
 		throw archive_exception("Source archive '" + filename + "' not exists or is not a regular file.");
 	}
 
-	// Select which attributes we want to restore.
-	int flags;
-	flags = ARCHIVE_EXTRACT_TIME;
-	flags |= ARCHIVE_EXTRACT_FFLAGS;
-	// Don't allow ".." in any path within archive
-	flags |= ARCHIVE_EXTRACT_SECURE_NODOTDOT;
+	auto a = create_reader();
+	int r = archive_read_open_filename(a.get(), filename.c_str(), 10240);
+	if (r < ARCHIVE_OK) { throw archive_exception("Cannot open source archive."); }
+
+	extract(a.get(), destination);
+	archive_read_close(a.get());
+}
+
+
+namespace
+{
+	/**
+	 * Source of the data for libarchive read callback, exception of the stream is kept until
+	 * the control leaves libarchive.
+	 */
+	struct stream_source {
+		std::istream &input;
+		std::exception_ptr error;
+		char buffer[65536];
+	};
+
+	la_ssize_t stream_read(archive *a, void *client_data, const void **buffer)
+	{
+		auto source = static_cast<stream_source *>(client_data);
+		try {
+			source->input.read(source->buffer, sizeof(source->buffer));
+			if (source->input.bad()) {
+				archive_set_error(a, EIO, "Cannot read source archive.");
+				return -1;
+			}
+		} catch (...) {
+			source->error = std::current_exception();
+			archive_set_error(a, EIO, "Cannot read source archive.");
+			return -1;
+		}
+
+		*buffer = source->buffer;
+		return static_cast<la_ssize_t>(source->input.gcount());
+	}
+} // namespace
+
+
+void archivator::decompress(std::istream &input, const std::string &destination)
+{
+	if (!fs::is_directory(destination)) {
+		throw archive_exception("Destination '" + destination + "' is not a directory. Cannot decompress archive.");
+	}
+
+	std::unique_ptr<stream_source> source(new stream_source{input, nullptr, {}});
+	auto a = create_reader();
+
+	try {
+		int r = archive_read_open(a.get(), source.get(), nullptr, stream_read, nullptr);
+		if (r < ARCHIVE_OK) { throw archive_exception("Cannot open source archive."); }
+
+		extract(a.get(), destination);
+		archive_read_close(a.get());
+	} catch (archive_exception &) {
+		// failure of the stream is more descriptive than the archive error
+		if (source->error) { std::rethrow_exception(source->error); }
+		throw;
+	}
+}
+
 
+std::unique_ptr<archive, decltype(&archive_read_free)> archivator::create_reader()
+{
 	std::unique_ptr<archive, decltype(&archive_read_free)> a = {archive_read_new(), archive_read_free};
 	if (a == nullptr) { throw archive_exception("Cannot create source archive."); }
 	if (archive_read_support_format_all(a.get()) != ARCHIVE_OK) {
@@ -110,6 +318,18 @@ void archivator::decompress(const std::string &filename, const std::string &dest
 	if (archive_read_support_filter_all(a.get()) != ARCHIVE_OK) {
 		throw archive_exception("Cannot set compression methods for source archive.");
 	}
+	return a;
+}
+
+
+void archivator::extract(archive *a, const std::string &destination)
+{
+	// Select which attributes we want to restore.
+	int flags;
+	flags = ARCHIVE_EXTRACT_TIME;
+	flags |= ARCHIVE_EXTRACT_FFLAGS;
+	// Don't allow ".." in any path within archive
+	flags |= ARCHIVE_EXTRACT_SECURE_NODOTDOT;
 
 	std::unique_ptr<archive, decltype(&archive_write_free)> ext = {archive_write_disk_new(), archive_write_free};
 	if (ext == nullptr) { throw archive_exception("Cannot allocate archive entry."); }
@@ -120,14 +340,12 @@ void archivator::decompress(const std::string &filename, const std::string &dest
 		throw archive_exception("Cannot set lookup for writing to disk.");
 	}
 
-	int r = archive_read_open_filename(a.get(), filename.c_str(), 10240);
-	if (r < ARCHIVE_OK) { throw archive_exception("Cannot open source archive."); }
-
+	int r;
 	while (true) {
 		archive_entry *entry;
-		r = archive_read_next_header(a.get(), &entry);
+		r = archive_read_next_header(a, &entry);
 		if (r == ARCHIVE_EOF) { break; }
-		if (r < ARCHIVE_OK) { throw archive_exception(archive_error_string(a.get())); }
+		if (r < ARCHIVE_OK) { throw archive_exception(archive_error_string(a)); }
 
 		const char *current_file = archive_entry_pathname(entry);
 		const std::string full_path = (fs::path(destination) / current_file).string();
@@ -144,13 +362,13 @@ void archivator::decompress(const std::string &filename, const std::string &dest
 		r = archive_write_header(ext.get(), entry);
 		if (r < ARCHIVE_OK) { throw archive_exception(archive_error_string(ext.get())); }
 
-		if (archive_entry_size(entry) > 0) { copy_data(a.get(), ext.get()); }
+		// size of the entry is not known in advance when a zip archive is streamed
+		if (!archive_entry_size_is_set(entry) || archive_entry_size(entry) > 0) { copy_data(a, ext.get()); }
 
 		r = archive_write_finish_entry(ext.get());
 		if (r < ARCHIVE_OK) { throw archive_exception(archive_error_string(ext.get())); }
 	}
 
-	archive_read_close(a.get());
 	archive_write_close(ext.get());
 }
 
@@ -7,7 +7,10 @@
 #include "archive.h"
 #include "archive_entry.h"
 #include <exception>
+#include <istream>
+#include <memory>
 #include <string>
+#include <spdlog/spdlog.h>
 
 #define BOOST_FILESYSTEM_NO_DEPRECATED
 #define BOOST_NO_CXX11_SCOPED_ENUMS
@@ -15,6 +18,16 @@
 
 namespace fs = boost::filesystem;
 
+/**
+ * Formats of archives created by @ref archivator::compress.
+ */
+enum class archive_type {
+	/** Zip archive with deflate compression */
+	ZIP,
+	/** Tar archive compressed by zstd */
+	TAR_ZSTD
+};
+
 /**
  * Class for creating and decompressing archives.
  * On error, both methods throws @ref archive_exception.
@@ -23,7 +36,7 @@ class archivator
 {
 public:
 	/**
-	 * This method will create new .zip archive containing recursively all files inside
+	 * This method will create new archive containing recursively all files inside
 	 * @a dir directory. The archive will contain one root directory (named as whole archive
 	 * without extension). Example:
 	 * @code{.cpp}
@@ -33,10 +46,35 @@ public:
 	 * contain one root directory @a homes, where are placed copies of all files and subdirectories
 	 * in @a /home.
 	 * @param dir Directory to compress.
-	 * @param destination Name and path to the destination archive (should have suffix .zip).
+	 * @param destination Name and path to the destination archive (should have suffix given by
+	 *	@ref get_format_name).
+	 * @param format Format of the archive.
+	 * @param level Compression level of zstd, zero means the default level of the library.
+	 * @param threads Number of threads compressing zstd blocks in parallel. The archive is the same for any
+	 *	number greater than one, zip archives are always compressed by one thread. If the libarchive does not
+	 *	support multithreaded zstd compression, the archive is compressed by one thread.
+	 * @param logger Logger of warnings, for example about ignored @a threads (optional).
 	 * @throws archive_exception if any error occured
 	 */
-	static void compress(const std::string &dir, const std::string &destination);
+	static void compress(const std::string &dir,
+		const std::string &destination,
+		archive_type format = archive_type::ZIP,
+		int level = 0,
+		std::size_t threads = 1,
+		std::shared_ptr<spdlog::logger> logger = nullptr);
+	/**
+	 * Get format of the archive from its name used in configuration, that is "zip" or "tar.zst".
+	 * @param name Name of the format.
+	 * @return The format.
+	 * @throws archive_exception if the format is unknown
+	 */
+	static archive_type parse_format(const std::string &name);
+	/**
+	 * Get name of the format, it is also the suffix of archives in this format.
+	 * @param format The format.
+	 * @return Name of the format without leading dot.
+	 */
+	static std::string get_format_name(archive_type format);
 	/**
 	 * This method will decompress archive @a filename into directory @a destination.
 	 * Supported formats are mainly zip, tar, tar.gz, tar.bz2, 7zip. Archive could contain
@@ -49,8 +87,36 @@ public:
 	 * @throws archive_exception if any error occured
 	 */
 	static void decompress(const std::string &filename, const std::string &destination);
+	/**
+	 * Decompress archive which is read sequentially from the stream into directory @a destination.
+	 * Only formats which can be read without seeking are supported, that is tar (optionally compressed)
+	 * and zip archives which have sizes of the entries in the local headers. Restrictions for the content
+	 * are the same as in @ref decompress.
+	 * @param input Stream with the archive, errors of the stream are propagated.
+	 * @param destination Directory, where will be extracted files stored.
+	 * @throws archive_exception if any error occured
+	 */
+	static void decompress(std::istream &input, const std::string &destination);
 
 private:
+	/**
+	 * Extract all entries of opened source archive into directory @a destination.
+	 * @param a source archive
+	 * @param destination Directory, where will be extracted files stored.
+	 */
+	static void extract(archive *a, const std::string &destination);
+	/**
+	 * Create source archive with all supported formats and filters.
+	 * @return archive which is not opened yet
+	 */
+	static std::unique_ptr<archive, decltype(&archive_read_free)> create_reader();
+	/**
+	 * Write header and content of regular file to the archive.
+	 * @param a destination archive
+	 * @param file path to the file on disk
+	 * @param pathname path of the entry in the archive
+	 */
+	static void write_file(archive *a, const fs::path &file, const std::string &pathname);
 	/**
 	 * Copy one entry from source archive @a ar to archive @a aw.
 	 * @param ar source archive
@@ -2,6 +2,7 @@
 #define RECODEX_WORKER_BROKER_CONNECTION_H
 
 #include <zmq.hpp>
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <bitset>
@@ -41,22 +42,14 @@ private:
 	std::shared_ptr<command_holder<broker_connection_context<proxy>>> broker_cmds_;
 	std::shared_ptr<command_holder<broker_connection_context<proxy>>> jobs_server_cmds_;
 	std::chrono::seconds reconnect_delay = std::chrono::seconds(1);
-	std::string current_job_;
+	std::vector<std::string> jobs_;
 
 	/**
 	 * Send the init command to the broker
 	 */
 	void send_init() const
 	{
-		const worker_config::header_map_t &headers = config_->get_headers();
-		std::vector<std::string> msg = {"init", config_->get_hwgroup()};
-
-		for (auto &it : headers) { msg.push_back(it.first + "=" + it.second); }
-		msg.push_back("");
-		msg.push_back("description=" + config_->get_worker_description());
-		if (!current_job_.empty()) { msg.push_back("current_job=" + current_job_); }
-
-		socket_->send_broker(msg);
+		socket_->send_broker(broker_commands::make_init(*config_, jobs_));
 	}
 
 	/**
@@ -72,6 +65,25 @@ private:
 		if (reconnect_delay < max_reconnect_delay) { reconnect_delay *= 2; }
 	}
 
+	/**
+	 * Remember a job which was sent to the job receiver, it is queued if all slots evaluate other jobs
+	 * @param job_id identifier of the job
+	 */
+	void job_received(const std::string &job_id)
+	{
+		jobs_.push_back(job_id);
+	}
+
+	/**
+	 * Forget a job which was evaluated, the first queued job takes its place
+	 * @param job_id identifier of the job
+	 */
+	void job_done(const std::string &job_id)
+	{
+		auto it = std::find(jobs_.begin(), jobs_.end(), job_id);
+		if (it != jobs_.end()) { jobs_.erase(it); }
+	}
+
 	/**
 	 * Reset the reconnection delay to its initial value
 	 */
@@ -89,12 +101,12 @@ public:
 	broker_connection(std::shared_ptr<const worker_config> config,
 		std::shared_ptr<proxy> socket,
 		std::shared_ptr<spdlog::logger> logger = nullptr)
-		: config_(config), socket_(socket), logger_(logger), current_job_("")
+		: config_(config), socket_(socket), logger_(logger)
 	{
 		if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
 
 		// prepare dependent context for commands (in this class)
-		broker_connection_context<proxy> dependent_context = {socket_, config_, current_job_};
+		broker_connection_context<proxy> dependent_context = {socket_, config_, jobs_};
 
 		// init broker commands
 		broker_cmds_ = std::make_shared<command_holder<broker_connection_context<proxy>>>(dependent_context, logger_);
@@ -162,7 +174,7 @@ public:
 
 					if (terminate) { break; }
 
-					if (msg.size() >= 2 && msg.at(0) == "eval") { current_job_ = msg.at(1); }
+					if (msg.size() >= 2 && msg.at(0) == "eval") { job_received(msg.at(1)); }
 
 					broker_cmds_->call_function(msg.at(0), msg);
 				}
@@ -172,7 +184,7 @@ public:
 
 					if (terminate) { break; }
 
-					if (msg.size() >= 1 && msg.at(0) == "done") { current_job_ = ""; }
+					if (msg.size() >= 2 && msg.at(0) == "done") { job_done(msg.at(1)); }
 
 					jobs_server_cmds_->call_function(msg.at(0), msg);
 				}
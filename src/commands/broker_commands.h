@@ -20,6 +20,34 @@ namespace broker_commands
 		context.sockets->send_jobs(args);
 	}
 
+	/**
+	 * Create init command for the broker with headers, hwgroup and the jobs which the worker already accepted.
+	 * Jobs beyond the number of slots wait in queues of the slots for evaluation.
+	 * @param config configuration of the worker
+	 * @param jobs identifiers of accepted jobs in the order in which they were received
+	 * @return multipart message of the init command
+	 */
+	inline std::vector<std::string> make_init(
+		const worker_config &config, const std::vector<std::string> &jobs)
+	{
+		std::vector<std::string> msg = {"init", config.get_hwgroup()};
+
+		for (auto &it : config.get_headers()) { msg.push_back(it.first + "=" + it.second); }
+		msg.push_back("");
+		msg.push_back("description=" + config.get_worker_description());
+
+		std::size_t slots = config.get_slots();
+		if (slots > 1) { msg.push_back("slots=" + std::to_string(slots)); }
+		for (std::size_t i = 0; i < jobs.size() && i < slots; ++i) { msg.push_back("current_job=" + jobs[i]); }
+		if (config.get_prefetch_next_job()) {
+			msg.push_back("max_queued_jobs=" + std::to_string(slots));
+			for (std::size_t i = slots; i < jobs.size(); ++i) { msg.push_back("queued_job=" + jobs[i]); }
+		}
+		if (config.get_result_format() != "zip") { msg.push_back("result_format=" + config.get_result_format()); }
+
+		return msg;
+	}
+
 	/**
 	 * Intro command arrived from broker, send him back init message with headers and hwgroup.
 	 * @param args received multipart message with leading command
@@ -28,14 +56,7 @@ namespace broker_commands
 	template <typename context_t>
 	void process_intro(const std::vector<std::string> &args, const command_context<context_t> &context)
 	{
-		std::vector<std::string> reply = {"init", context.config->get_hwgroup()};
-
-		for (auto &it : context.config->get_headers()) { reply.push_back(it.first + "=" + it.second); }
-		reply.push_back("");
-		reply.push_back("description=" + context.config->get_worker_description());
-		if (!context.current_job.empty()) { reply.push_back("current_job=" + context.current_job); }
-
-		context.sockets->send_broker(reply);
+		context.sockets->send_broker(make_init(*context.config, context.jobs));
 	}
 } // namespace broker_commands
 
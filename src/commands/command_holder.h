@@ -5,6 +5,9 @@
 #include <string>
 #include <functional>
 #include <map>
+#include <deque>
+#include <vector>
+#include <future>
 #include <zmq.hpp>
 #include "helpers/logger.h"
 #include "job/job_evaluator_interface.h"
@@ -22,8 +25,8 @@ public:
 	std::shared_ptr<proxy> sockets;
 	/** Worker configuration loaded from file. */
 	std::shared_ptr<const worker_config> config;
-	/** Identifier of currently evaluated job, usefull when reconnecting during evaluation. */
-	const std::string &current_job;
+	/** Identifiers of evaluated and queued jobs in order of arrival, usefull when reconnecting during evaluation. */
+	const std::vector<std::string> &jobs;
 };
 
 /**
@@ -37,6 +40,12 @@ public:
 	std::shared_ptr<job_evaluator_interface> evaluator;
 	/** Reference to ZeroMQ socket for communicating with main thread of worker. */
 	zmq::socket_t &socket;
+	/** If true, next job is received and prefetched during evaluation of the current one. */
+	bool prefetch;
+	/** Messages received during evaluation, they are processed after the current job is done. */
+	std::deque<std::vector<std::string>> &postponed;
+	/** Responses of evaluated jobs which are sent to "main" thread when the results are uploaded. */
+	std::deque<std::shared_future<eval_response>> &pending;
 };
 
 /**
@@ -1,8 +1,12 @@
 #ifndef RECODEX_WORKER_JOBS_CLIENT_COMMANDS_H
 #define RECODEX_WORKER_JOBS_CLIENT_COMMANDS_H
 
+#include <future>
+#include <chrono>
+#include <deque>
 #include "command_holder.h"
 #include "helpers/zmq_socket.h"
+#include "helpers/metrics.h"
 #include "eval_request.h"
 #include "eval_response.h"
 
@@ -13,24 +17,113 @@
 namespace jobs_client_commands
 {
 
+	/**
+	 * Create request from the eval command, the fifth frame with format of results is optional.
+	 * @param args received multipart message with leading command, it has 4 or 5 frames
+	 * @return the request
+	 */
+	inline eval_request make_request(const std::vector<std::string> &args)
+	{
+		return eval_request(args[1], args[2], args[3], args.size() > 4 ? args[4] : "");
+	}
+
+	/**
+	 * Send done replies of the jobs which results are already uploaded. Replies are sent in the order
+	 * in which the jobs were evaluated.
+	 * @param socket socket connected to "main" thread
+	 * @param pending responses of evaluated jobs which were not sent yet
+	 * @param logger system logger
+	 */
+	inline void send_finished(zmq::socket_t &socket,
+		std::deque<std::shared_future<eval_response>> &pending,
+		std::shared_ptr<spdlog::logger> logger)
+	{
+		while (!pending.empty() &&
+			pending.front().wait_for(std::chrono::milliseconds(0)) == std::future_status::ready) {
+			const eval_response &response = pending.front().get();
+			std::vector<std::string> reply = {"done", response.job_id, response.result, response.message};
+
+			if (response.result == "OK") {
+				helpers::metrics().jobs_ok.add();
+			} else if (response.result == "FAILED") {
+				helpers::metrics().jobs_failed.add();
+			} else {
+				helpers::metrics().jobs_internal_error.add();
+			}
+
+			helpers::send_through_socket(socket, reply);
+			logger->info("Job-receiver: Job evaluated and respond sent.");
+			pending.pop_front();
+		}
+	}
+
+	/**
+	 * Evaluate the job in background and meanwhile receive the next job, so that its submission
+	 * can be prefetched. Received messages are postponed until the evaluation is done, replies of
+	 * previous jobs are sent as soon as their results are uploaded.
+	 * @param request the job which is evaluated
+	 * @param context command context of command holder
+	 * @return response of the evaluator which is ready when results are uploaded
+	 */
+	template <typename context_t>
+	std::shared_future<eval_response> evaluate_with_prefetch(
+		const eval_request &request, const command_context<context_t> &context)
+	{
+		auto evaluator = context.evaluator;
+		auto evaluation =
+			std::async(std::launch::async, [evaluator, request]() { return evaluator->evaluate_async(request); });
+
+		const std::chrono::milliseconds poll_interval(100);
+		while (evaluation.wait_for(std::chrono::milliseconds(0)) != std::future_status::ready) {
+			send_finished(context.socket, context.pending, context.logger);
+
+			// only one job is queued, further messages stay in the socket
+			if (!context.postponed.empty()) {
+				evaluation.wait_for(poll_interval);
+				continue;
+			}
+
+			try {
+				zmq::pollitem_t item = {(void *) context.socket, 0, ZMQ_POLLIN, 0};
+				zmq::poll(&item, 1, static_cast<long>(poll_interval.count()));
+				if (!(item.revents & ZMQ_POLLIN)) { continue; }
+
+				std::vector<std::string> message;
+				if (!helpers::recv_from_socket(context.socket, message) || message.empty()) { continue; }
+
+				if ((message.size() == 4 || message.size() == 5) && message[0] == "eval") {
+					context.logger->info("Job-receiver: Job {} queued, its submission is prefetched.", message[1]);
+					context.evaluator->prefetch(make_request(message));
+				}
+				context.postponed.push_back(message);
+				helpers::metrics().queued_jobs.add(1);
+			} catch (zmq::error_t &) {
+				// socket is closed, just wait for the evaluation
+				evaluation.wait();
+			}
+		}
+
+		return evaluation.get();
+	}
+
 	/**
 	 * From "main" thread arrived eval command.
 	 * Received job id and other information are handed over for evaluation,
-	 * after this done reply is sent back to "main" thread.
+	 * done reply is sent back to "main" thread when the results are uploaded.
 	 * @param args received multipart message with leading command
 	 * @param context command context of command holder
 	 */
 	template <typename context_t>
 	void process_eval(const std::vector<std::string> &args, const command_context<context_t> &context)
 	{
-		if (args.size() == 4) {
+		if (args.size() == 4 || args.size() == 5) {
 			context.logger->info("Job-receiver: Job evaluating request received.");
 
-			eval_response response = context.evaluator->evaluate(eval_request(args[1], args[2], args[3]));
-			std::vector<std::string> reply = {"done", response.job_id, response.result, response.message};
+			eval_request request = make_request(args);
+			context.pending.push_back(context.prefetch ? evaluate_with_prefetch(request, context) :
+														 context.evaluator->evaluate_async(request));
 
-			helpers::send_through_socket(context.socket, reply);
-			context.logger->info("Job-receiver: Job evaluated and respond sent.");
+			send_finished(context.socket, context.pending, context.logger);
 		} else {
 			context.logger->warn("Job-receiver: Eval command with wrong number of arguments.");
 		}
@@ -2,6 +2,7 @@
 #define RECODEX_WORKER_SANDBOX_CONFIG_H
 
 #include <map>
+#include <vector>
 #include <memory>
 #include "sandbox_limits.h"
 
@@ -60,6 +61,17 @@ public:
 	 * Working directory relative to the directory with the source files.
 	 */
 	std::string working_directory = "";
+	/**
+	 * Files written by the program which are kept when it runs on top of an overlay of the evaluation directory,
+	 * standard output and error files are kept always.
+	 * @note Paths must be accessible from inside of sandbox.
+	 */
+	std::vector<std::string> output_files;
+	/**
+	 * Name of the test batch, tasks of one batch reuse the same sandbox box.
+	 * Only files are removed from the box between tasks, limits and results are still per task.
+	 */
+	std::string batch = "";
 	/**
 	 * Associative array of loaded limits with textual index identifying its hw group.
 	 */
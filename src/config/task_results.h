@@ -3,6 +3,7 @@
 
 #include <string>
 #include <memory>
+#include "helpers/timings.h"
 
 /**
  * Return error codes of sandbox. Code names corresponds isolate's meta file error codes.
@@ -75,6 +76,46 @@ struct sandbox_results {
 	 * Default: 0
 	 */
 	std::size_t csw_forced = 0;
+	/**
+	 * Flag if the following counters were read from the cgroup of the box (cgroup accounting is enabled).
+	 * Default: false
+	 */
+	bool cgroup_stats = false;
+	/**
+	 * Peak memory usage of the cgroup including page cache, from memory.peak.
+	 * Default: 0 (kB)
+	 */
+	std::size_t memory_peak = 0;
+	/**
+	 * Bytes read from block devices, from io.stat.
+	 * Default: 0 (B)
+	 */
+	std::size_t io_read = 0;
+	/**
+	 * Bytes written to block devices, from io.stat.
+	 * Default: 0 (B)
+	 */
+	std::size_t io_write = 0;
+	/**
+	 * Number of periods in which the program was throttled by CPU controller, from cpu.stat.
+	 * Default: 0
+	 */
+	std::size_t throttled = 0;
+	/**
+	 * Total time for which the program was throttled by CPU controller, from cpu.stat.
+	 * Default: 0 (s)
+	 */
+	float throttled_time = 0;
+	/**
+	 * Number of processes killed by OOM killer in the cgroup, from memory.events.
+	 * Default: 0
+	 */
+	std::size_t oom_kills = 0;
+	/**
+	 * Durations of copying data into the sandbox, of the run and of copying data out of it, measured by worker.
+	 * Default: empty
+	 */
+	helpers::phase_timings timings;
 
 	/**
 	 * Constructor with default values initialization.
@@ -131,6 +172,11 @@ struct task_results {
 	 * Default: nullptr (other types of tasks)
 	 */
 	std::unique_ptr<sandbox_results> sandbox_status = nullptr;
+	/**
+	 * Durations of phases of the task measured by worker, the last one is the total duration.
+	 * Default: empty
+	 */
+	helpers::phase_timings timings;
 
 	/**
 	 * Constructor with default values initiazation.
@@ -1,5 +1,6 @@
 #include "worker_config.h"
 #include "helpers/config.h"
+#include <limits>
 
 worker_config::worker_config() = default;
 
@@ -52,6 +53,14 @@ worker_config::worker_config(const YAML::Node &config)
 			if (cache["cache-dir"] && cache["cache-dir"].IsScalar()) {
 				cache_dir_ = config["file-cache"]["cache-dir"].as<std::string>();
 			}
+
+			if (cache["max-size"] && cache["max-size"].IsScalar()) {
+				cache_max_size_ = cache["max-size"].as<std::size_t>();
+			} // can be omitted... no throw
+
+			if (cache["hardlinks"] && cache["hardlinks"].IsScalar()) {
+				cache_hardlinks_ = cache["hardlinks"].as<bool>();
+			} // can be omitted... no throw
 		}
 
 		// load worker-id
@@ -180,6 +189,104 @@ worker_config::worker_config(const YAML::Node &config)
 			throw config_error("Item cleanup-submission not defined properly");
 		}
 
+		// load max-parallel-tasks
+		if (config["max-parallel-tasks"] && config["max-parallel-tasks"].IsScalar()) {
+			max_parallel_tasks_ = config["max-parallel-tasks"].as<std::size_t>();
+			if (max_parallel_tasks_ == 0) { throw config_error("Item max-parallel-tasks has to be positive number"); }
+		} // can be omitted... no throw
+
+		// load box-pool item
+		box_pool_first_id_ = worker_id_;
+		if (config["box-pool"] && config["box-pool"].IsMap()) {
+			auto &pool = config["box-pool"];
+
+			if (pool["size"] && pool["size"].IsScalar()) {
+				box_pool_size_ = pool["size"].as<std::size_t>();
+			} // can be omitted... no throw
+			if (pool["first-box-id"] && pool["first-box-id"].IsScalar()) {
+				box_pool_first_id_ = pool["first-box-id"].as<std::size_t>();
+			} else if (box_pool_size_ > 1) {
+				// pools starting with worker IDs of different workers would overlap
+				throw config_error("Item first-box-id of box-pool has to be set when the pool has more boxes");
+			}
+		}
+
+		// load sandbox-data-mode
+		if (config["sandbox-data-mode"] && config["sandbox-data-mode"].IsScalar()) {
+			auto mode = config["sandbox-data-mode"].as<std::string>();
+			if (mode == "copy") {
+				sandbox_data_mode_ = sandbox_data_mode::COPY;
+			} else if (mode == "rename") {
+				sandbox_data_mode_ = sandbox_data_mode::RENAME;
+			} else if (mode == "bind") {
+				sandbox_data_mode_ = sandbox_data_mode::BIND;
+			} else if (mode == "overlay") {
+				sandbox_data_mode_ = sandbox_data_mode::OVERLAY;
+			} else {
+				throw config_error("Unknown sandbox-data-mode: " + mode);
+			}
+		} // can be omitted... no throw
+
+		// load prefetch-next-job
+		if (config["prefetch-next-job"] && config["prefetch-next-job"].IsScalar()) {
+			prefetch_next_job_ = config["prefetch-next-job"].as<bool>();
+		} // can be omitted... no throw
+
+		// load result-upload item
+		if (config["result-upload"] && config["result-upload"].IsMap()) {
+			auto &upload = config["result-upload"];
+
+			if (upload["queue-size"] && upload["queue-size"].IsScalar()) {
+				upload_queue_size_ = upload["queue-size"].as<std::size_t>();
+			} // can be omitted... no throw
+			if (upload["retries"] && upload["retries"].IsScalar()) {
+				upload_retries_ = upload["retries"].as<std::size_t>();
+			} // can be omitted... no throw
+		}
+
+		// load result-archive item
+		if (config["result-archive"] && config["result-archive"].IsMap()) {
+			auto &archive = config["result-archive"];
+
+			if (archive["format"] && archive["format"].IsScalar()) {
+				result_format_ = archive["format"].as<std::string>();
+				if (result_format_ != "zip" && result_format_ != "tar.zst") {
+					throw config_error("Unknown format of result archive: " + result_format_);
+				}
+			} // can be omitted... no throw
+			if (archive["level"] && archive["level"].IsScalar()) {
+				result_compression_level_ = archive["level"].as<int>();
+			} // can be omitted... no throw
+		}
+
+		// load compression-threads
+		if (config["compression-threads"] && config["compression-threads"].IsScalar()) {
+			compression_threads_ = config["compression-threads"].as<std::size_t>();
+			if (compression_threads_ == 0) { throw config_error("Item compression-threads has to be positive number"); }
+		} // can be omitted... no throw
+
+		// load metrics-endpoint
+		if (config["metrics-endpoint"] && config["metrics-endpoint"].IsScalar()) {
+			metrics_endpoint_ = config["metrics-endpoint"].as<std::string>();
+		} // can be omitted... no throw
+
+		// load box-cgroup-root
+		if (config["box-cgroup-root"] && config["box-cgroup-root"].IsScalar()) {
+			box_cgroup_root_ = config["box-cgroup-root"].as<std::string>();
+		} // can be omitted... no throw
+
+		// load slots
+		if (config["slots"] && config["slots"].IsScalar()) {
+			slots_ = config["slots"].as<std::size_t>();
+			if (slots_ == 0) { throw config_error("Item slots has to be positive number"); }
+		} // can be omitted... no throw
+
+		// pools of the slots follow each other, the identifier of the last box must not overflow
+		if (box_pool_size_ > 0 &&
+			(std::numeric_limits<std::size_t>::max() - box_pool_first_id_) / box_pool_size_ < slots_) {
+			throw config_error("Boxes of the box-pool of all slots do not fit into box identifiers");
+		}
+
 	} catch (YAML::Exception &ex) {
 		throw config_error("Default worker configuration was not loaded: " + std::string(ex.what()));
 	}
@@ -238,6 +345,16 @@ const std::string &worker_config::get_cache_dir() const
 	return cache_dir_;
 }
 
+std::size_t worker_config::get_cache_max_size() const
+{
+	return cache_max_size_;
+}
+
+bool worker_config::get_cache_hardlinks() const
+{
+	return cache_hardlinks_;
+}
+
 size_t worker_config::get_max_broker_liveness() const
 {
 	return max_broker_liveness_;
@@ -262,3 +379,81 @@ bool worker_config::get_cleanup_submission() const
 {
 	return cleanup_submission_;
 }
+
+size_t worker_config::get_max_parallel_tasks() const
+{
+	return max_parallel_tasks_;
+}
+
+size_t worker_config::get_box_pool_size() const
+{
+	return box_pool_size_;
+}
+
+size_t worker_config::get_box_pool_first_id() const
+{
+	return box_pool_first_id_;
+}
+
+sandbox_data_mode worker_config::get_sandbox_data_mode() const
+{
+	return sandbox_data_mode_;
+}
+
+bool worker_config::get_prefetch_next_job() const
+{
+	return prefetch_next_job_;
+}
+
+std::size_t worker_config::get_upload_queue_size() const
+{
+	return upload_queue_size_;
+}
+
+std::size_t worker_config::get_upload_retries() const
+{
+	return upload_retries_;
+}
+
+const std::string &worker_config::get_result_format() const
+{
+	return result_format_;
+}
+
+int worker_config::get_result_compression_level() const
+{
+	return result_compression_level_;
+}
+
+std::size_t worker_config::get_compression_threads() const
+{
+	return compression_threads_;
+}
+
+const std::string &worker_config::get_metrics_endpoint() const
+{
+	return metrics_endpoint_;
+}
+
+const std::string &worker_config::get_box_cgroup_root() const
+{
+	return box_cgroup_root_;
+}
+
+std::size_t worker_config::get_slots() const
+{
+	return slots_;
+}
+
+std::shared_ptr<worker_config> worker_config::get_slot_config(std::size_t slot) const
+{
+	// ranges of boxes are disjoint only for the slots of this worker, next ones belong to other workers
+	if (slot >= slots_) {
+		throw config_error("Slot " + std::to_string(slot) + " is out of " + std::to_string(slots_) + " slots");
+	}
+
+	auto config = std::make_shared<worker_config>(*this);
+	config->worker_id_ += slot;
+	config->box_pool_first_id_ += slot * box_pool_size_;
+	return config;
+}
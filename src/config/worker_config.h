@@ -5,6 +5,7 @@
 #include <iostream>
 #include <string>
 #include <map>
+#include <memory>
 #include <yaml-cpp/yaml.h>
 
 #define BOOST_FILESYSTEM_NO_DEPRECATED
@@ -92,6 +93,18 @@ public:
 	 */
 	virtual const std::string &get_cache_dir() const;
 
+	/**
+	 * Get maximal size of the caching directory.
+	 * @return size in bytes, zero means unlimited
+	 */
+	virtual std::size_t get_cache_max_size() const;
+
+	/**
+	 * Whether files fetched from the cache can be read-only hardlinks to the cached files.
+	 * @return true if hardlinks are allowed
+	 */
+	virtual bool get_cache_hardlinks() const;
+
 	/**
 	 * Get wrapper for logger configuration.
 	 * @return constant reference to log_config structure
@@ -126,6 +139,94 @@ public:
 	 */
 	virtual bool get_cleanup_submission() const;
 
+	/**
+	 * Get maximal number of tasks from one job which can be executed at the same time.
+	 * @return number of parallel task slots, at least one
+	 */
+	virtual std::size_t get_max_parallel_tasks() const;
+
+	/**
+	 * Get number of isolate boxes which are initialized in advance and reused.
+	 * @return size of the box pool, zero if the pool is disabled
+	 */
+	virtual std::size_t get_box_pool_size() const;
+
+	/**
+	 * Get identifier of the first isolate box in the pool, following boxes have consecutive identifiers.
+	 * @return box identifier
+	 */
+	virtual std::size_t get_box_pool_first_id() const;
+
+	/**
+	 * Get the way in which evaluation directory is handed over to the sandbox.
+	 * @return mode of data transfer
+	 */
+	virtual sandbox_data_mode get_sandbox_data_mode() const;
+
+	/**
+	 * Get flag which determines if the worker accepts one more job while the current one is evaluated.
+	 * @return true if submission of the queued job is downloaded in advance
+	 */
+	virtual bool get_prefetch_next_job() const;
+
+	/**
+	 * Get number of jobs which results can wait for upload in background.
+	 * @return size of the upload queue, zero if the results are uploaded before the evaluation ends
+	 */
+	virtual std::size_t get_upload_queue_size() const;
+
+	/**
+	 * Get number of repeated attempts to upload results of the job.
+	 * @return number of retries
+	 */
+	virtual std::size_t get_upload_retries() const;
+
+	/**
+	 * Get format of archives with results, which is used unless the broker asks for another one.
+	 * @return name of the format, "zip" or "tar.zst"
+	 */
+	virtual const std::string &get_result_format() const;
+
+	/**
+	 * Get compression level of zstd used in tar.zst archives with results.
+	 * @return compression level, zero means the default level
+	 */
+	virtual int get_result_compression_level() const;
+
+	/**
+	 * Get number of threads which compress tar.zst archives with results or created by archivate tasks.
+	 * @return number of compression threads, at least one
+	 */
+	virtual std::size_t get_compression_threads() const;
+
+	/**
+	 * Get address on which metrics of the worker are served over HTTP.
+	 * @return ZeroMQ address like "tcp://127.0.0.1:9100", empty string means that metrics are not served
+	 */
+	virtual const std::string &get_metrics_endpoint() const;
+
+	/**
+	 * Get directory in cgroup v2 hierarchy with cgroups of isolate boxes (named box-<id>).
+	 * @return path to the directory, empty string means that counters are taken only from isolate's meta file
+	 */
+	virtual const std::string &get_box_cgroup_root() const;
+
+	/**
+	 * Get number of evaluation slots, each slot evaluates its own job at the same time as the others.
+	 * @return number of slots, at least one
+	 */
+	virtual std::size_t get_slots() const;
+
+	/**
+	 * Get configuration of one evaluation slot. It differs from this one by worker ID, which is increased
+	 * by the index of the slot, and by the first box of the pool, so that every slot has its own isolate
+	 * boxes and its own subtree of the working directory.
+	 * @param slot index of the slot, zero is the first one
+	 * @return configuration used by job evaluator of the slot
+	 * @throws config_error if the slot is not one of the slots of this worker, its boxes would overlap other pools
+	 */
+	std::shared_ptr<worker_config> get_slot_config(std::size_t slot) const;
+
 private:
 	/** Unique worker number in context of one machine (0-100 preferably) */
 	std::size_t worker_id_ = 0;
@@ -145,6 +246,10 @@ private:
 	std::chrono::milliseconds broker_ping_interval_ = std::chrono::milliseconds(1000);
 	/** The caching directory path */
 	std::string cache_dir_ = "";
+	/** Maximal size of the caching directory in bytes, zero means unlimited */
+	std::size_t cache_max_size_ = 0;
+	/** If true then fetched files can be hardlinks to the cached files, they must not be modified then */
+	bool cache_hardlinks_ = false;
 	/** Configuration of logger */
 	log_config log_config_ = {};
 	/** Default configuration of file managers */
@@ -157,6 +262,32 @@ private:
 	std::size_t max_carboncopy_length_ = 0;
 	/** If true then all files created during evaluation of job will be deleted at the end. */
 	bool cleanup_submission_ = true;
+	/** Number of tasks which can be executed in parallel, one means sequential execution. */
+	std::size_t max_parallel_tasks_ = 1;
+	/** Number of isolate boxes in the pool, zero means that every task initializes its own box. */
+	std::size_t box_pool_size_ = 0;
+	/** Identifier of the first box in the pool, worker identifier is used by default. */
+	std::size_t box_pool_first_id_ = 0;
+	/** How evaluation directory gets into the sandbox, copying is the safe default. */
+	sandbox_data_mode sandbox_data_mode_ = sandbox_data_mode::COPY;
+	/** If true then one job can be queued and its submission is prepared during evaluation of the current job. */
+	bool prefetch_next_job_ = false;
+	/** Number of jobs which results wait for upload in background, zero means synchronous upload. */
+	std::size_t upload_queue_size_ = 2;
+	/** How many times failed upload of results is repeated. */
+	std::size_t upload_retries_ = 3;
+	/** Format of archives with results. */
+	std::string result_format_ = "zip";
+	/** Compression level of zstd, zero is the default level. */
+	int result_compression_level_ = 0;
+	/** Number of threads compressing tar.zst archives. */
+	std::size_t compression_threads_ = 1;
+	/** Address of the metrics endpoint, empty means disabled. */
+	std::string metrics_endpoint_ = "";
+	/** Directory with cgroups of isolate boxes, empty means disabled cgroup accounting. */
+	std::string box_cgroup_root_ = "";
+	/** Number of jobs evaluated at the same time. */
+	std::size_t slots_ = 1;
 };
 
 
@@ -13,15 +13,18 @@ struct eval_request {
 	const std::string job_url;
 	/** Remote address on which results will be pushed */
 	const std::string result_url;
+	/** Format of the archive with results requested by broker, empty if the worker chooses */
+	const std::string result_format;
 
 	/**
 	 * Construction of this structure with all variables set during it.
 	 * @param job_id
 	 * @param job_url
 	 * @param result_url
+	 * @param result_format
 	 */
-	eval_request(std::string job_id, std::string job_url, std::string result_url)
-		: job_id(job_id), job_url(job_url), result_url(result_url)
+	eval_request(std::string job_id, std::string job_url, std::string result_url, std::string result_format = "")
+		: job_id(job_id), job_url(job_url), result_url(result_url), result_format(result_format)
 	{
 	}
 };
@@ -1,5 +1,64 @@
 #include "cache_manager.h"
 #include "helpers/string_utils.h"
+#include "helpers/sha1.h"
+#include "helpers/filesystem.h"
+#include "helpers/metrics.h"
+#include <algorithm>
+#include <vector>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+
+namespace
+{
+	/** Subdirectory of the cache with content addressed objects. */
+	const std::string objects_dir_name = "objects";
+	/** File in the caching directory which is locked during eviction. */
+	const std::string lock_file_name = ".lock";
+	/** Repeated hits of the same file within this period (in seconds) do not touch the file on disk. */
+	const std::time_t touch_interval = 60;
+
+	bool is_temp_file(const std::string &name)
+	{
+		const std::string suffix = ".tmp";
+		return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+	}
+
+	/**
+	 * Lock of the whole caching directory shared by all workers, it is released in destructor.
+	 * Putting files takes shared lock, eviction takes exclusive one, so no object is removed
+	 * before the new name is linked to it.
+	 */
+	class cache_lock
+	{
+	public:
+		cache_lock(const fs::path &lock_file, bool exclusive)
+		{
+#ifndef _WIN32
+			fd_ = open(lock_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+			if (fd_ >= 0 && flock(fd_, exclusive ? LOCK_EX : LOCK_SH) != 0) {
+				close(fd_);
+				fd_ = -1;
+			}
+#endif
+		}
+
+		~cache_lock()
+		{
+#ifndef _WIN32
+			if (fd_ >= 0) { close(fd_); }
+#endif
+		}
+
+	private:
+		int fd_ = -1;
+	};
+} // namespace
 
 
 cache_manager::cache_manager(std::shared_ptr<spdlog::logger> logger)
@@ -7,10 +66,17 @@ cache_manager::cache_manager(std::shared_ptr<spdlog::logger> logger)
 {
 }
 
-cache_manager::cache_manager(const std::string &caching_dir, std::shared_ptr<spdlog::logger> logger) : logger_(logger)
+cache_manager::cache_manager(
+	const std::string &caching_dir, std::shared_ptr<spdlog::logger> logger, std::uintmax_t max_size, bool hardlinks)
+	: max_size_(max_size), hardlinks_(hardlinks), logger_(logger)
 {
 	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
 
+#ifdef _WIN32
+	// cached files are not read-only on Windows (see put_file()), so they must not be shared with jobs
+	hardlinks_ = false;
+#endif
+
 	fs::path cache_path(caching_dir);
 
 	try {
@@ -22,59 +88,283 @@ cache_manager::cache_manager(const std::string &caching_dir, std::shared_ptr<spd
 	}
 
 	caching_dir_ = cache_path;
+	objects_dir_ = caching_dir_ / objects_dir_name;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	load_index();
+	logger_->debug("Cache index loaded, {} files with {} bytes are stored", entries_.size(), total_size_);
+	if (max_size_ > 0 && total_size_ > max_size_) { evict(); }
 }
 
 void cache_manager::get_file(const std::string &src_name, const std::string &dst_path)
 {
 	fs::path source_file = caching_dir_ / src_name;
 	fs::path destination_file = dst_path;
-	logger_->debug("Copying file {} from cache to {}", src_name, dst_path);
-
-	if (!fs::is_regular_file(source_file)) {
-		auto message = "Cache miss. File " + src_name + " is not present in cache.";
-		logger_->debug(message);
-		throw fm_exception(message);
-	}
+	helpers::copy_strategy strategy;
 
+	// file is copied straight away, the disk is examined only when the copying fails
 	try {
-		fs::copy_file(source_file, destination_file, fs::copy_option::overwrite_if_exists);
-		fs::permissions(fs::path(destination_file),
-			fs::perms::add_perms | fs::perms::owner_write | fs::perms::group_write | fs::perms::others_write);
-		// change last modification time of the file
-		fs::last_write_time(source_file, std::time(nullptr));
-	} catch (fs::filesystem_error &e) {
+		strategy = helpers::copy_file(source_file, destination_file, hardlinks_);
+		// hardlinked file is shared with the cache, so it stays read-only
+		if (strategy != helpers::copy_strategy::HARDLINK) {
+			fs::permissions(fs::path(destination_file),
+				fs::perms::add_perms | fs::perms::owner_write | fs::perms::group_write | fs::perms::others_write);
+		}
+	} catch (std::exception &e) {
+		if (!fs::is_regular_file(source_file)) {
+			auto message = "Cache miss. File " + src_name + " is not present in cache.";
+			logger_->debug(message);
+			helpers::metrics().cache_misses.add();
+			std::lock_guard<std::mutex> lock(mutex_);
+			forget_name(src_name);
+			throw fm_exception(message);
+		}
+
 		auto message = "Failed to copy file '" + source_file.string() + "' to '" + dst_path + "'. Error: " + e.what();
 		logger_->warn(message);
 		throw fm_exception(message);
 	}
+	logger_->debug(
+		"File {} delivered from cache to {} using {}", src_name, dst_path, helpers::copy_strategy_name(strategy));
+	helpers::metrics().cache_hits.add();
+
+	// change last modification time of the file, other workers see it as the time of the last usage
+	auto now = std::time(nullptr);
+	bool touch = true;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto alias = aliases_.find(src_name);
+		if (alias != aliases_.end()) {
+			auto &entry = entries_[alias->second];
+			touch = now - entry.last_used >= touch_interval;
+			entry.last_used = now;
+		}
+	}
+	if (touch) {
+		boost::system::error_code error;
+		fs::last_write_time(source_file, now, error);
+	}
 }
 
 void cache_manager::put_file(const std::string &src_name, const std::string &dst_name)
 {
-	fs::path source_file(src_name);
 	fs::path destination_file = caching_dir_ / dst_name;
-	fs::path destination_temp_file;
-
-	do {
-		// generate name and check it for existance, if exists... repeat
-		destination_temp_file = caching_dir_ / (dst_name + "-" + helpers::random_alphanum_string(20) + ".tmp");
-	} while (fs::exists(destination_temp_file));
+	fs::path temp_object;
+	fs::path temp_name;
 
 	logger_->debug("Copying file {} to cache with name {}", src_name, dst_name);
 
+	std::string key;
+	std::uintmax_t size = 0;
+	boost::system::error_code error;
+
 	try {
-		// first copy only temporary file
-		fs::copy_file(source_file, destination_temp_file, fs::copy_option::overwrite_if_exists);
-		// and then move (atomically) the file to its original destination
-		fs::rename(destination_temp_file, destination_file);
-	} catch (fs::filesystem_error &e) {
+		do {
+			temp_name = caching_dir_ / (dst_name + "-" + helpers::random_alphanum_string(20) + ".tmp");
+		} while (fs::exists(temp_name));
+		size = fs::file_size(src_name);
+
+#ifdef _WIN32
+		// names cannot be matched with objects without inode numbers (see load_index()), each name is standalone
+		key = dst_name;
+		{
+			cache_lock lock(caching_dir_ / lock_file_name, false);
+			// first copy only temporary file, it stays writable so that the name can be replaced again
+			auto strategy = helpers::copy_file(src_name, temp_name);
+			logger_->debug("File {} stored to cache using {}", dst_name, helpers::copy_strategy_name(strategy));
+			fs::rename(temp_name, destination_file);
+		}
+#else
+		if (!fs::is_directory(objects_dir_)) { fs::create_directories(objects_dir_); }
+
+		do {
+			// generate name and check it for existance, if exists... repeat
+			temp_object = objects_dir_ / (helpers::random_alphanum_string(20) + ".tmp");
+		} while (fs::exists(temp_object));
+
+		auto digest = helpers::sha1_file(src_name);
+		key = objects_dir_name + "/" + digest;
+		fs::path object = caching_dir_ / key;
+
+		{
+			cache_lock lock(caching_dir_ / lock_file_name, false);
+
+			// the same content may be already cached under different name, then nothing is copied
+			bool linked = false;
+			if (fs::exists(object)) {
+				fs::create_hard_link(object, temp_name, error);
+				linked = !error;
+			}
+			if (linked) {
+				logger_->debug("Content of file {} is already cached, it is stored only once", dst_name);
+			} else {
+				// first copy only temporary file, objects are read-only because they can be hardlinked to jobs
+				auto strategy = helpers::copy_file(src_name, temp_object);
+				auto write_perms = fs::perms::owner_write | fs::perms::group_write | fs::perms::others_write;
+				fs::permissions(temp_object, fs::perms::remove_perms | write_perms);
+				logger_->debug("File {} stored to cache using {}", dst_name, helpers::copy_strategy_name(strategy));
+				fs::rename(temp_object, object);
+				fs::create_hard_link(object, temp_name);
+			}
+
+			// and then move (atomically) the name to its original destination
+			fs::rename(temp_name, destination_file);
+		}
+#endif
+	} catch (std::exception &e) {
+		fs::remove(temp_name, error);
+		fs::remove(temp_object, error);
 		auto message = "Failed to copy file " + src_name + " to cache. Error: " + e.what();
 		logger_->warn(message);
 		throw fm_exception(message);
 	}
+	std::lock_guard<std::mutex> lock(mutex_);
+	forget_name(dst_name);
+	auto inserted = entries_.insert(std::make_pair(key, cache_entry()));
+	auto &entry = inserted.first->second;
+	if (inserted.second) {
+		entry.size = size;
+		total_size_ += size;
+	}
+	entry.last_used = std::time(nullptr);
+	entry.names.insert(dst_name);
+	aliases_[dst_name] = key;
+
+	if (max_size_ > 0 && total_size_ > max_size_) { evict(); }
 }
 
 std::string cache_manager::get_caching_dir() const
 {
 	return caching_dir_.string();
 }
+
+std::uintmax_t cache_manager::get_size() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return total_size_;
+}
+
+void cache_manager::load_index()
+{
+	entries_.clear();
+	aliases_.clear();
+	total_size_ = 0;
+
+#ifndef _WIN32
+	// objects are identified by inode numbers, so that the names can be matched with them
+	std::map<ino_t, std::string> objects;
+	struct stat info;
+#endif
+
+	try {
+#ifndef _WIN32
+		// there are no inode numbers on Windows, objects are not used there (see put_file())
+		if (fs::is_directory(objects_dir_)) {
+			for (auto &item : fs::directory_iterator(objects_dir_)) {
+				auto name = item.path().filename().string();
+				if (is_temp_file(name) || ::stat(item.path().c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+					continue;
+				}
+
+				auto key = objects_dir_name + "/" + name;
+				auto &entry = entries_[key];
+				entry.size = static_cast<std::uintmax_t>(info.st_size);
+				entry.last_used = info.st_mtime;
+				objects[info.st_ino] = key;
+			}
+		}
+#endif
+
+		for (auto &item : fs::directory_iterator(caching_dir_)) {
+			auto name = item.path().filename().string();
+			if (name == lock_file_name || is_temp_file(name)) { continue; }
+
+#ifndef _WIN32
+			if (::stat(item.path().c_str(), &info) != 0 || !S_ISREG(info.st_mode)) { continue; }
+
+			// files which are not linked to any object form standalone entries
+			auto object = objects.find(info.st_ino);
+			auto key = object != objects.end() ? object->second : name;
+			auto size = static_cast<std::uintmax_t>(info.st_size);
+			auto last_used = info.st_mtime;
+#else
+			// each name is standalone entry on Windows (see put_file())
+			boost::system::error_code error;
+			if (!fs::is_regular_file(item.symlink_status(error))) { continue; }
+
+			auto key = name;
+			auto size = fs::file_size(item.path(), error);
+			if (error) { continue; }
+			auto last_used = fs::last_write_time(item.path(), error);
+			if (error) { continue; }
+#endif
+
+			auto &entry = entries_[key];
+			entry.size = size;
+			entry.last_used = last_used;
+			entry.names.insert(name);
+			aliases_[name] = key;
+		}
+	} catch (fs::filesystem_error &e) {
+		logger_->warn("Cannot load index of the cache {}. Error: {}", caching_dir_.string(), e.what());
+	}
+
+	for (auto &entry : entries_) { total_size_ += entry.second.size; }
+}
+
+void cache_manager::evict()
+{
+	cache_lock lock(caching_dir_ / lock_file_name, true);
+
+	// other workers might have changed the cache meanwhile
+	load_index();
+	if (total_size_ <= max_size_) { return; }
+
+	// free a bit more space, so that the eviction does not happen with every new file
+	auto target_size = max_size_ - max_size_ / 10;
+
+	std::vector<std::pair<std::time_t, std::string>> order;
+	for (auto &entry : entries_) { order.emplace_back(entry.second.last_used, entry.first); }
+	std::sort(order.begin(), order.end());
+
+	std::size_t evicted = 0;
+	std::uintmax_t evicted_size = 0;
+	boost::system::error_code error;
+
+	for (auto &item : order) {
+		if (total_size_ <= target_size) { break; }
+
+		auto entry = entries_.find(item.second);
+		for (auto &name : entry->second.names) {
+			fs::remove(caching_dir_ / name, error);
+			aliases_.erase(name);
+		}
+		fs::remove(caching_dir_ / entry->first, error);
+
+		total_size_ -= entry->second.size;
+		evicted_size += entry->second.size;
+		++evicted;
+		entries_.erase(entry);
+	}
+
+	logger_->info("Cache exceeded its maximal size, {} least recently used files with {} bytes were evicted",
+		evicted,
+		evicted_size);
+}
+
+void cache_manager::forget_name(const std::string &name)
+{
+	auto alias = aliases_.find(name);
+	if (alias == aliases_.end()) { return; }
+
+	auto entry = entries_.find(alias->second);
+	if (entry != entries_.end()) {
+		entry->second.names.erase(name);
+		// standalone files are gone with their name, objects stay until they are evicted
+		if (entry->first == name) {
+			total_size_ -= entry->second.size;
+			entries_.erase(entry);
+		}
+	}
+	aliases_.erase(alias);
+}
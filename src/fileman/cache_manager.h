@@ -3,6 +3,11 @@
 
 #include <string>
 #include <memory>
+#include <map>
+#include <set>
+#include <mutex>
+#include <ctime>
+#include <cstdint>
 #include "file_manager_interface.h"
 #include "helpers/logger.h"
 
@@ -18,7 +23,19 @@ namespace fs = boost::filesystem;
  *
  * Cache is a directory inside host filesystem, where recently used files
  * are stored for some period of time. This directory could be the same for
- * more worker instances. Removing old files will do recodex-cleaner project.
+ * more worker instances. Content of the files is stored only once in the
+ * @a objects subdirectory under the SHA-1 digest of the content, names of the
+ * files are hard links to these objects placed directly in the cache directory.
+ * Windows has no inode numbers to match the names with the objects, so the
+ * content is stored under each name there and fetched files are never hardlinks.
+ * If maximal size of the cache is given, least recently used objects are
+ * evicted whenever the cache grows over the limit. Otherwise removing old
+ * files will do recodex-cleaner project.
+ *
+ * Index of the cache is kept in memory and rebuilt from the disk at startup and
+ * before each eviction, because other workers may change the directory meanwhile.
+ * All modifications are done by atomic renames, eviction is serialized by a lock
+ * file, so the workers sharing the directory never see a half-written file.
  * Failed operations throws @a fm_exception exception.
  */
 class cache_manager : public file_manager_interface
@@ -33,14 +50,20 @@ public:
 	 * Set up cache manager with working directory.
 	 * @param caching_dir Directory where cached files will be stored. If this directory don't exist, it'll be created.
 	 * @param logger Shared pointer to system logger (optional).
+	 * @param max_size Maximal size of the cache in bytes, zero means unlimited.
+	 * @param hardlinks If true, fetched files may be read-only hardlinks to the cache, when reflinks are not supported.
 	 */
-	cache_manager(const std::string &caching_dir, std::shared_ptr<spdlog::logger> logger = nullptr);
+	cache_manager(const std::string &caching_dir,
+		std::shared_ptr<spdlog::logger> logger = nullptr,
+		std::uintmax_t max_size = 0,
+		bool hardlinks = false);
 	/**
 	 * Destructor.
 	 */
 	~cache_manager() override = default;
 	/**
-	 * Copy a file from cache to destination.
+	 * Copy a file from cache to destination. Reflink, hardlink (if enabled) or in-kernel copying is used
+	 * whenever the filesystem supports it.
 	 * @param src_name Name of the file without path.
 	 * @param dst_name Name of the destination path with requested filename - the file
 	 *					can be renamed during fetching.
@@ -58,9 +81,59 @@ public:
 	 */
 	std::string get_caching_dir() const;
 
+	/**
+	 * Get size of all files in the cache as known from the in-memory index.
+	 * @return size in bytes
+	 */
+	std::uintmax_t get_size() const;
+
 private:
+	/**
+	 * Item of the cache index, one stored content with all its names.
+	 */
+	struct cache_entry {
+		/** Size of the content in bytes. */
+		std::uintmax_t size = 0;
+		/** Time of the last access. */
+		std::time_t last_used = 0;
+		/** Names in the caching directory which refer to this content. */
+		std::set<std::string> names;
+	};
+
+	/**
+	 * Build the index from the content of the caching directory.
+	 * Files which are not linked to any object (created by older workers) form standalone entries.
+	 * Caller has to hold the mutex.
+	 */
+	void load_index();
+	/**
+	 * Remove least recently used entries until the cache fits into the maximal size.
+	 * Caller has to hold the mutex.
+	 */
+	void evict();
+	/**
+	 * Remove name of the file from the index, standalone entries are removed completely.
+	 * Caller has to hold the mutex.
+	 * @param name name of the file in the caching directory
+	 */
+	void forget_name(const std::string &name);
+
 	/** Path to the caching directory. */
 	fs::path caching_dir_;
+	/** Path to the directory with content addressed objects. */
+	fs::path objects_dir_;
+	/** Maximal size of the cache in bytes, zero means unlimited. */
+	std::uintmax_t max_size_;
+	/** Whether the fetched files can be hardlinks to the cached objects. */
+	bool hardlinks_;
+	/** Entries of the index, the key is path relative to caching directory of the file holding the content. */
+	std::map<std::string, cache_entry> entries_;
+	/** Names of the files mapped to keys of their entries. */
+	std::map<std::string, std::string> aliases_;
+	/** Sum of sizes of all entries. */
+	std::uintmax_t total_size_ = 0;
+	/** Guards the index, the manager can be used from more threads. */
+	mutable std::mutex mutex_;
 	/** System or null logger. */
 	std::shared_ptr<spdlog::logger> logger_;
 };
@@ -19,6 +19,39 @@ void fallback_file_manager::get_file(const std::string &src_name, const std::str
 	primary_manager_->put_file(dst_name, src_name);
 }
 
+std::vector<std::exception_ptr> fallback_file_manager::get_files(
+	const std::vector<std::pair<std::string, std::string>> &files)
+{
+	std::vector<std::exception_ptr> results(files.size());
+	std::vector<std::pair<std::string, std::string>> missing;
+	std::vector<std::size_t> missing_positions;
+
+	for (std::size_t i = 0; i < files.size(); ++i) {
+		try {
+			primary_manager_->get_file(files[i].first, files[i].second);
+		} catch (...) {
+			missing.push_back(files[i]);
+			missing_positions.push_back(i);
+		}
+	}
+	if (missing.empty()) { return results; }
+
+	auto downloaded = secondary_manager_->get_files(missing);
+	for (std::size_t i = 0; i < missing.size(); ++i) {
+		auto position = missing_positions[i];
+		results[position] = downloaded[i];
+		if (downloaded[i]) { continue; }
+
+		try {
+			primary_manager_->put_file(missing[i].second, missing[i].first);
+		} catch (...) {
+			results[position] = std::current_exception();
+		}
+	}
+
+	return results;
+}
+
 void fallback_file_manager::put_file(const std::string &src_name, const std::string &dst_url)
 {
 	secondary_manager_->put_file(src_name, dst_url);
@@ -46,6 +46,14 @@ public:
 	 */
 	void get_file(const std::string &src_name, const std::string &dst_name) override;
 
+	/**
+	 * Get more files at once. Files which are not in cache are requested from the secondary manager
+	 * in one batch and saved to cache afterwards.
+	 * @param files pairs of source name and destination path
+	 * @return for each file null pointer on success or the exception which caused the failure
+	 */
+	std::vector<std::exception_ptr> get_files(const std::vector<std::pair<std::string, std::string>> &files) override;
+
 	/**
 	 * Save file using only secondary manager (i.e. upload file to remote server).
 	 * It won't be saved to cache.
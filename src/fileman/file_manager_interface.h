@@ -3,6 +3,14 @@
 
 #include <string>
 #include <exception>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <fstream>
+
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+#define BOOST_NO_CXX11_SCOPED_ENUMS
+#include <boost/filesystem.hpp>
 
 
 /**
@@ -32,6 +40,45 @@ public:
 	 * @param dst_path Where the file should be stored.
 	 */
 	virtual void put_file(const std::string &src_name, const std::string &dst_path) = 0;
+
+	/**
+	 * Get more files at once. Managers which can transfer the files concurrently override it,
+	 * the default implementation gets the files one after another.
+	 * @param files pairs of source name and destination path with the same meaning as in @ref get_file
+	 * @return for each file null pointer on success or the exception which @ref get_file would throw
+	 */
+	virtual std::vector<std::exception_ptr> get_files(const std::vector<std::pair<std::string, std::string>> &files)
+	{
+		std::vector<std::exception_ptr> results;
+		for (auto &file : files) {
+			try {
+				get_file(file.first, file.second);
+				results.push_back(nullptr);
+			} catch (...) {
+				results.push_back(std::current_exception());
+			}
+		}
+		return results;
+	}
+
+	/**
+	 * Open the file for sequential reading. Managers which can process the content during the transfer
+	 * override it, the default implementation gets the whole file into a temporary file first.
+	 * @param src_name Name of the file to retrieve, same as in @ref get_file.
+	 * @return stream with the content of the file
+	 */
+	virtual std::unique_ptr<std::istream> open_file(const std::string &src_name)
+	{
+		namespace fs = boost::filesystem;
+		auto temp = fs::temp_directory_path() / fs::unique_path("recodex-%%%%-%%%%-%%%%-%%%%");
+		get_file(src_name, temp.string());
+
+		std::unique_ptr<std::istream> result(new std::ifstream(temp.string(), std::ios::binary));
+		// content stays available until the stream is closed
+		boost::system::error_code error;
+		fs::remove(temp, error);
+		return result;
+	}
 };
 
 
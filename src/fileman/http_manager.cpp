@@ -1,7 +1,10 @@
 #include "http_manager.h"
+#include "helpers/metrics.h"
 #include <stdio.h>
 #include <curl/curl.h>
 #include <regex>
+#include <istream>
+#include <streambuf>
 
 #define BOOST_FILESYSTEM_NO_DEPRECATED
 #define BOOST_NO_CXX11_SCOPED_ENUMS
@@ -38,6 +41,106 @@ namespace
 		return size * nmemb;
 	}
 
+	// Maximal number of connections opened by one batch of downloads
+	const long max_parallel_downloads = 8;
+
+	// Locking of the data shared by curl handles, user pointer is an array of mutexes
+	void share_lock(CURL *, curl_lock_data data, curl_lock_access, void *userptr)
+	{
+		static_cast<std::mutex *>(userptr)[data].lock();
+	}
+
+	void share_unlock(CURL *, curl_lock_data data, void *userptr)
+	{
+		static_cast<std::mutex *>(userptr)[data].unlock();
+	}
+
+	/**
+	 * Stream buffer filled by the running download. Transfer is driven by curl multi interface whenever
+	 * the reader needs more data, so no other thread is needed and nothing is stored on disk.
+	 */
+	class download_streambuf : public std::streambuf
+	{
+	public:
+		using handle_ptr = std::unique_ptr<CURL, std::function<void(CURL *)>>;
+		using finish_fn = std::function<void(CURL *, CURLcode)>;
+
+		download_streambuf(handle_ptr curl, finish_fn finish)
+			: curl_(std::move(curl)), multi_(curl_multi_init(), curl_multi_cleanup), finish_(finish)
+		{
+			if (!multi_.get()) { throw fm_exception("Cannot initialize download"); }
+
+			curl_easy_setopt(curl_.get(), CURLOPT_WRITEDATA, this);
+			curl_easy_setopt(curl_.get(), CURLOPT_WRITEFUNCTION, write_data);
+			curl_multi_add_handle(multi_.get(), curl_.get());
+		}
+
+		~download_streambuf() override
+		{
+			curl_multi_remove_handle(multi_.get(), curl_.get());
+		}
+
+	protected:
+		int_type underflow() override
+		{
+			if (gptr() < egptr()) { return traits_type::to_int_type(*gptr()); }
+
+			// previous chunk is consumed, transfer continues until next one arrives
+			buffer_.clear();
+			while (buffer_.empty() && !done_) { perform(); }
+			if (buffer_.empty()) { return traits_type::eof(); }
+
+			setg(&buffer_[0], &buffer_[0], &buffer_[0] + buffer_.size());
+			return traits_type::to_int_type(*gptr());
+		}
+
+	private:
+		void perform()
+		{
+			int running = 0;
+			curl_multi_perform(multi_.get(), &running);
+
+			CURLMsg *message;
+			int remaining;
+			while ((message = curl_multi_info_read(multi_.get(), &remaining)) != nullptr) {
+				if (message->msg != CURLMSG_DONE) { continue; }
+				done_ = true;
+				finish_(curl_.get(), message->data.result);
+			}
+
+			if (!done_ && buffer_.empty()) { curl_multi_wait(multi_.get(), nullptr, 0, 1000, nullptr); }
+		}
+
+		static std::size_t write_data(char *ptr, std::size_t size, std::size_t nmemb, void *userdata)
+		{
+			static_cast<download_streambuf *>(userdata)->buffer_.append(ptr, size * nmemb);
+			return size * nmemb;
+		}
+
+		handle_ptr curl_;
+		std::unique_ptr<CURLM, decltype(&curl_multi_cleanup)> multi_;
+		finish_fn finish_;
+		std::string buffer_;
+		bool done_ = false;
+	};
+
+	/**
+	 * Input stream which owns its download buffer, failures of the transfer are thrown to the reader.
+	 */
+	class download_stream : public std::istream
+	{
+	public:
+		download_stream(download_streambuf::handle_ptr curl, download_streambuf::finish_fn finish)
+			: std::istream(nullptr), buffer_(std::move(curl), finish)
+		{
+			rdbuf(&buffer_);
+			exceptions(std::ios::badbit);
+		}
+
+	private:
+		download_streambuf buffer_;
+	};
+
 } // namespace
 
 // Tweak for older libcurls
@@ -48,12 +151,21 @@ namespace
 
 http_manager::http_manager(std::shared_ptr<spdlog::logger> logger) : logger_(logger)
 {
+	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
+	init_share();
 }
 
 http_manager::http_manager(const std::vector<fileman_config> &configs, std::shared_ptr<spdlog::logger> logger)
 	: configs_(configs), logger_(logger)
 {
 	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
+	init_share();
+}
+
+http_manager::~http_manager()
+{
+	for (auto handle : idle_handles_) { curl_easy_cleanup(handle); }
+	if (share_ != nullptr) { curl_share_cleanup(share_); }
 }
 
 void http_manager::get_file(const std::string &src_name, const std::string &dst_name)
@@ -61,74 +173,108 @@ void http_manager::get_file(const std::string &src_name, const std::string &dst_
 	logger_->debug("Downloading file {} to {}", src_name, dst_name);
 
 	// Open file to download
-	std::unique_ptr<FILE, decltype(&fclose)> fd = {fopen(dst_name.c_str(), "wb"), fclose};
-	if (!fd.get()) {
-		auto message = "Cannot open file " + dst_name + " for writing.";
-		logger_->warn(message);
-		throw fm_exception(message);
-	}
+	auto fd = open_destination(dst_name);
 
-	std::unique_ptr<CURL, decltype(&curl_easy_cleanup)> curl = {curl_easy_init(), curl_easy_cleanup};
+	auto curl = acquire_handle(src_name);
 	if (curl.get()) {
-		// Destination URL
-		curl_easy_setopt(curl.get(), CURLOPT_URL, (src_name).c_str());
-
 		// Set where to write data to
 		curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, fd.get());
 		// Use custom write function (because of Windows DLL issue)
-		curl_easy_setopt(curl.get(), CURLOPT_READFUNCTION, fwrite_wrapper);
+		curl_easy_setopt(curl.get(), CURLOPT_WRITEFUNCTION, fwrite_wrapper);
 
-#ifdef _WIN32 // Windows needs to have explicitly defined certificate bundle
-		curl_easy_setopt(curl.get(), CURLOPT_CAINFO, "curl-ca-bundle.crt");
-#endif
-
-		// Follow redirects
-		curl_easy_setopt(curl.get(), CURLOPT_FOLLOWLOCATION, 1L);
-		// Ennable support for HTTP2
-		curl_easy_setopt(curl.get(), CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
-		// We have trusted HTTPS certificate, so set validation on
-		curl_easy_setopt(curl.get(), CURLOPT_SSL_VERIFYPEER, 1L);
-		curl_easy_setopt(curl.get(), CURLOPT_SSL_VERIFYHOST, 2L);
-		// Throw exception on HTTP responses >= 400
-		curl_easy_setopt(curl.get(), CURLOPT_FAILONERROR, 1L);
-
-		// Set HTTP authentication
-		auto config = find_config(src_name);
-
-		if (config != nullptr) {
-			curl_easy_setopt(curl.get(), CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
-			curl_easy_setopt(curl.get(), CURLOPT_USERPWD, (config->username + ":" + config->password).c_str());
-		}
+		CURLcode res = curl_easy_perform(curl.get());
+		fd.reset();
+		finish_download(curl.get(), res, src_name, dst_name);
+	}
+}
 
-		// Enable verbose for easier tracing
-		// curl_easy_setopt(curl.get(), CURLOPT_VERBOSE, 1L);
+std::unique_ptr<std::istream> http_manager::open_file(const std::string &src_name)
+{
+	logger_->debug("Streaming file {}", src_name);
 
-		CURLcode res = curl_easy_perform(curl.get());
+	auto curl = acquire_handle(src_name);
+	if (!curl.get()) { throw fm_exception("Cannot initialize download of " + src_name); }
 
-		// Check for errors
+	auto finish = [this, src_name](CURL *handle, CURLcode res) {
 		if (res != CURLE_OK) {
-			try {
-				fs::remove(dst_name);
-			} catch (...) {
-			}
 			long response_code;
-			curl_easy_getinfo(curl.get(), CURLINFO_RESPONSE_CODE, &response_code);
-			auto error_message = "Failed to download " + src_name + " to " + dst_name + ". Error: (" +
-				std::to_string(response_code) + ") " + curl_easy_strerror(res);
+			curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &response_code);
+			auto error_message = "Failed to download " + src_name + ". Error: (" + std::to_string(response_code) +
+				") " + curl_easy_strerror(res);
 			logger_->warn(error_message);
 			throw fm_exception(error_message);
 		}
+		log_timings(handle, src_name);
+		count_fetched(handle);
+	};
+
+	return std::unique_ptr<std::istream>(new download_stream(std::move(curl), finish));
+}
 
-		// set write permissions to downloaded file
+std::vector<std::exception_ptr> http_manager::get_files(const std::vector<std::pair<std::string, std::string>> &files)
+{
+	std::unique_ptr<CURLM, decltype(&curl_multi_cleanup)> multi = {curl_multi_init(), curl_multi_cleanup};
+	if (!multi.get()) { return file_manager_interface::get_files(files); }
+
+	curl_multi_setopt(multi.get(), CURLMOPT_MAX_TOTAL_CONNECTIONS, max_parallel_downloads);
+#ifdef CURLPIPE_MULTIPLEX
+	curl_multi_setopt(multi.get(), CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+
+	struct download {
+		handle_ptr curl;
+		std::unique_ptr<FILE, decltype(&fclose)> fd;
+	};
+	std::vector<download> downloads;
+	std::vector<std::exception_ptr> results(files.size());
+
+	for (std::size_t i = 0; i < files.size(); ++i) {
+		logger_->debug("Downloading file {} to {}", files[i].first, files[i].second);
 		try {
-			fs::permissions(fs::path(dst_name),
-				fs::perms::add_perms | fs::perms::owner_write | fs::perms::group_write | fs::perms::others_write);
-		} catch (fs::filesystem_error &e) {
-			auto message = "Failed to set write permissions on '" + dst_name + "'. Error: " + e.what();
-			logger_->warn(message);
-			throw fm_exception(message);
+			auto fd = open_destination(files[i].second);
+			auto curl = acquire_handle(files[i].first);
+			if (!curl.get()) { throw fm_exception("Cannot initialize download of " + files[i].first); }
+
+			curl_easy_setopt(curl.get(), CURLOPT_WRITEDATA, fd.get());
+			curl_easy_setopt(curl.get(), CURLOPT_WRITEFUNCTION, fwrite_wrapper);
+			curl_easy_setopt(curl.get(), CURLOPT_PRIVATE, reinterpret_cast<char *>(i));
+			curl_multi_add_handle(multi.get(), curl.get());
+			downloads.push_back(download{std::move(curl), std::move(fd)});
+		} catch (...) {
+			results[i] = std::current_exception();
+			downloads.push_back(download{handle_ptr(), {nullptr, fclose}});
 		}
 	}
+
+	// all transfers run at once, finished ones are checked after every round
+	int running = 0;
+	do {
+		curl_multi_perform(multi.get(), &running);
+
+		CURLMsg *message;
+		int remaining;
+		while ((message = curl_multi_info_read(multi.get(), &remaining)) != nullptr) {
+			if (message->msg != CURLMSG_DONE) { continue; }
+
+			char *position;
+			curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &position);
+			auto i = reinterpret_cast<std::size_t>(position);
+			auto res = message->data.result;
+
+			curl_multi_remove_handle(multi.get(), message->easy_handle);
+			downloads[i].fd.reset();
+			try {
+				finish_download(downloads[i].curl.get(), res, files[i].first, files[i].second);
+			} catch (...) {
+				results[i] = std::current_exception();
+			}
+			downloads[i].curl.reset();
+		}
+
+		if (running > 0) { curl_multi_wait(multi.get(), nullptr, 0, 1000, nullptr); }
+	} while (running > 0);
+
+	return results;
 }
 
 void http_manager::put_file(const std::string &src_name, const std::string &dst_url)
@@ -148,11 +294,8 @@ void http_manager::put_file(const std::string &src_name, const std::string &dst_
 	// Get the file size
 	auto filesize = fs::file_size(source_file);
 
-	std::unique_ptr<CURL, decltype(&curl_easy_cleanup)> curl = {curl_easy_init(), curl_easy_cleanup};
+	auto curl = acquire_handle(dst_url);
 	if (curl.get()) {
-		// Destination URL
-		curl_easy_setopt(curl.get(), CURLOPT_URL, dst_url.c_str());
-
 		// Upload mode
 		curl_easy_setopt(curl.get(), CURLOPT_UPLOAD, 1L);
 
@@ -167,31 +310,6 @@ void http_manager::put_file(const std::string &src_name, const std::string &dst_
 		// Better give size of uploaded file
 		curl_easy_setopt(curl.get(), CURLOPT_INFILESIZE_LARGE, (curl_off_t) filesize);
 
-#ifdef _WIN32 // Windows needs to have explicitly defined certificate bundle
-		curl_easy_setopt(curl.get(), CURLOPT_CAINFO, "curl-ca-bundle.crt");
-#endif
-
-		// Follow redirects
-		curl_easy_setopt(curl.get(), CURLOPT_FOLLOWLOCATION, 1L);
-		// Ennable support for HTTP2
-		curl_easy_setopt(curl.get(), CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
-		// Trusted HTTPS certificate is not problem (see Let's Encrypt project), so set validation on
-		curl_easy_setopt(curl.get(), CURLOPT_SSL_VERIFYPEER, 1L);
-		curl_easy_setopt(curl.get(), CURLOPT_SSL_VERIFYHOST, 2L);
-		// Throw exception on HTTP responses >= 400
-		curl_easy_setopt(curl.get(), CURLOPT_FAILONERROR, 1L);
-
-		// Set HTTP authentication
-		auto config = find_config(dst_url);
-
-		if (config != nullptr) {
-			curl_easy_setopt(curl.get(), CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
-			curl_easy_setopt(curl.get(), CURLOPT_USERPWD, (config->username + ":" + config->password).c_str());
-		}
-
-		// Enable verbose for easier tracing
-		// curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
-
 		CURLcode res = curl_easy_perform(curl.get());
 
 		// Check for errors
@@ -203,9 +321,151 @@ void http_manager::put_file(const std::string &src_name, const std::string &dst_
 			logger_->warn(message);
 			throw fm_exception(message);
 		}
+		log_timings(curl.get(), dst_url);
 	}
 }
 
+void http_manager::init_share()
+{
+	share_ = curl_share_init();
+	if (share_ == nullptr) { return; }
+
+	curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, share_lock);
+	curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, share_unlock);
+	curl_share_setopt(share_, CURLSHOPT_USERDATA, share_mutexes_);
+	curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	// connections are not shared, libcurl does not support it for handles used concurrently in more threads,
+	// so they are kept alive by the pooled handles themselves
+}
+
+http_manager::handle_ptr http_manager::acquire_handle(const std::string &url)
+{
+	CURL *handle = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(handles_mutex_);
+		if (!idle_handles_.empty()) {
+			handle = idle_handles_.back();
+			idle_handles_.pop_back();
+		}
+	}
+
+	// reset keeps connections and caches of the handle, only options are cleared
+	if (handle != nullptr) {
+		curl_easy_reset(handle);
+	} else {
+		handle = curl_easy_init();
+	}
+
+	handle_ptr curl(handle, [this](CURL *released) {
+		if (released == nullptr) { return; }
+		std::lock_guard<std::mutex> lock(handles_mutex_);
+		idle_handles_.push_back(released);
+	});
+	if (!curl) { return curl; }
+
+	// Destination URL
+	curl_easy_setopt(curl.get(), CURLOPT_URL, url.c_str());
+	if (share_ != nullptr) { curl_easy_setopt(curl.get(), CURLOPT_SHARE, share_); }
+
+#ifdef _WIN32 // Windows needs to have explicitly defined certificate bundle
+	curl_easy_setopt(curl.get(), CURLOPT_CAINFO, "curl-ca-bundle.crt");
+#endif
+
+	// Follow redirects
+	curl_easy_setopt(curl.get(), CURLOPT_FOLLOWLOCATION, 1L);
+	// Ennable support for HTTP2
+	curl_easy_setopt(curl.get(), CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_0);
+	// Trusted HTTPS certificate is not problem (see Let's Encrypt project), so set validation on
+	curl_easy_setopt(curl.get(), CURLOPT_SSL_VERIFYPEER, 1L);
+	curl_easy_setopt(curl.get(), CURLOPT_SSL_VERIFYHOST, 2L);
+	// Throw exception on HTTP responses >= 400
+	curl_easy_setopt(curl.get(), CURLOPT_FAILONERROR, 1L);
+
+	// Set HTTP authentication
+	auto config = find_config(url);
+
+	if (config != nullptr) {
+		curl_easy_setopt(curl.get(), CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+		curl_easy_setopt(curl.get(), CURLOPT_USERPWD, (config->username + ":" + config->password).c_str());
+	}
+
+	// Enable verbose for easier tracing
+	// curl_easy_setopt(curl.get(), CURLOPT_VERBOSE, 1L);
+
+	return curl;
+}
+
+std::unique_ptr<FILE, decltype(&fclose)> http_manager::open_destination(const std::string &dst_name)
+{
+	std::unique_ptr<FILE, decltype(&fclose)> fd = {fopen(dst_name.c_str(), "wb"), fclose};
+	if (!fd.get()) {
+		auto message = "Cannot open file " + dst_name + " for writing.";
+		logger_->warn(message);
+		throw fm_exception(message);
+	}
+	return fd;
+}
+
+void http_manager::finish_download(CURL *curl, CURLcode res, const std::string &src_name, const std::string &dst_name)
+{
+	// Check for errors
+	if (res != CURLE_OK) {
+		try {
+			fs::remove(dst_name);
+		} catch (...) {
+		}
+		long response_code;
+		curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+		auto error_message = "Failed to download " + src_name + " to " + dst_name + ". Error: (" +
+			std::to_string(response_code) + ") " + curl_easy_strerror(res);
+		logger_->warn(error_message);
+		throw fm_exception(error_message);
+	}
+	log_timings(curl, src_name);
+	count_fetched(curl);
+
+	// set write permissions to downloaded file
+	try {
+		fs::permissions(fs::path(dst_name),
+			fs::perms::add_perms | fs::perms::owner_write | fs::perms::group_write | fs::perms::others_write);
+	} catch (fs::filesystem_error &e) {
+		auto message = "Failed to set write permissions on '" + dst_name + "'. Error: " + e.what();
+		logger_->warn(message);
+		throw fm_exception(message);
+	}
+}
+
+void http_manager::log_timings(CURL *curl, const std::string &url)
+{
+	// all times are measured from the start of the transfer
+	double dns = 0, connect = 0, tls = 0, first_byte = 0, total = 0;
+	long connects = 0;
+	curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME, &dns);
+	curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME, &connect);
+	curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME, &tls);
+	curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME, &first_byte);
+	curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &total);
+	curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+
+	auto ms = [](double seconds) { return static_cast<long>(seconds * 1000); };
+	logger_->debug("Transfer of {} took {} ms (dns {} ms, connect {} ms, tls {} ms, first byte {} ms), {}",
+		url,
+		ms(total),
+		ms(dns),
+		ms(connect),
+		ms(tls),
+		ms(first_byte),
+		connects == 0 ? "connection reused" : "new connection");
+}
+
+void http_manager::count_fetched(CURL *curl)
+{
+	double fetched = 0;
+	curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD, &fetched);
+	if (fetched > 0) { helpers::metrics().fetched_bytes.add(static_cast<std::uint64_t>(fetched)); }
+}
+
 const fileman_config *http_manager::find_config(const std::string &url) const
 {
 	for (const auto &item : configs_) {
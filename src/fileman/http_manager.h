@@ -3,6 +3,10 @@
 
 #include <string>
 #include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+#include <curl/curl.h>
 #include "file_manager_interface.h"
 #include "helpers/logger.h"
 #include "config/fileman_config.h"
@@ -15,6 +19,11 @@
  * and HTTP/2 protocol with fallback to 1.1 version. Also, HTTP authentication
  * is used when right configs are provided. HTTP status codes above 400 are
  * interpreted as strict error.
+ * Curl handles are kept after the transfer and reused, each of them keeps its own connections alive,
+ * so consecutive transfers to the same file server use the same connection. Only DNS cache and TLS
+ * session cache are shared by all handles (libcurl does not support sharing of connections by handles
+ * used in more threads at once). The manager can be used from more threads at once, each thread uses
+ * its own handles.
  * Failed operations throws @ref fm_exception exception.
  */
 class http_manager : public file_manager_interface
@@ -32,9 +41,9 @@ public:
 	 */
 	http_manager(const std::vector<fileman_config> &configs, std::shared_ptr<spdlog::logger> logger = nullptr);
 	/**
-	 * Destructor.
+	 * Destructor, closes all kept connections.
 	 */
-	~http_manager() override = default;
+	~http_manager() override;
 
 	/**
 	 * Get and save file locally.
@@ -43,6 +52,18 @@ public:
 	 *					be renamed during fetching.
 	 */
 	void get_file(const std::string &src_name, const std::string &dst_name) override;
+	/**
+	 * Download more files concurrently using curl multi interface.
+	 * @param files pairs of requested file name and destination path, same as in @ref get_file
+	 * @return for each file null pointer on success or the exception which caused the failure
+	 */
+	std::vector<std::exception_ptr> get_files(const std::vector<std::pair<std::string, std::string>> &files) override;
+	/**
+	 * Download file as a stream, the transfer proceeds as the data are read and nothing is stored on disk.
+	 * @param src_name Name of requested file (without path)
+	 * @return stream with the content of the file, it throws @ref fm_exception if the transfer fails
+	 */
+	std::unique_ptr<std::istream> open_file(const std::string &src_name) override;
 	/**
 	 * Upload file to remote server with HTTP PUT method.
 	 * @param src_name Name with path to a file to upload.
@@ -61,8 +82,57 @@ protected:
 	const fileman_config *find_config(const std::string &url) const;
 
 private:
+	/** Curl handle which is returned to the idle handles when it is released. */
+	using handle_ptr = std::unique_ptr<CURL, std::function<void(CURL *)>>;
+
+	/**
+	 * Create share object for the curl handles.
+	 */
+	void init_share();
+	/**
+	 * Get idle handle or create new one and set options common for all transfers.
+	 * @param url URL of the transfer, used also for finding the credentials
+	 * @return handle which is returned for reuse when destroyed, or null pointer on error
+	 */
+	handle_ptr acquire_handle(const std::string &url);
+	/**
+	 * Open destination file of a download.
+	 * @param dst_name path to the file
+	 * @return opened file
+	 * @throws fm_exception if the file cannot be opened
+	 */
+	std::unique_ptr<FILE, decltype(&fclose)> open_destination(const std::string &dst_name);
+	/**
+	 * Check result of finished download, remove the file on failure or set its permissions otherwise.
+	 * @param curl handle of the transfer
+	 * @param res result of the transfer
+	 * @param src_name requested file name
+	 * @param dst_name path to the downloaded file, which has to be closed already
+	 * @throws fm_exception if the download failed
+	 */
+	void finish_download(CURL *curl, CURLcode res, const std::string &src_name, const std::string &dst_name);
+	/**
+	 * Log durations of phases of finished transfer.
+	 * @param curl handle of the transfer
+	 * @param url URL of the transfer
+	 */
+	void log_timings(CURL *curl, const std::string &url);
+	/**
+	 * Add size of finished download to the metrics of the worker.
+	 * @param curl handle of the transfer
+	 */
+	void count_fetched(CURL *curl);
+
 	/** Credentials for each server HTTP Auth. */
 	const std::vector<fileman_config> configs_;
+	/** Handles which are not used at the moment, they keep their connections alive. */
+	std::vector<CURL *> idle_handles_;
+	/** Guards the idle handles. */
+	std::mutex handles_mutex_;
+	/** DNS and TLS session caches shared by all handles of this manager. */
+	CURLSH *share_ = nullptr;
+	/** Locks of the shared data, indexed by curl_lock_data. */
+	std::mutex share_mutexes_[CURL_LOCK_DATA_LAST];
 	/** System or null logger. */
 	std::shared_ptr<spdlog::logger> logger_;
 };
@@ -10,6 +10,14 @@ void prefixed_file_manager::get_file(const std::string &src_name, const std::str
 	fm_->get_file(prefix_ + src_name, dst_name);
 }
 
+std::vector<std::exception_ptr> prefixed_file_manager::get_files(
+	const std::vector<std::pair<std::string, std::string>> &files)
+{
+	std::vector<std::pair<std::string, std::string>> prefixed;
+	for (auto &file : files) { prefixed.emplace_back(prefix_ + file.first, file.second); }
+	return fm_->get_files(prefixed);
+}
+
 void prefixed_file_manager::put_file(const std::string &src_name, const std::string &dst_name)
 {
 	fm_->put_file(src_name, prefix_ + dst_name);
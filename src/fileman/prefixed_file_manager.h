@@ -43,6 +43,15 @@ public:
 	 */
 	void get_file(const std::string &src_name, const std::string &dst_name) override;
 
+	/**
+	 * Get more files at once. All source names get prefixed before calling base manager's
+	 * get_files method.
+	 *
+	 * @param files Pairs of source and destination files - same as underlying file manager
+	 * @return Results of the underlying file manager
+	 */
+	std::vector<std::exception_ptr> get_files(const std::vector<std::pair<std::string, std::string>> &files) override;
+
 	/**
 	 * Put file. This method has same semantics and arguments as underlying
 	 * file manager, but @a dst_name argument gets prefixed before calling
@@ -142,6 +142,12 @@ std::shared_ptr<job_metadata> helpers::build_job_metadata(const YAML::Node &conf
 				if (ctask["sandbox"]["working-directory"] && ctask["sandbox"]["working-directory"].IsScalar()) {
 					sandbox->working_directory = ctask["sandbox"]["working-directory"].as<std::string>();
 				} // can be ommited... no throw
+				if (ctask["sandbox"]["batch"] && ctask["sandbox"]["batch"].IsScalar()) {
+					sandbox->batch = ctask["sandbox"]["batch"].as<std::string>();
+				} // can be ommited... no throw
+				if (ctask["sandbox"]["output-files"] && ctask["sandbox"]["output-files"].IsSequence()) {
+					sandbox->output_files = ctask["sandbox"]["output-files"].as<std::vector<std::string>>();
+				} // can be ommited... no throw
 
 				// load limits... if they are supplied
 				if (ctask["sandbox"]["limits"]) {
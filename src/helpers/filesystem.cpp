@@ -1,5 +1,183 @@
 #include "filesystem.h"
 #include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <vector>
+
+#ifndef _WIN32
+#include <acl/libacl.h>
+#include <fcntl.h>
+#include <sys/acl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
+
+const char *helpers::copy_strategy_name(copy_strategy strategy)
+{
+	switch (strategy) {
+	case copy_strategy::REFLINK: return "reflink";
+	case copy_strategy::HARDLINK: return "hardlink";
+	case copy_strategy::COPY_RANGE: return "copy_file_range";
+	default: return "copy";
+	}
+}
+
+#ifndef _WIN32
+namespace
+{
+	/**
+	 * File descriptor closed in destructor.
+	 */
+	class file_descriptor
+	{
+	public:
+		explicit file_descriptor(int fd) : fd_(fd)
+		{
+		}
+		~file_descriptor()
+		{
+			if (fd_ >= 0) { close(fd_); }
+		}
+		int get() const
+		{
+			return fd_;
+		}
+
+	private:
+		int fd_;
+	};
+
+	void throw_copy_error(const fs::path &src, const fs::path &dest, const std::string &operation)
+	{
+		throw helpers::filesystem_exception("helpers::copy_file: Cannot copy '" + src.string() + "' to '" +
+			dest.string() + "', " + operation + " failed: " + std::strerror(errno));
+	}
+
+	/**
+	 * Copy data between file descriptors by the kernel.
+	 * @return false if nothing was copied because the kernel or filesystem does not support it
+	 */
+	bool copy_range(int in, int out, std::size_t size)
+	{
+#ifdef SYS_copy_file_range
+		bool first = true;
+		while (size > 0) {
+			auto copied = syscall(SYS_copy_file_range, in, nullptr, out, nullptr, size, 0);
+			if (copied < 0 && first && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+				return false;
+			}
+			if (copied < 0 && errno == EINTR) { continue; }
+			if (copied <= 0) { return copied == 0; }
+			size -= static_cast<std::size_t>(copied);
+			first = false;
+		}
+		return true;
+#else
+		return false;
+#endif
+	}
+} // namespace
+
+helpers::copy_strategy helpers::copy_file(const fs::path &src, const fs::path &dest, bool allow_hardlink)
+{
+	file_descriptor in(open(src.c_str(), O_RDONLY | O_CLOEXEC));
+	struct stat info;
+	if (in.get() < 0 || fstat(in.get(), &info) != 0) { throw_copy_error(src, dest, "opening source"); }
+	if (!S_ISREG(info.st_mode)) {
+		throw filesystem_exception("helpers::copy_file: Source is not a regular file '" + src.string() + "'");
+	}
+
+	// destination is unlinked first, it might be hardlink to another file which must not be overwritten
+	if (unlink(dest.c_str()) != 0 && errno != ENOENT) { throw_copy_error(src, dest, "removing destination"); }
+	std::unique_ptr<file_descriptor> out(
+		new file_descriptor(open(dest.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, info.st_mode & 07777)));
+	if (out->get() < 0) { throw_copy_error(src, dest, "creating destination"); }
+
+#ifdef FICLONE
+	if (ioctl(out->get(), FICLONE, in.get()) == 0) { return copy_strategy::REFLINK; }
+#endif
+
+	if (allow_hardlink) {
+		out.reset();
+		unlink(dest.c_str());
+		if (link(src.c_str(), dest.c_str()) == 0) { return copy_strategy::HARDLINK; }
+		out.reset(
+			new file_descriptor(open(dest.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, info.st_mode & 07777)));
+		if (out->get() < 0) { throw_copy_error(src, dest, "creating destination"); }
+	}
+
+	if (copy_range(in.get(), out->get(), static_cast<std::size_t>(info.st_size))) {
+		return copy_strategy::COPY_RANGE;
+	} else if (errno != ENOSYS && errno != EXDEV && errno != EINVAL && errno != EOPNOTSUPP) {
+		throw_copy_error(src, dest, "copy_file_range");
+	}
+
+	// plain copying through user space buffer
+	std::vector<char> buffer(65536);
+	while (true) {
+		auto count = read(in.get(), buffer.data(), buffer.size());
+		if (count < 0 && errno == EINTR) { continue; }
+		if (count < 0) { throw_copy_error(src, dest, "reading"); }
+		if (count == 0) { break; }
+		for (ssize_t written = 0; written < count;) {
+			auto result = write(out->get(), buffer.data() + written, static_cast<std::size_t>(count - written));
+			if (result < 0 && errno == EINTR) { continue; }
+			if (result < 0) { throw_copy_error(src, dest, "writing"); }
+			written += result;
+		}
+	}
+	return copy_strategy::COPY;
+}
+#else
+helpers::copy_strategy helpers::copy_file(const fs::path &src, const fs::path &dest, bool allow_hardlink)
+{
+	try {
+		if (allow_hardlink) {
+			boost::system::error_code ec;
+			fs::remove(dest, ec);
+			fs::create_hard_link(src, dest, ec);
+			if (!ec) { return copy_strategy::HARDLINK; }
+		}
+		fs::copy_file(src, dest, fs::copy_option::overwrite_if_exists);
+	} catch (fs::filesystem_error &e) {
+		throw filesystem_exception("helpers::copy_file: Error in copying file: " + std::string(e.what()));
+	}
+	return copy_strategy::COPY;
+}
+#endif
+
+bool helpers::unshare_file(const fs::path &file)
+{
+	std::uintmax_t links;
+	try {
+		if (!fs::is_regular_file(fs::symlink_status(file))) { return false; }
+		links = fs::hard_link_count(file);
+	} catch (fs::filesystem_error &e) {
+		throw filesystem_exception("helpers::unshare_file: Error in inspecting file: " + std::string(e.what()));
+	}
+	if (links <= 1) { return false; }
+
+	// copy is made next to the file and renamed over it, so the file is never missing
+	fs::path temp = file;
+	temp += ".unshare";
+	helpers::copy_file(file, temp);
+	try {
+		fs::rename(temp, file);
+	} catch (fs::filesystem_error &e) {
+		boost::system::error_code error;
+		fs::remove(temp, error);
+		throw filesystem_exception("helpers::unshare_file: Error in replacing file: " + std::string(e.what()));
+	}
+	return true;
+}
 
 void helpers::copy_directory(const fs::path &src, const fs::path &dest)
 {
@@ -30,6 +208,215 @@ void helpers::copy_directory(const fs::path &src, const fs::path &dest)
 	return;
 }
 
+bool helpers::rename_directory_content(const fs::path &src, const fs::path &dest)
+{
+	bool first = true;
+	try {
+		fs::directory_iterator endit;
+		for (fs::directory_iterator it(src); it != endit; ++it) {
+			try {
+				fs::rename(it->path(), dest / it->path().filename());
+			} catch (fs::filesystem_error &e) {
+				// different filesystems are detected on the first item, so nothing is moved yet
+				if (first && e.code() == boost::system::errc::cross_device_link) { return false; }
+				throw;
+			}
+			first = false;
+		}
+	} catch (fs::filesystem_error &e) {
+		throw filesystem_exception(
+			"helpers::rename_directory_content: Error in renaming directory items: " + std::string(e.what()));
+	}
+
+	return true;
+}
+
+std::uintmax_t helpers::directory_size(const fs::path &dir)
+{
+	std::uintmax_t size = 0;
+	boost::system::error_code ec;
+
+	fs::recursive_directory_iterator endit;
+	for (fs::recursive_directory_iterator it(dir, ec); !ec && it != endit; it.increment(ec)) {
+		if (fs::is_regular_file(it->symlink_status(ec))) {
+			auto file_size = fs::file_size(it->path(), ec);
+			if (!ec) { size += file_size; }
+		}
+		ec.clear();
+	}
+
+	return size;
+}
+
+#ifndef _WIN32
+namespace
+{
+	/**
+	 * ACL freed in destructor.
+	 */
+	class acl_holder
+	{
+	public:
+		explicit acl_holder(acl_t acl) : acl_(acl)
+		{
+		}
+		~acl_holder()
+		{
+			if (acl_ != nullptr) { acl_free(acl_); }
+		}
+		acl_t &get()
+		{
+			return acl_;
+		}
+
+	private:
+		acl_t acl_;
+	};
+
+	/**
+	 * Tell whether the ACL lets the user through with at least given permissions, mask of the ACL is considered.
+	 */
+	bool acl_permits(acl_t acl, uid_t uid, const std::vector<acl_perm_t> &perms)
+	{
+		bool found = false, masked = true;
+		acl_entry_t entry;
+		for (int res = acl_get_entry(acl, ACL_FIRST_ENTRY, &entry); res == 1;
+			 res = acl_get_entry(acl, ACL_NEXT_ENTRY, &entry)) {
+			acl_tag_t tag;
+			acl_permset_t permset;
+			if (acl_get_tag_type(entry, &tag) == -1 || acl_get_permset(entry, &permset) == -1) { return false; }
+			if (tag != ACL_USER && tag != ACL_MASK) { continue; }
+			if (tag == ACL_USER) {
+				auto qualifier = static_cast<uid_t *>(acl_get_qualifier(entry));
+				bool mine = qualifier != nullptr && *qualifier == uid;
+				acl_free(qualifier);
+				if (!mine) { continue; }
+			}
+
+			bool all = true;
+			for (auto perm : perms) { all = all && acl_get_perm(permset, perm) == 1; }
+			if (tag == ACL_USER) {
+				found = all;
+			} else {
+				masked = all;
+			}
+		}
+		return found && masked;
+	}
+
+	/**
+	 * Add given permissions to the entry of ACL.
+	 * @return @a false if the entry cannot be changed
+	 */
+	bool add_acl_perms(acl_entry_t entry, const std::vector<acl_perm_t> &perms)
+	{
+		acl_permset_t permset;
+		if (acl_get_permset(entry, &permset) == -1) { return false; }
+		for (auto perm : perms) {
+			if (acl_add_perm(permset, perm) == -1) { return false; }
+		}
+		return acl_set_permset(entry, permset) == 0;
+	}
+
+	/**
+	 * Make sure the ACL of given type of the file lets the user through with given permissions. Entry of the user is
+	 * added or extended, the mask is extended as well, other entries are kept. Missing default ACL is created from the
+	 * mode of the directory.
+	 * @return @a false if the ACL cannot be changed, because the file belongs to another user
+	 */
+	bool grant_acl_entry(const std::string &path, const struct stat &st, uid_t uid, acl_type_t type)
+	{
+		std::vector<acl_perm_t> perms = {ACL_READ, ACL_WRITE};
+		// directories have to be searchable, executables have to stay executable
+		if (S_ISDIR(st.st_mode) || (st.st_mode & (S_IXUSR | S_IXGRP | S_IXOTH))) { perms.push_back(ACL_EXECUTE); }
+
+		acl_holder acl(acl_get_file(path.c_str(), type));
+		if (acl.get() == nullptr) {
+			throw helpers::filesystem_exception("Cannot read ACL of " + path + ": " + strerror(errno));
+		}
+		if (acl_permits(acl.get(), uid, perms)) { return true; }
+		if (type == ACL_TYPE_DEFAULT && acl_entries(acl.get()) == 0) {
+			acl_free(acl.get());
+			acl.get() = acl_from_mode(st.st_mode);
+			if (acl.get() == nullptr) {
+				throw helpers::filesystem_exception("Cannot create ACL of " + path + ": " + strerror(errno));
+			}
+		}
+
+		// find the entries of the user and the mask, missing entry of the user is created
+		acl_entry_t entry, mask;
+		bool found = false, masked = false;
+		int res = acl_get_entry(acl.get(), ACL_FIRST_ENTRY, &entry);
+		while (res == 1) {
+			acl_tag_t tag;
+			if (acl_get_tag_type(entry, &tag) == 0 && tag == ACL_USER) {
+				auto qualifier = static_cast<uid_t *>(acl_get_qualifier(entry));
+				found = qualifier != nullptr && *qualifier == uid;
+				acl_free(qualifier);
+				if (found) { break; }
+			}
+			res = acl_get_entry(acl.get(), ACL_NEXT_ENTRY, &entry);
+		}
+		if (!found && (acl_create_entry(&acl.get(), &entry) == -1 || acl_set_tag_type(entry, ACL_USER) == -1 ||
+						  acl_set_qualifier(entry, &uid) == -1)) {
+			throw helpers::filesystem_exception("Cannot add ACL entry of " + path + ": " + strerror(errno));
+		}
+		res = acl_get_entry(acl.get(), ACL_FIRST_ENTRY, &mask);
+		while (res == 1 && !masked) {
+			acl_tag_t tag;
+			masked = acl_get_tag_type(mask, &tag) == 0 && tag == ACL_MASK;
+			if (!masked) { res = acl_get_entry(acl.get(), ACL_NEXT_ENTRY, &mask); }
+		}
+
+		// mask has to let the user through, restrictions it puts on other entries are kept
+		bool updated = add_acl_perms(entry, perms);
+		if (masked) {
+			updated = updated && add_acl_perms(mask, perms);
+		} else {
+			updated = updated && acl_calc_mask(&acl.get()) == 0;
+		}
+		if (!updated || acl_valid(acl.get()) == -1) {
+			throw helpers::filesystem_exception("Cannot update ACL of " + path + ": " + strerror(errno));
+		}
+
+		if (acl_set_file(path.c_str(), type, acl.get()) == -1) {
+			if (errno == EPERM && st.st_uid != geteuid()) { return false; }
+			throw helpers::filesystem_exception("Cannot set ACL of " + path + ": " + strerror(errno));
+		}
+		return true;
+	}
+} // namespace
+
+std::size_t helpers::grant_user_access(const fs::path &dir, unsigned int uid)
+{
+	std::vector<std::string> paths;
+	try {
+		fs::recursive_directory_iterator endit;
+		for (fs::recursive_directory_iterator it(dir); it != endit; ++it) { paths.push_back(it->path().string()); }
+	} catch (fs::filesystem_error &e) {
+		throw filesystem_exception("helpers::grant_user_access: Error in listing directory: " + std::string(e.what()));
+	}
+	paths.push_back(dir.string());
+
+	std::size_t denied = 0;
+	for (auto &path : paths) {
+		struct stat st;
+		if (lstat(path.c_str(), &st) == -1) {
+			throw filesystem_exception("Cannot inspect " + path + ": " + strerror(errno));
+		}
+		if (S_ISLNK(st.st_mode) || (!S_ISDIR(st.st_mode) && st.st_nlink > 1)) { continue; }
+		// items of the user itself are accessible by their owner class
+		if (st.st_uid == uid) { continue; }
+
+		bool granted = grant_acl_entry(path, st, uid, ACL_TYPE_ACCESS);
+		// entries created in directories later inherit the entry of the user
+		if (granted && S_ISDIR(st.st_mode)) { granted = grant_acl_entry(path, st, uid, ACL_TYPE_DEFAULT); }
+		if (!granted) { ++denied; }
+	}
+	return denied;
+}
+#endif
+
 fs::path helpers::normalize_path(const fs::path &path)
 {
 	// prepare root and path chunks
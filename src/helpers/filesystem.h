@@ -10,6 +10,44 @@ namespace fs = boost::filesystem;
 
 namespace helpers
 {
+	/**
+	 * Ways how the content of a file can be delivered to another file.
+	 */
+	enum class copy_strategy {
+		REFLINK, ///< copy-on-write clone sharing the data blocks, destination is independent
+		HARDLINK, ///< destination is the same file as the source
+		COPY_RANGE, ///< data copied by the kernel without passing through user space
+		COPY ///< data read and written in user space
+	};
+
+	/**
+	 * Get textual name of the copy strategy for logging.
+	 * @param strategy the strategy
+	 * @return lowercase name
+	 */
+	const char *copy_strategy_name(copy_strategy strategy);
+
+	/**
+	 * Copy regular file with the cheapest way the filesystem supports. Reflink is tried first,
+	 * then hardlink if allowed, then in-kernel copying. Permissions of the source file are preserved,
+	 * an existing destination file is replaced.
+	 * @param src source file
+	 * @param dest destination file
+	 * @param allow_hardlink destination may be hardlink to the source, so it must never be written
+	 * @return the strategy which was used
+	 * @throws filesystem_exception with approprite description
+	 */
+	copy_strategy copy_file(const fs::path &src, const fs::path &dest, bool allow_hardlink = false);
+
+	/**
+	 * Replace regular file which has more hardlinks by its own copy (reflink or in-kernel copy), so it can be
+	 * written without modifying the other links, e.g. the objects of the file cache.
+	 * @param file file which is going to be written
+	 * @return true if the file was replaced, false if it is not shared
+	 * @throws filesystem_exception if the file cannot be inspected or copied
+	 */
+	bool unshare_file(const fs::path &file);
+
 	/**
 	 * Recursively copy directory from source to destination.
 	 * @param src source directory which content will be copied into @a dest
@@ -18,6 +56,42 @@ namespace helpers
 	 */
 	void copy_directory(const fs::path &src, const fs::path &dest);
 
+	/**
+	 * Move all items of source directory into destination directory by renaming, nothing is copied.
+	 * @param src source directory which content will be moved into @a dest
+	 * @param dest existing destination directory
+	 * @return @a false if directories are on different filesystems and nothing was moved, @a true otherwise
+	 * @throws filesystem_exception with approprite description
+	 */
+	bool rename_directory_content(const fs::path &src, const fs::path &dest);
+
+	/**
+	 * Compute total size of regular files in given directory and all its subdirectories.
+	 * Files which cannot be inspected are not counted.
+	 * @param dir directory to be inspected
+	 * @return size in bytes
+	 */
+	std::uintmax_t directory_size(const fs::path &dir);
+
+#ifndef _WIN32
+	/**
+	 * Grant given user read and write access to directory and everything in it by adding an entry to POSIX ACL
+	 * of every item, so the owner and the mode of items stay untouched. Executable files stay executable for the
+	 * user, symbolic links are skipped. Files with more hardlinks are skipped as well, they are shared with other
+	 * locations (e.g. objects of the file cache) and stay accessible only by their mode, so they are read-only.
+	 * Directories get the entry into their default ACL too, so items created in them later inherit it. Inherited
+	 * entry is limited by the mode the item is created with, so the whole tree has to be processed before every
+	 * use, items which already let the user through are not changed. Mask of changed ACLs is extended. Items of
+	 * the user itself are skipped, they are accessible by their owner class.
+	 * @param dir directory to be processed
+	 * @param uid identifier of the user
+	 * @return number of items which do not let the user through and belong to another user, so their ACL cannot
+	 * be changed
+	 * @throws filesystem_exception if ACL cannot be set, e.g. when the filesystem does not support ACLs
+	 */
+	std::size_t grant_user_access(const fs::path &dir, unsigned int uid);
+#endif
+
 	/**
 	 * Normalize dots and double dots from given path.
 	 * @param path path which will be processed
@@ -0,0 +1,112 @@
+#include "metrics.h"
+#include <cmath>
+#include <sstream>
+
+
+const std::size_t helpers::metric_histogram::bucket_count;
+
+const std::array<double, helpers::metric_histogram::bucket_count> helpers::metric_histogram::bounds = {
+	{0.001, 0.005, 0.01, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 60}};
+
+helpers::metric_histogram::metric_histogram() : sum_(0), count_(0)
+{
+	for (auto &bucket : buckets_) { bucket.store(0, std::memory_order_relaxed); }
+}
+
+void helpers::metric_histogram::observe(double seconds)
+{
+	std::size_t bucket = 0;
+	while (bucket < bucket_count && seconds > bounds[bucket]) { ++bucket; }
+
+	buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+	if (seconds > 0) {
+		sum_.fetch_add(static_cast<std::uint64_t>(std::llround(seconds * 1e6)), std::memory_order_relaxed);
+	}
+	count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::uint64_t helpers::metric_histogram::get_bucket(std::size_t bucket) const
+{
+	return buckets_.at(bucket).load(std::memory_order_relaxed);
+}
+
+std::uint64_t helpers::metric_histogram::get_count() const
+{
+	return count_.load(std::memory_order_relaxed);
+}
+
+double helpers::metric_histogram::get_sum() const
+{
+	return static_cast<double>(sum_.load(std::memory_order_relaxed)) / 1e6;
+}
+
+namespace
+{
+	void render_header(std::ostringstream &out, const std::string &name, const std::string &type, const std::string &help)
+	{
+		out << "# HELP " << name << " " << help << "\n";
+		out << "# TYPE " << name << " " << type << "\n";
+	}
+
+	void render_histogram(std::ostringstream &out,
+		const std::string &name,
+		const std::string &help,
+		const helpers::metric_histogram &histogram)
+	{
+		render_header(out, name, "histogram", help);
+
+		// buckets of the exposition format are cumulative
+		std::uint64_t cumulative = 0;
+		for (std::size_t i = 0; i < helpers::metric_histogram::bucket_count; ++i) {
+			cumulative += histogram.get_bucket(i);
+			out << name << "_bucket{le=\"" << helpers::metric_histogram::bounds[i] << "\"} " << cumulative << "\n";
+		}
+		cumulative += histogram.get_bucket(helpers::metric_histogram::bucket_count);
+		out << name << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+		out << name << "_sum " << histogram.get_sum() << "\n";
+		out << name << "_count " << cumulative << "\n";
+	}
+} // namespace
+
+std::string helpers::worker_metrics::render() const
+{
+	std::ostringstream out;
+
+	render_header(out, "recodex_worker_jobs_total", "counter", "Evaluated jobs by their result.");
+	out << "recodex_worker_jobs_total{result=\"OK\"} " << jobs_ok.get() << "\n";
+	out << "recodex_worker_jobs_total{result=\"FAILED\"} " << jobs_failed.get() << "\n";
+	out << "recodex_worker_jobs_total{result=\"INTERNAL_ERROR\"} " << jobs_internal_error.get() << "\n";
+
+	render_header(out, "recodex_worker_tasks_total", "counter", "Executed tasks by their status.");
+	out << "recodex_worker_tasks_total{status=\"OK\"} " << tasks_ok.get() << "\n";
+	out << "recodex_worker_tasks_total{status=\"FAILED\"} " << tasks_failed.get() << "\n";
+	out << "recodex_worker_tasks_total{status=\"SKIPPED\"} " << tasks_skipped.get() << "\n";
+
+	render_header(out, "recodex_worker_cache_hits_total", "counter", "Files delivered from the cache.");
+	out << "recodex_worker_cache_hits_total " << cache_hits.get() << "\n";
+	render_header(out, "recodex_worker_cache_misses_total", "counter", "Files not found in the cache.");
+	out << "recodex_worker_cache_misses_total " << cache_misses.get() << "\n";
+
+	render_header(out, "recodex_worker_fetched_bytes_total", "counter", "Bytes downloaded from the file server.");
+	out << "recodex_worker_fetched_bytes_total " << fetched_bytes.get() << "\n";
+
+	render_histogram(out,
+		"recodex_worker_job_duration_seconds",
+		"Duration of job evaluation without upload of results.",
+		job_duration);
+	render_histogram(out, "recodex_worker_sandbox_init_seconds", "Duration of sandbox initialization.", sandbox_init);
+	render_histogram(out, "recodex_worker_sandbox_cleanup_seconds", "Duration of sandbox cleanup.", sandbox_cleanup);
+
+	render_header(out, "recodex_worker_queued_jobs", "gauge", "Jobs waiting for evaluation.");
+	out << "recodex_worker_queued_jobs " << queued_jobs.get() << "\n";
+	render_header(out, "recodex_worker_upload_queue", "gauge", "Archives with results waiting for upload.");
+	out << "recodex_worker_upload_queue " << upload_queue.get() << "\n";
+
+	return out.str();
+}
+
+helpers::worker_metrics &helpers::metrics()
+{
+	static worker_metrics instance;
+	return instance;
+}
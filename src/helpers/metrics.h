@@ -0,0 +1,189 @@
+#ifndef RECODEX_WORKER_HELPERS_METRICS_H
+#define RECODEX_WORKER_HELPERS_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace helpers
+{
+
+	/**
+	 * Counter of events, it can be incremented from any thread without locking.
+	 */
+	class metric_counter
+	{
+	public:
+		metric_counter() : value_(0)
+		{
+		}
+
+		metric_counter(const metric_counter &source) = delete;
+		metric_counter &operator=(const metric_counter &source) = delete;
+
+		/**
+		 * Increment the counter.
+		 * @param count number of events
+		 */
+		void add(std::uint64_t count = 1)
+		{
+			value_.fetch_add(count, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Get current value.
+		 * @return number of events
+		 */
+		std::uint64_t get() const
+		{
+			return value_.load(std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<std::uint64_t> value_;
+	};
+
+	/**
+	 * Value which can go up and down, e.g. length of a queue.
+	 */
+	class metric_gauge
+	{
+	public:
+		metric_gauge() : value_(0)
+		{
+		}
+
+		metric_gauge(const metric_gauge &source) = delete;
+		metric_gauge &operator=(const metric_gauge &source) = delete;
+
+		/**
+		 * Set the value.
+		 * @param value new value
+		 */
+		void set(std::int64_t value)
+		{
+			value_.store(value, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Change the value.
+		 * @param difference added to the value, it can be negative
+		 */
+		void add(std::int64_t difference)
+		{
+			value_.fetch_add(difference, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Get current value.
+		 * @return the value
+		 */
+		std::int64_t get() const
+		{
+			return value_.load(std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<std::int64_t> value_;
+	};
+
+	/**
+	 * Distribution of durations. Buckets have fixed bounds shared by all histograms, so observing
+	 * a value only increments few atomic counters.
+	 */
+	class metric_histogram
+	{
+	public:
+		/** Number of buckets with upper bound, one more bucket is unbounded. */
+		static const std::size_t bucket_count = 12;
+		/** Upper bounds of the buckets in seconds. */
+		static const std::array<double, bucket_count> bounds;
+
+		metric_histogram();
+
+		metric_histogram(const metric_histogram &source) = delete;
+		metric_histogram &operator=(const metric_histogram &source) = delete;
+
+		/**
+		 * Record one duration.
+		 * @param seconds the duration
+		 */
+		void observe(double seconds);
+
+		/**
+		 * Get number of durations in one bucket, the counts are not cumulative.
+		 * @param bucket index of the bucket, @ref bucket_count is the unbounded one
+		 * @return number of durations which are greater than the previous bound and not greater than this one
+		 */
+		std::uint64_t get_bucket(std::size_t bucket) const;
+
+		/**
+		 * Get number of recorded durations.
+		 * @return the count
+		 */
+		std::uint64_t get_count() const;
+
+		/**
+		 * Get sum of recorded durations.
+		 * @return the sum in seconds with microsecond precision
+		 */
+		double get_sum() const;
+
+	private:
+		std::array<std::atomic<std::uint64_t>, bucket_count + 1> buckets_;
+		/** Sum of durations in microseconds */
+		std::atomic<std::uint64_t> sum_;
+		std::atomic<std::uint64_t> count_;
+	};
+
+	/**
+	 * All metrics exported by the worker. Values are updated in place by the components, the text
+	 * representation is created only when the metrics are scraped.
+	 */
+	struct worker_metrics {
+		/** Jobs which ended with OK result */
+		metric_counter jobs_ok;
+		/** Jobs which ended with FAILED result */
+		metric_counter jobs_failed;
+		/** Jobs which ended with INTERNAL_ERROR result */
+		metric_counter jobs_internal_error;
+		/** Tasks which ended successfully */
+		metric_counter tasks_ok;
+		/** Tasks which failed */
+		metric_counter tasks_failed;
+		/** Tasks which were skipped */
+		metric_counter tasks_skipped;
+		/** Files delivered from the cache */
+		metric_counter cache_hits;
+		/** Files which were not found in the cache */
+		metric_counter cache_misses;
+		/** Bytes downloaded from the file server */
+		metric_counter fetched_bytes;
+		/** Duration of job evaluation, upload of results is not included */
+		metric_histogram job_duration;
+		/** Duration of sandbox initialization */
+		metric_histogram sandbox_init;
+		/** Duration of sandbox cleanup */
+		metric_histogram sandbox_cleanup;
+		/** Number of jobs waiting for evaluation */
+		metric_gauge queued_jobs;
+		/** Number of archives with results waiting for upload */
+		metric_gauge upload_queue;
+
+		/**
+		 * Format all metrics in Prometheus text exposition format.
+		 * @return the text
+		 */
+		std::string render() const;
+	};
+
+	/**
+	 * Get metrics of the worker, they are shared by all its components.
+	 * @return the metrics
+	 */
+	worker_metrics &metrics();
+
+} // namespace helpers
+
+#endif // RECODEX_WORKER_HELPERS_METRICS_H
@@ -0,0 +1,148 @@
+#ifndef _WIN32
+
+#include "process.h"
+#include <algorithm>
+#include <system_error>
+#include <thread>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+	using clock = std::chrono::steady_clock;
+
+	int open_pidfd(pid_t pid)
+	{
+#ifdef SYS_pidfd_open
+		return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+		(void) pid;
+		errno = ENOSYS;
+		return -1;
+#endif
+	}
+
+	/**
+	 * Wait until the pidfd becomes readable, which means that the process ended.
+	 * @return 1 if the process ended, 0 if the deadline passed, -1 if polling failed
+	 */
+	int wait_pidfd(int pidfd, clock::time_point deadline)
+	{
+		while (true) {
+			auto now = clock::now();
+			if (now >= deadline) { return 0; }
+
+			// round up, so that the deadline is not missed by a fraction of millisecond
+			auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now) +
+				std::chrono::milliseconds(1);
+			struct pollfd item = {pidfd, POLLIN, 0};
+			int ret = poll(&item, 1, static_cast<int>(std::min<long long>(remaining.count(), 3600 * 1000)));
+
+			if (ret > 0) { return 1; }
+			if (ret == -1 && errno != EINTR) { return -1; }
+		}
+	}
+
+	/**
+	 * Poll waitpid until the process is reaped or the deadline passes.
+	 * @return 1 if the process was reaped, 0 if the deadline passed, -1 if waitpid failed
+	 */
+	int wait_polling(pid_t pid, clock::time_point deadline, int &status)
+	{
+		std::chrono::milliseconds interval(1);
+		const std::chrono::milliseconds max_interval(100);
+
+		while (true) {
+			pid_t ret = waitpid(pid, &status, WNOHANG);
+			if (ret == pid) { return 1; }
+			if (ret == -1 && errno != EINTR) { return -1; }
+
+			auto now = clock::now();
+			if (now >= deadline) { return 0; }
+
+			std::this_thread::sleep_for(std::min<clock::duration>(interval, deadline - now));
+			interval = std::min(interval * 2, max_interval);
+		}
+	}
+
+	void reap(pid_t pid, int &status)
+	{
+		while (waitpid(pid, &status, 0) == -1) {
+			if (errno != EINTR) { throw std::system_error(errno, std::generic_category(), "waitpid"); }
+		}
+	}
+} // namespace
+
+pid_t helpers::spawn_process(const std::vector<std::string> &args, int stdout_fd)
+{
+	// execvp does not modify its arguments, so the strings are passed without copying
+	std::vector<char *> argv;
+	for (auto &arg : args) { argv.push_back(const_cast<char *>(arg.c_str())); }
+	argv.push_back(nullptr);
+
+	posix_spawn_file_actions_t actions;
+	int ret = posix_spawn_file_actions_init(&actions);
+	if (ret != 0) {
+		errno = ret;
+		return -1;
+	}
+
+	ret = posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+	if (ret == 0) {
+		if (stdout_fd == -1) {
+			ret = posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+		} else {
+			ret = posix_spawn_file_actions_adddup2(&actions, stdout_fd, 1);
+		}
+	}
+	if (ret == 0) { ret = posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0); }
+
+	pid_t pid = -1;
+	if (ret == 0) { ret = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ); }
+	posix_spawn_file_actions_destroy(&actions);
+
+	if (ret != 0) {
+		errno = ret;
+		return -1;
+	}
+	return pid;
+}
+
+bool helpers::wait_for_child(pid_t pid, std::chrono::milliseconds timeout, int &status)
+{
+	auto deadline = clock::now() + timeout;
+	status = 0;
+
+	int pidfd = open_pidfd(pid);
+	if (pidfd != -1) {
+		int ended = wait_pidfd(pidfd, deadline);
+		close(pidfd);
+
+		if (ended == 1) {
+			reap(pid, status);
+			return true;
+		}
+		if (ended == 0) {
+			kill(pid, SIGKILL);
+			reap(pid, status);
+			return false;
+		}
+		// polling of pidfd failed, watch the process the old way
+	}
+
+	int ended = wait_polling(pid, deadline, status);
+	if (ended == 1) { return true; }
+	if (ended == -1) { throw std::system_error(errno, std::generic_category(), "waitpid"); }
+
+	kill(pid, SIGKILL);
+	reap(pid, status);
+	return false;
+}
+
+#endif // _WIN32
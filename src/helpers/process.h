@@ -0,0 +1,41 @@
+#ifndef RECODEX_WORKER_HELPERS_PROCESS_H
+#define RECODEX_WORKER_HELPERS_PROCESS_H
+
+#ifndef _WIN32
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+
+namespace helpers
+{
+	/**
+	 * Start a program found in PATH. Process is created by posix_spawnp, which does not copy page tables
+	 * of the worker (glibc uses vfork-like clone), so the cost does not grow with memory of the worker.
+	 * Standard input, output and error of the program are redirected to /dev/null, except the output
+	 * which can go to given descriptor. Other descriptors of the worker are inherited unless they are
+	 * marked close-on-exec.
+	 * @param args name of the program followed by its arguments
+	 * @param stdout_fd descriptor which becomes standard output of the program, -1 means /dev/null
+	 * @return identifier of the started process, -1 on failure with @a errno set
+	 */
+	pid_t spawn_process(const std::vector<std::string> &args, int stdout_fd = -1);
+
+	/**
+	 * Wait for termination of a child process, but at most given time. When the time runs out,
+	 * the process is killed by SIGKILL. In both cases the process is reaped before return.
+	 * The process is watched through pidfd and poll, which needs Linux 5.3. On older kernels
+	 * waitpid is polled with intervals growing up to 100 ms. No helper process is created.
+	 * @param pid identifier of the child process
+	 * @param timeout maximal time of waiting
+	 * @param status set to the status of the process as returned by waitpid
+	 * @return @a true if the process ended by itself, @a false if it was killed
+	 * @throws std::system_error if the process cannot be waited for, e.g. it is not a child of the worker
+	 */
+	bool wait_for_child(pid_t pid, std::chrono::milliseconds timeout, int &status);
+} // namespace helpers
+
+#endif // _WIN32
+#endif // RECODEX_WORKER_HELPERS_PROCESS_H
@@ -0,0 +1,119 @@
+#include "sha1.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+
+namespace
+{
+	std::uint32_t rotate_left(std::uint32_t value, unsigned bits)
+	{
+		return (value << bits) | (value >> (32 - bits));
+	}
+} // namespace
+
+
+helpers::sha1::sha1() : state_{0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0}
+{
+}
+
+void helpers::sha1::update(const char *data, std::size_t length)
+{
+	length_ += length;
+
+	while (length > 0) {
+		std::size_t chunk = std::min(length, sizeof(buffer_) - buffer_length_);
+		std::copy(data, data + chunk, buffer_ + buffer_length_);
+		buffer_length_ += chunk;
+		data += chunk;
+		length -= chunk;
+
+		if (buffer_length_ == sizeof(buffer_)) {
+			process_block();
+			buffer_length_ = 0;
+		}
+	}
+}
+
+std::string helpers::sha1::hex_digest()
+{
+	std::uint64_t bit_length = length_ * 8;
+
+	// padding: single one bit, zeros and message length in the last 8 bytes of the block
+	buffer_[buffer_length_++] = 0x80;
+	if (buffer_length_ > 56) {
+		std::fill(buffer_ + buffer_length_, buffer_ + sizeof(buffer_), 0);
+		process_block();
+		buffer_length_ = 0;
+	}
+	std::fill(buffer_ + buffer_length_, buffer_ + 56, 0);
+	for (int i = 0; i < 8; ++i) { buffer_[63 - i] = static_cast<unsigned char>(bit_length >> (8 * i)); }
+	process_block();
+	buffer_length_ = 0;
+
+	static const char hex[] = "0123456789abcdef";
+	std::string result;
+	result.reserve(40);
+	for (auto word : state_) {
+		for (int shift = 28; shift >= 0; shift -= 4) { result.push_back(hex[(word >> shift) & 0xF]); }
+	}
+	return result;
+}
+
+void helpers::sha1::process_block()
+{
+	std::uint32_t w[80];
+	for (int i = 0; i < 16; ++i) {
+		w[i] = (std::uint32_t(buffer_[4 * i]) << 24) | (std::uint32_t(buffer_[4 * i + 1]) << 16) |
+			(std::uint32_t(buffer_[4 * i + 2]) << 8) | std::uint32_t(buffer_[4 * i + 3]);
+	}
+	for (int i = 16; i < 80; ++i) { w[i] = rotate_left(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1); }
+
+	std::uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3], e = state_[4];
+
+	for (int i = 0; i < 80; ++i) {
+		std::uint32_t f, k;
+		if (i < 20) {
+			f = (b & c) | (~b & d);
+			k = 0x5A827999;
+		} else if (i < 40) {
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1;
+		} else if (i < 60) {
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDC;
+		} else {
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6;
+		}
+
+		std::uint32_t temp = rotate_left(a, 5) + f + e + k + w[i];
+		e = d;
+		d = c;
+		c = rotate_left(b, 30);
+		b = a;
+		a = temp;
+	}
+
+	state_[0] += a;
+	state_[1] += b;
+	state_[2] += c;
+	state_[3] += d;
+	state_[4] += e;
+}
+
+std::string helpers::sha1_file(const std::string &file)
+{
+	std::ifstream input(file, std::ios::binary);
+	if (!input.is_open()) { throw std::runtime_error("Cannot open file " + file); }
+
+	sha1 digest;
+	char buffer[65536];
+	while (input) {
+		input.read(buffer, sizeof(buffer));
+		digest.update(buffer, static_cast<std::size_t>(input.gcount()));
+	}
+	if (input.bad()) { throw std::runtime_error("Cannot read file " + file); }
+
+	return digest.hex_digest();
+}
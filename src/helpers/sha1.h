@@ -0,0 +1,60 @@
+#ifndef RECODEX_WORKER_HELPERS_SHA1_H
+#define RECODEX_WORKER_HELPERS_SHA1_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace helpers
+{
+	/**
+	 * Incremental computation of SHA-1 digest, data can be fed in arbitrary chunks.
+	 */
+	class sha1
+	{
+	public:
+		/**
+		 * Start computation of a new digest.
+		 */
+		sha1();
+
+		/**
+		 * Append data to the digested message.
+		 * @param data pointer to the data
+		 * @param length number of bytes
+		 */
+		void update(const char *data, std::size_t length);
+
+		/**
+		 * Finish the computation, no more data can be appended afterwards.
+		 * @return digest as 40 lowercase hexadecimal characters
+		 */
+		std::string hex_digest();
+
+	private:
+		/**
+		 * Process one full 64 bytes long block stored in the buffer.
+		 */
+		void process_block();
+
+		/** Intermediate hash value. */
+		std::uint32_t state_[5];
+		/** Data which do not form a full block yet. */
+		unsigned char buffer_[64];
+		/** Number of bytes stored in the buffer. */
+		std::size_t buffer_length_ = 0;
+		/** Total length of the message in bytes. */
+		std::uint64_t length_ = 0;
+	};
+
+	/**
+	 * Compute SHA-1 digest of the file content.
+	 * @param file path to the file
+	 * @return digest as 40 lowercase hexadecimal characters
+	 * @throws std::runtime_error if the file cannot be read
+	 */
+	std::string sha1_file(const std::string &file);
+} // namespace helpers
+
+#endif // RECODEX_WORKER_HELPERS_SHA1_H
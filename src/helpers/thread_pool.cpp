@@ -0,0 +1,52 @@
+#include "thread_pool.h"
+
+helpers::thread_pool::thread_pool(std::size_t threads)
+{
+	if (threads == 0) { threads = 1; }
+
+	for (std::size_t i = 0; i < threads; ++i) { threads_.emplace_back(&thread_pool::work, this); }
+}
+
+helpers::thread_pool::~thread_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	cond_.notify_all();
+
+	for (auto &thread : threads_) { thread.join(); }
+}
+
+void helpers::thread_pool::enqueue(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs_.push(std::move(job));
+	}
+	cond_.notify_one();
+}
+
+std::size_t helpers::thread_pool::size() const
+{
+	return threads_.size();
+}
+
+void helpers::thread_pool::work()
+{
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cond_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+
+			// stop only when there is nothing more to do
+			if (jobs_.empty()) { return; }
+
+			job = std::move(jobs_.front());
+			jobs_.pop();
+		}
+
+		job();
+	}
+}
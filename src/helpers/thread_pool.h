@@ -0,0 +1,67 @@
+#ifndef RECODEX_WORKER_HELPERS_THREAD_POOL_HPP
+#define RECODEX_WORKER_HELPERS_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+
+namespace helpers
+{
+	/**
+	 * Fixed number of threads which execute enqueued jobs in the order of their arrival.
+	 * Jobs should not throw, exceptions escaping the job terminate the program.
+	 */
+	class thread_pool
+	{
+	public:
+		/**
+		 * Start given number of threads which immediately wait for the jobs.
+		 * @param threads number of threads, at least one thread is always started
+		 */
+		thread_pool(std::size_t threads);
+
+		thread_pool(const thread_pool &source) = delete;
+		thread_pool &operator=(const thread_pool &source) = delete;
+
+		/**
+		 * Wait until all enqueued jobs are executed and join all threads.
+		 */
+		~thread_pool();
+
+		/**
+		 * Add job which will be executed by the first available thread.
+		 * @param job callable object
+		 */
+		void enqueue(std::function<void()> job);
+
+		/**
+		 * Get number of threads in the pool.
+		 * @return number of threads
+		 */
+		std::size_t size() const;
+
+	private:
+		/**
+		 * Body of the threads, take jobs from the queue until the pool is destroyed.
+		 */
+		void work();
+
+		/** Threads executing the jobs. */
+		std::vector<std::thread> threads_;
+		/** Jobs waiting for execution. */
+		std::queue<std::function<void()>> jobs_;
+		/** Guards the queue of jobs and the stop flag. */
+		std::mutex mutex_;
+		/** Signalled when a job is added or the pool is stopped. */
+		std::condition_variable cond_;
+		/** Set in destructor, threads end when the queue is empty. */
+		bool stop_ = false;
+	};
+} // namespace helpers
+
+#endif // RECODEX_WORKER_HELPERS_THREAD_POOL_HPP
@@ -0,0 +1,103 @@
+#ifndef RECODEX_WORKER_HELPERS_TIMINGS_H
+#define RECODEX_WORKER_HELPERS_TIMINGS_H
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace helpers
+{
+
+	/**
+	 * Durations of phases in seconds, in the order in which the phases ended.
+	 */
+	using phase_timings = std::vector<std::pair<std::string, double>>;
+
+	/**
+	 * Measures duration of one phase by monotonic clock. The duration is recorded when the timer is
+	 * stopped or destroyed, so the phase is recorded also when it ends by an exception.
+	 */
+	class phase_timer
+	{
+	public:
+		/**
+		 * Start measuring the phase.
+		 * @param timings where the duration is recorded
+		 * @param phase name of the phase
+		 */
+		phase_timer(phase_timings &timings, const std::string &phase)
+			: timings_(timings), phase_(phase), start_(std::chrono::steady_clock::now())
+		{
+		}
+
+		phase_timer(const phase_timer &source) = delete;
+		phase_timer &operator=(const phase_timer &source) = delete;
+
+		/**
+		 * Record the duration unless the timer was already stopped.
+		 */
+		~phase_timer()
+		{
+			stop();
+		}
+
+		/**
+		 * Record the duration, further calls do nothing.
+		 */
+		void stop()
+		{
+			if (stopped_) { return; }
+			stopped_ = true;
+			std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start_;
+			timings_.emplace_back(phase_, duration.count());
+		}
+
+	private:
+		phase_timings &timings_;
+		std::string phase_;
+		std::chrono::steady_clock::time_point start_;
+		bool stopped_ = false;
+	};
+
+	/**
+	 * Add durations of the phases to the totals, phases which are not in the totals yet are appended.
+	 * @param totals summed durations
+	 * @param timings durations which are added
+	 */
+	inline void add_timings(phase_timings &totals, const phase_timings &timings)
+	{
+		for (auto &timing : timings) {
+			bool found = false;
+			for (auto &total : totals) {
+				if (total.first == timing.first) {
+					total.second += timing.second;
+					found = true;
+					break;
+				}
+			}
+			if (!found) { totals.push_back(timing); }
+		}
+	}
+
+	/**
+	 * Format durations for logs, e.g. "download 0.120 s, build 0.003 s".
+	 * @param timings durations of phases
+	 * @return textual representation
+	 */
+	inline std::string format_timings(const phase_timings &timings)
+	{
+		std::string result;
+		char duration[32];
+		for (auto &timing : timings) {
+			if (!result.empty()) { result += ", "; }
+			std::snprintf(duration, sizeof(duration), " %.3f s", timing.second);
+			result += timing.first + duration;
+		}
+		return result;
+	}
+
+} // namespace helpers
+
+#endif // RECODEX_WORKER_HELPERS_TIMINGS_H
@@ -1,6 +1,14 @@
 #include "job.h"
 #include "job_exception.h"
 #include "helpers/type_utils.h"
+#include "helpers/metrics.h"
+#include "helpers/thread_pool.h"
+#include "tasks/internal/fetch_task.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
 
 job::job(std::shared_ptr<job_metadata> job_meta,
 	std::shared_ptr<worker_config> worker_conf,
@@ -284,75 +292,241 @@ void job::connect_tasks(
 
 std::vector<std::pair<std::string, std::shared_ptr<task_results>>> job::run()
 {
-	std::vector<std::pair<std::string, std::shared_ptr<task_results>>> results;
 	progress_callback_->job_started(job_meta_->job_id);
 
-	// simply run all tasks in given topological order
+	std::size_t slots = std::max<std::size_t>(worker_config_->get_max_parallel_tasks(), 1);
+	logger_->info("Executing job with up to {} task(s) in parallel", slots);
+
+	// all files of fetch tasks are downloaded at once in background, the tasks only wait for them and move them;
+	// only tasks which cannot be skipped are prefetched, i.e. executable tasks which depend on inner tasks only,
+	// because failure of an inner task ends the whole job and only failures of other tasks skip their children
+	std::set<task_base *> unskippable;
+	std::vector<std::shared_ptr<fetch_task>> fetch_tasks;
 	for (auto &task : task_queue_) {
+		if (!task->is_executable() || task->get_type() != task_type::INNER) { continue; }
+		bool skippable = false;
+		for (auto &parent : task->get_parents()) {
+			auto parent_ptr = parent.lock();
+			if (parent_ptr != root_task_ && unskippable.find(parent_ptr.get()) == unskippable.end()) {
+				skippable = true;
+			}
+		}
+		if (skippable) { continue; }
+
+		unskippable.insert(task.get());
+		auto fetch = std::dynamic_pointer_cast<fetch_task>(task);
+		if (fetch != nullptr) { fetch_tasks.push_back(fetch); }
+	}
+	if (fetch_tasks.size() > 1) { fetch_task::prefetch(fetch_tasks, temporary_directory_ / "prefetch", logger_); }
+
+	// position in the topological order is used as identification of tasks and as the execution preference,
+	// so with only one slot the tasks are executed exactly in the order of task queue
+	std::map<task_base *, std::size_t> positions;
+	for (std::size_t i = 0; i < task_queue_.size(); ++i) {
 		// we don't want nullptr dereference
-		if (task == nullptr) { continue; }
+		if (task_queue_[i] != nullptr) { positions.emplace(task_queue_[i].get(), i); }
+	}
 
-		auto task_id = task->get_task_id();
-		if (task->is_executable()) {
-			std::shared_ptr<task_results> res = nullptr;
+	// count unfinished parents of all tasks, root task is not in the queue and does not count
+	std::vector<std::size_t> pending_parents(task_queue_.size(), 0);
+	std::set<std::size_t> ready;
+	for (auto &position : positions) {
+		for (auto &parent : position.first->get_parents()) {
+			auto parent_ptr = parent.lock();
+			if (parent_ptr != nullptr && positions.find(parent_ptr.get()) != positions.end()) {
+				++pending_parents[position.second];
+			}
+		}
+		if (pending_parents[position.second] == 0) { ready.insert(position.second); }
+	}
+
+	// after finishing of the task its children may become ready
+	auto release_children = [&](std::size_t position) {
+		for (auto &child : task_queue_[position]->get_children()) {
+			auto it = positions.find(child.get());
+			if (it != positions.end() && --pending_parents[it->second] == 0) { ready.insert(it->second); }
+		}
+	};
+
+	std::vector<std::shared_ptr<task_results>> task_results_list(task_queue_.size());
+	std::vector<bool> reported(task_queue_.size(), false);
+	// tasks behind fatally failed task are not executed, tasks in front of it are executed as usual
+	std::size_t last_position = task_queue_.size();
+	std::exception_ptr error = nullptr;
+
+	std::mutex outcomes_mutex;
+	std::condition_variable outcomes_cond;
+	std::deque<task_outcome> outcomes;
+	std::size_t running = 0;
+	std::size_t overlaid_running = 0;
+	bool exclusive_running = false;
+
+	// with only one slot everything is executed in this thread, pool has to be destructed before outcomes
+	std::unique_ptr<helpers::thread_pool> pool;
+	if (slots > 1) { pool.reset(new helpers::thread_pool(slots)); }
+
+	while (true) {
+		// start as many tasks as possible
+		while (error == nullptr && !exclusive_running && running < slots) {
+			auto it = ready.begin();
+			if (it == ready.end() || *it > last_position) { break; }
+
+			std::size_t position = *it;
+			auto &task = task_queue_[position];
+			auto task_id = task->get_task_id();
+
+			if (!task->is_executable()) {
+				ready.erase(it);
+				logger_->info("Task \"{}\" marked as not executable, proceeding to next task", task_id);
+				progress_callback_->task_skipped(job_meta_->job_id, task_id);
+				helpers::metrics().tasks_skipped.add();
+
+				// even skipped task has its own result entry
+				std::shared_ptr<task_results> result(new task_results());
+				result->status = task_status::SKIPPED;
+				task_results_list[position] = result;
+				reported[position] = true;
+
+				// we have to pass information about non-execution to children
+				task->set_children_execution(false);
+				release_children(position);
+				continue;
+			}
+
+			if (task->is_exclusive()) {
+				// exclusive task waits until all running tasks are finished
+				if (running > 0) { break; }
+				exclusive_running = true;
+			}
+
+			// evaluation directory must not be written while it is the lower layer of a mounted overlay
+			bool overlaid = task->is_overlaid();
+			if (overlaid ? running > overlaid_running : overlaid_running > 0) { break; }
+
+			ready.erase(it);
+			++running;
+			if (overlaid) { ++overlaid_running; }
+			if (pool == nullptr) {
+				outcomes.push_back(execute_task(position));
+			} else {
+				pool->enqueue([this, position, &outcomes_mutex, &outcomes_cond, &outcomes]() {
+					auto outcome = execute_task(position);
+					{
+						std::lock_guard<std::mutex> lock(outcomes_mutex);
+						outcomes.push_back(outcome);
+					}
+					outcomes_cond.notify_one();
+				});
+			}
+		}
+
+		if (running == 0) { break; }
+
+		task_outcome outcome;
+		{
+			std::unique_lock<std::mutex> lock(outcomes_mutex);
+			outcomes_cond.wait(lock, [&outcomes]() { return !outcomes.empty(); });
+			outcome = outcomes.front();
+			outcomes.pop_front();
+		}
+
+		--running;
+		std::size_t position = outcome.position;
+		auto &task = task_queue_[position];
+		if (task->is_exclusive()) { exclusive_running = false; }
+		if (task->is_overlaid()) { --overlaid_running; }
+
+		// after an error only already running tasks are waited for, tasks behind fatally failed task are not
+		// reported even if they were already running when it failed
+		if (error != nullptr || position > last_position) { continue; }
+
+		if (outcome.failure != nullptr) {
 			try {
-				res = task->run();
+				std::rethrow_exception(outcome.failure);
 			} catch (std::exception &e) {
-				throw job_unrecoverable_exception(e.what());
+				error = std::make_exception_ptr(job_unrecoverable_exception(e.what()));
+			} catch (...) {
+				error = std::current_exception();
 			}
+			continue;
+		}
 
-			// add result from task into whole results set
-			results.emplace_back(task_id, res);
+		// add result from task into whole results set
+		auto task_id = task->get_task_id();
+		auto res = outcome.results;
+		if (res != nullptr) { res->timings.emplace_back("total", outcome.duration); }
+		task_results_list[position] = res;
+		reported[position] = true;
 
-			// if task has some results then process them
+		// if task has some results then process them
+		if (res == nullptr || res->status == task_status::OK) {
 			if (res != nullptr) {
-				if (res->status == task_status::OK) {
-					// task executed successfully
-
-					logger_->info("Task \"{}\" ran successfully", task_id);
-					progress_callback_->task_completed(job_meta_->job_id, task_id);
-				} else {
-					// execution of task failed
-
-					if (task->get_type() == task_type::INNER) {
-						// evaluation just encountered internal error and its quite possible
-						// that something is very wrong in here, so be gentle and crash like a sir
-						// and try not to mess up next job execution
-						throw task_exception(res->error_message);
-					}
-
-					logger_->info("Task \"{}\" failed: {}", task_id, res->error_message);
-					progress_callback_->task_failed(job_meta_->job_id, task_id);
-
-					if (task->get_fatal_failure()) {
-						logger_->info("Fatal failure bit set. Terminating of job execution...");
-						break;
-					} else {
-						// set executable bit in this task and in children
-						logger_->info("Task children will not be executed");
-						task->set_execution(false);
-						task->set_children_execution(false);
-					}
-				}
+				// task executed successfully
+				logger_->info("Task \"{}\" ran successfully", task_id);
+				progress_callback_->task_completed(job_meta_->job_id, task_id);
+				helpers::metrics().tasks_ok.add();
 			}
-		} else {
-			logger_->info("Task \"{}\" marked as not executable, proceeding to next task", task_id);
-			progress_callback_->task_skipped(job_meta_->job_id, task_id);
+			release_children(position);
+			continue;
+		}
+
+		// execution of task failed
+		helpers::metrics().tasks_failed.add();
+
+		if (task->get_type() == task_type::INNER) {
+			// evaluation just encountered internal error and its quite possible
+			// that something is very wrong in here, so be gentle and crash like a sir
+			// and try not to mess up next job execution
+			error = std::make_exception_ptr(task_exception(res->error_message));
+			continue;
+		}
 
-			// even skipped task has its own result entry
-			std::shared_ptr<task_results> result(new task_results());
-			result->status = task_status::SKIPPED;
-			results.emplace_back(task_id, result);
+		logger_->info("Task \"{}\" failed: {}", task_id, res->error_message);
+		progress_callback_->task_failed(job_meta_->job_id, task_id);
 
-			// we have to pass information about non-execution to children
+		if (task->get_fatal_failure()) {
+			logger_->info("Fatal failure bit set. Terminating of job execution...");
+			last_position = std::min(last_position, position);
+		} else {
+			// set executable bit in this task and in children
+			logger_->info("Task children will not be executed");
+			task->set_execution(false);
 			task->set_children_execution(false);
+			release_children(position);
 		}
 	}
 
+	// all tasks are finished at this point, so threads can be joined
+	pool.reset();
+
+	if (error != nullptr) { std::rethrow_exception(error); }
+
+	// results are reported in the order of task queue regardless of the order of execution
+	std::vector<std::pair<std::string, std::shared_ptr<task_results>>> results;
+	for (std::size_t i = 0; i < task_queue_.size() && i <= last_position; ++i) {
+		if (reported[i]) { results.emplace_back(task_queue_[i]->get_task_id(), task_results_list[i]); }
+	}
+
 	progress_callback_->job_ended(job_meta_->job_id);
 	return results;
 }
 
+job::task_outcome job::execute_task(std::size_t position)
+{
+	task_outcome outcome;
+	outcome.position = position;
+	auto start = std::chrono::steady_clock::now();
+	try {
+		outcome.results = task_queue_[position]->run();
+	} catch (...) {
+		outcome.failure = std::current_exception();
+	}
+
+	std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+	outcome.duration = duration.count();
+	return outcome;
+}
+
 void job::init_logger()
 {
 	if (!job_meta_->log) {
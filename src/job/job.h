@@ -6,6 +6,7 @@
 #include <utility>
 #include <memory>
 #include <algorithm>
+#include <exception>
 
 #define BOOST_FILESYSTEM_NO_DEPRECATED
 #define BOOST_NO_CXX11_SCOPED_ENUMS
@@ -66,8 +67,9 @@ public:
 
 	/**
 	 * Runs all task which are sorted in task queue and get results from all of them.
+	 * Independent tasks can be executed in parallel, the number of them is given by worker configuration.
 	 * Should not throw an exception.
-	 * @return Vector with pairs task id - task_results. Values are not @a nullptr.
+	 * @return Vector with pairs task id - task_results ordered as task queue. Values are not @a nullptr.
 	 * @throws task_exception in case of internal execution error
 	 * @throws std::exception in case of fatal error
 	 */
@@ -80,6 +82,26 @@ public:
 	const std::vector<std::shared_ptr<task_base>> &get_task_queue() const;
 
 private:
+	/**
+	 * Outcome of one task execution which is handed over from executing thread back to the job.
+	 */
+	struct task_outcome {
+		/** Position of the task in the task queue. */
+		std::size_t position;
+		/** Results returned by the task, can be @a nullptr. */
+		std::shared_ptr<task_results> results;
+		/** Exception thrown during task execution, @a nullptr if there was none. */
+		std::exception_ptr failure;
+		/** Duration of the execution in seconds, it is added to the results by the job, not by executing thread. */
+		double duration = 0;
+	};
+
+	/**
+	 * Run task on given position in task queue and catch everything it throws.
+	 * @param position index of the task in task queue
+	 * @return outcome of the execution
+	 */
+	task_outcome execute_task(std::size_t position);
 	/**
 	 * Check directories given during construction for existence.
 	 */
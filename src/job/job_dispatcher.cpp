@@ -0,0 +1,86 @@
+#include "job_dispatcher.h"
+#include "connection_proxy.h"
+#include "helpers/zmq_socket.h"
+#include <algorithm>
+
+
+job_dispatcher::job_dispatcher(
+	const std::shared_ptr<zmq::context_t> &context, std::size_t slots, std::shared_ptr<spdlog::logger> logger)
+	: socket_(*context, ZMQ_PAIR), slot_jobs_(slots, 0), logger_(logger)
+{
+	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
+
+	for (std::size_t i = 0; i < slots; ++i) {
+		slot_sockets_.emplace_back(new zmq::socket_t(*context, ZMQ_PAIR));
+		slot_sockets_.back()->bind("inproc://" + get_slot_socket_id(i));
+	}
+}
+
+std::string job_dispatcher::get_slot_socket_id(std::size_t slot)
+{
+	return JOB_SOCKET_ID + "-" + std::to_string(slot);
+}
+
+void job_dispatcher::dispatch(const std::vector<std::string> &message)
+{
+	// first slot with the lowest number of jobs, so that idle slots are preferred to queues of busy ones
+	auto it = std::min_element(slot_jobs_.begin(), slot_jobs_.end());
+	std::size_t slot = it - slot_jobs_.begin();
+
+	if (message.size() >= 2) { logger_->info("Job-dispatcher: Job {} sent to slot {}.", message[1], slot); }
+	helpers::send_through_socket(*slot_sockets_[slot], message);
+	++slot_jobs_[slot];
+}
+
+void job_dispatcher::start_dispatching()
+{
+	socket_.connect("inproc://" + JOB_SOCKET_ID);
+
+	// the first item is the socket of broker connection, the others belong to the slots
+	std::vector<zmq::pollitem_t> items;
+	items.push_back({(void *) socket_, 0, ZMQ_POLLIN, 0});
+	for (auto &slot_socket : slot_sockets_) { items.push_back({(void *) *slot_socket, 0, ZMQ_POLLIN, 0}); }
+
+	while (true) {
+		try {
+			zmq::poll(items.data(), items.size(), -1);
+
+			std::vector<std::string> message;
+			bool terminate = false;
+
+			if (items[0].revents & ZMQ_POLLIN) {
+				if (!helpers::recv_from_socket(socket_, message, &terminate)) {
+					if (terminate) { break; }
+					logger_->warn("Job-dispatcher: failed to receive message. Skipping...");
+				} else if (!message.empty()) {
+					dispatch(message);
+				}
+			}
+
+			for (std::size_t slot = 0; slot < slot_sockets_.size(); ++slot) {
+				if (!(items[slot + 1].revents & ZMQ_POLLIN)) { continue; }
+
+				if (!helpers::recv_from_socket(*slot_sockets_[slot], message, &terminate)) {
+					if (terminate) { break; }
+					logger_->warn("Job-dispatcher: failed to receive message from slot {}. Skipping...", slot);
+					continue;
+				}
+
+				if (!message.empty() && message[0] == "done" && slot_jobs_[slot] > 0) { --slot_jobs_[slot]; }
+				helpers::send_through_socket(socket_, message);
+			}
+
+			if (terminate) { break; }
+		} catch (zmq::error_t &e) {
+			// polling of the sockets fails when the context is terminated
+			if (e.num() == ETERM) { break; }
+			logger_->error("Job-dispatcher: unexpected error occured: {}", e.what());
+		} catch (std::exception &e) {
+			logger_->error("Job-dispatcher: unexpected error occured: {}", e.what());
+		}
+	}
+
+	// terminated context waits until all its sockets are closed
+	socket_.close();
+	for (auto &slot_socket : slot_sockets_) { slot_socket->close(); }
+}
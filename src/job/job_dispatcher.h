@@ -0,0 +1,56 @@
+#ifndef RECODEX_WORKER_JOB_DISPATCHER_H
+#define RECODEX_WORKER_JOB_DISPATCHER_H
+
+
+#include <zmq.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include "helpers/logger.h"
+
+/**
+ * Job dispatcher distributes jobs received by broker_connection among evaluation slots of the worker.
+ * Every slot has its own @ref job_receiver connected to the dispatcher by an inproc socket, new job is
+ * sent to the slot with the lowest number of unfinished jobs. Done replies of the slots are passed back.
+ * Dispatcher is used only if there is more than one slot.
+ */
+class job_dispatcher
+{
+private:
+	zmq::socket_t socket_;
+	std::vector<std::unique_ptr<zmq::socket_t>> slot_sockets_;
+	std::vector<std::size_t> slot_jobs_;
+	std::shared_ptr<spdlog::logger> logger_;
+
+	/**
+	 * Send the job to the least loaded slot.
+	 * @param message eval command
+	 */
+	void dispatch(const std::vector<std::string> &message);
+
+public:
+	/**
+	 * Construct dispatcher and bind sockets of all slots.
+	 * @param context ZeroMQ context of the worker
+	 * @param slots number of evaluation slots
+	 * @param logger pointer to logging class
+	 */
+	job_dispatcher(
+		const std::shared_ptr<zmq::context_t> &context, std::size_t slots, std::shared_ptr<spdlog::logger> logger);
+
+	/**
+	 * Get identifier of inproc socket to which job receiver of the slot connects.
+	 * @param slot index of the slot
+	 * @return socket identifier
+	 */
+	static std::string get_slot_socket_id(std::size_t slot);
+
+	/**
+	 * Receive jobs from broker connection and replies from the slots and pass them on.
+	 * Blocks execution until the context is terminated, the sockets are closed then.
+	 */
+	void start_dispatching();
+};
+
+
+#endif // RECODEX_WORKER_JOB_DISPATCHER_H
@@ -4,19 +4,25 @@
 #include "fileman/fallback_file_manager.h"
 #include "fileman/prefixed_file_manager.h"
 #include "helpers/config.h"
+#include "helpers/metrics.h"
+#include "sandbox/isolate_box_pool.h"
 
 job_evaluator::job_evaluator(std::shared_ptr<spdlog::logger> logger,
 	std::shared_ptr<worker_config> config,
 	std::shared_ptr<file_manager_interface> remote_fm,
 	std::shared_ptr<file_manager_interface> cache_fm,
 	fs::path working_directory,
-	std::shared_ptr<progress_callback_interface> progr_callback)
+	std::shared_ptr<progress_callback_interface> progr_callback,
+	std::shared_ptr<isolate_box_pool> box_pool)
 	: working_directory_(working_directory), job_(nullptr), job_results_(), remote_fm_(remote_fm), cache_fm_(cache_fm),
-	  logger_(logger), config_(config), progress_callback_(progr_callback)
+	  logger_(logger), config_(config), progress_callback_(progr_callback), box_pool_(box_pool)
 {
 	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
 
 	init_progress_callback();
+
+	uploader_ = std::make_shared<result_uploader>(
+		remote_fm_, progress_callback_, logger_, config_->get_upload_queue_size(), config_->get_upload_retries());
 }
 
 void job_evaluator::init_progress_callback()
@@ -24,40 +30,141 @@ void job_evaluator::init_progress_callback()
 	if (progress_callback_ == nullptr) { progress_callback_ = std::make_shared<empty_progress_callback>(); }
 }
 
-void job_evaluator::download_submission()
+void job_evaluator::download_submission(std::future<void> &prefetched)
 {
+	// submission is extracted while it is downloaded, so the phase includes both
+	helpers::phase_timer timer(job_timings_, "download");
+
+	if (prefetched.valid()) {
+		logger_->info("Waiting for prefetched submission archive...");
+		try {
+			prefetched.get();
+			logger_->info("Submission archive prefetched succesfully.");
+			progress_callback_->job_archive_downloaded(job_id_);
+			return;
+		} catch (std::exception &e) {
+			logger_->warn("Prefetching of submission failed, it will be downloaded again: {}", e.what());
+			cleanup_submission();
+		}
+	}
+
 	logger_->info("Trying to download submission archive...");
+	fetch_submission(job_id_, archive_url_);
+	logger_->info("Submission archive downloaded succesfully.");
+	progress_callback_->job_archive_downloaded(job_id_);
+	return;
+}
+
+void job_evaluator::fetch_submission(const std::string &job_id, const std::string &archive_url)
+{
+	fs::path archive_path = get_submission_path("downloads", job_id);
+	fs::path source_path = get_submission_path("eval", job_id);
+
+	try {
+		fs::create_directories(source_path);
+	} catch (fs::filesystem_error &e) {
+		throw job_exception("Cannot create directory for submission sources: " + std::string(e.what()));
+	}
+
+	// archive is extracted while it is downloaded, so it is not written to the disk and read back
+	try {
+		auto input = remote_fm_->open_file(archive_url);
+		archivator::decompress(*input, source_path.string());
+		fs::permissions(source_path, fs::add_perms | fs::group_write | fs::others_write);
+		return;
+	} catch (archive_exception &e) {
+		// some archives (e.g. zip without sizes in local headers) cannot be read sequentially
+		logger_->warn("Submission cannot be extracted during download, it is downloaded first: {}", e.what());
+	} catch (fs::filesystem_error &e) {
+		throw job_exception("Cannot set permissions of submission sources: " + std::string(e.what()));
+	}
 
-	// create directory for downloaded archive
-	fs::path archive_url = archive_url_;
+	// create directory for downloaded archive and start again with clean sources
 	try {
-		fs::create_directories(archive_path_);
+		fs::remove_all(source_path);
+		fs::create_directories(source_path);
+		fs::create_directories(archive_path);
 	} catch (fs::filesystem_error &e) {
 		throw job_exception(std::string("Cannot create archive directory for submission archives: ") + e.what());
 	}
 
 	// download a file
-	archive_name_ = archive_url.filename();
-	remote_fm_->get_file(archive_url.string(), (archive_path_ / archive_name_).string());
+	fs::path archive_file = archive_path / fs::path(archive_url).filename();
+	remote_fm_->get_file(archive_url, archive_file.string());
 
-	logger_->info("Submission archive downloaded succesfully.");
-	progress_callback_->job_archive_downloaded(job_id_);
-	return;
+	// decompress downloaded archive directly to source path (eval dir)
+	try {
+		archivator::decompress(archive_file.string(), source_path.string());
+		fs::permissions(source_path, fs::add_perms | fs::group_write | fs::others_write);
+	} catch (archive_exception &e) {
+		throw job_exception("Downloaded submission cannot be decompressed: " + std::string(e.what()));
+	} catch (fs::filesystem_error &e) {
+		throw job_exception("Cannot set permissions of submission sources: " + std::string(e.what()));
+	}
 }
 
-void job_evaluator::prepare_submission()
+void job_evaluator::prefetch(eval_request request)
 {
-	logger_->info("Preparing submission for usage...");
+	logger_->info("Prefetching submission of job {}", request.job_id);
+
+	auto result = std::async(std::launch::async, [this, request]() {
+		// directories might be left from previous unsuccessful evaluation of the same job
+		boost::system::error_code error;
+		fs::remove_all(get_submission_path("downloads", request.job_id), error);
+		fs::remove_all(get_submission_path("eval", request.job_id), error);
+
+		fetch_submission(request.job_id, request.job_url);
+	});
+
+	std::string previous_job_id;
+	std::future<void> previous;
+	{
+		std::lock_guard<std::mutex> lock(prefetch_mutex_);
+		previous_job_id = prefetched_job_id_;
+		previous = std::move(prefetched_);
+		prefetched_job_id_ = request.job_id;
+		prefetched_ = std::move(result);
+	}
+	if (previous.valid()) { discard_prefetched(previous_job_id, previous); }
+}
 
-	// decompress downloaded archive directly to source path (eval dir)
+std::future<void> job_evaluator::take_prefetched(const std::string &job_id)
+{
+	std::string prefetched_job_id;
+	std::future<void> prefetched;
+	{
+		std::lock_guard<std::mutex> lock(prefetch_mutex_);
+		prefetched_job_id = prefetched_job_id_;
+		prefetched = std::move(prefetched_);
+		prefetched_job_id_ = "";
+	}
+
+	if (!prefetched.valid() || prefetched_job_id == job_id) { return prefetched; }
+
+	// broker sent another job than the one which was queued
+	discard_prefetched(prefetched_job_id, prefetched);
+	return std::future<void>();
+}
+
+void job_evaluator::discard_prefetched(const std::string &job_id, std::future<void> &prefetched)
+{
+	logger_->warn("Prefetched job {} was not evaluated, its submission is removed", job_id);
 	try {
-		fs::create_directories(source_path_);
-		archivator::decompress((archive_path_ / archive_name_).string(), source_path_.string());
-		fs::permissions(source_path_, fs::add_perms | fs::group_write | fs::others_write);
-	} catch (archive_exception &e) {
-		throw job_exception("Downloaded submission cannot be decompressed: " + std::string(e.what()));
+		prefetched.get();
+	} catch (std::exception &) {
+		// errors of unused submission do not matter
 	}
 
+	boost::system::error_code error;
+	fs::remove_all(get_submission_path("downloads", job_id), error);
+	fs::remove_all(get_submission_path("eval", job_id), error);
+}
+
+void job_evaluator::prepare_submission()
+{
+	helpers::phase_timer timer(job_timings_, "prepare");
+	logger_->info("Preparing submission for usage...");
+
 	try {
 		fs::create_directories(results_path_);
 	} catch (fs::filesystem_error &e) {
@@ -78,6 +185,7 @@ void job_evaluator::prepare_submission()
 void job_evaluator::build_job()
 {
 	namespace fs = boost::filesystem;
+	helpers::phase_timer timer(job_timings_, "build");
 	logger_->info("Building job...");
 
 	// find job-config.yml to load configuration
@@ -119,7 +227,7 @@ void job_evaluator::build_job()
 	auto task_fileman = std::make_shared<fallback_file_manager>(
 		cache_fm_, std::make_shared<prefixed_file_manager>(remote_fm_, job_meta->file_server_url + "/"));
 
-	auto factory = std::make_shared<task_factory>(task_fileman);
+	auto factory = std::make_shared<task_factory>(task_fileman, box_pool_, config_->get_compression_threads());
 
 	// ... and construct job itself
 	job_ = std::make_shared<job>(
@@ -131,6 +239,7 @@ void job_evaluator::build_job()
 
 void job_evaluator::run_job()
 {
+	helpers::phase_timer timer(job_timings_, "run");
 	logger_->info("Ready for evaluation...");
 	job_results_ = job_->run();
 	logger_->info("Job evaluated.");
@@ -138,19 +247,24 @@ void job_evaluator::run_job()
 
 void job_evaluator::init_submission_paths()
 {
-	source_path_ = working_directory_ / "eval" / std::to_string(config_->get_worker_id()) / job_id_;
-	archive_path_ = working_directory_ / "downloads" / std::to_string(config_->get_worker_id()) / job_id_;
+	source_path_ = get_submission_path("eval", job_id_);
+	archive_path_ = get_submission_path("downloads", job_id_);
 	// set temporary directory for tasks in job
-	job_temp_dir_ = working_directory_ / "temp" / std::to_string(config_->get_worker_id()) / job_id_;
-	results_path_ = working_directory_ / "results" / std::to_string(config_->get_worker_id()) / job_id_;
+	job_temp_dir_ = get_submission_path("temp", job_id_);
+	results_path_ = get_submission_path("results", job_id_);
 }
 
-void job_evaluator::cleanup_submission()
+fs::path job_evaluator::get_submission_path(const std::string &kind, const std::string &job_id) const
+{
+	return working_directory_ / kind / std::to_string(config_->get_worker_id()) / job_id;
+}
+
+void job_evaluator::cleanup_submission(bool sources)
 {
 
 	// cleanup source code directory after job evaluation
 	try {
-		if (fs::exists(source_path_)) {
+		if (sources && fs::exists(source_path_)) {
 			logger_->info("Cleaning up source code directory...");
 			fs::remove_all(source_path_);
 		}
@@ -160,7 +274,7 @@ void job_evaluator::cleanup_submission()
 
 	// delete downloaded archive directory
 	try {
-		if (fs::exists(archive_path_)) {
+		if (sources && fs::exists(archive_path_)) {
 			logger_->info("Cleaning up directory containing downloaded archive...");
 			fs::remove_all(archive_path_);
 		}
@@ -195,23 +309,25 @@ void job_evaluator::cleanup_variables()
 {
 	try {
 		archive_url_ = "";
-		archive_name_ = "";
 		archive_path_ = "";
 		source_path_ = "";
 		results_path_ = "";
 		result_url_ = "";
+		result_format_ = "";
 
 		job_id_ = "";
 		job_ = nullptr;
+		job_results_.clear();
+		job_timings_.clear();
 	} catch (std::exception &e) {
 		logger_->error("Error in deinicialization of evaluator: {}", e.what());
 	}
 }
 
-void job_evaluator::prepare_evaluator()
+void job_evaluator::prepare_evaluator(bool prefetched)
 {
 	init_submission_paths();
-	cleanup_submission();
+	cleanup_submission(!prefetched);
 }
 
 void job_evaluator::cleanup_evaluator()
@@ -219,27 +335,41 @@ void job_evaluator::cleanup_evaluator()
 	if (config_->get_cleanup_submission() == true) { cleanup_submission(); }
 
 	cleanup_variables();
+
+#ifndef _WIN32
+	// boxes kept for test batches of the job are reset for the next job
+	if (box_pool_ != nullptr) { box_pool_->release_batches(); }
+#endif
 }
 
-void job_evaluator::push_result()
+std::shared_future<eval_response> job_evaluator::push_result()
 {
 	logger_->info("Trying to upload results of job...");
 
 	// just checkout for errors
 	if (job_ == nullptr) {
 		logger_->error("Pointer to job is null.");
-		return;
+		return std::shared_future<eval_response>();
 	}
 
-	// define path to result yaml file and archived result
+	// define path to result yaml file and archived result, the archive is staged outside of results directory,
+	// because it can be cleaned up before the upload ends
 	fs::path result_yaml = results_path_ / "result.yml";
-	fs::path archive_path = results_path_ / "result.zip";
+	archive_type format = archive_type::ZIP;
+	try {
+		format = archivator::parse_format(result_format_);
+	} catch (archive_exception &e) {
+		logger_->warn("{} Results are archived in zip format.", e.what());
+	}
+	fs::path archive_path =
+		get_submission_path("uploads", job_id_).string() + "." + archivator::get_format_name(format);
 
 	logger_->info("Building yaml results file...");
 	// build yaml tree
 	YAML::Node res;
 	res["job-id"] = job_id_;
 	res["hw-group"] = config_->get_hwgroup();
+	for (auto &timing : job_timings_) { res["timings"][timing.first] = timing.second; }
 	for (auto &i : job_results_) {
 		YAML::Node node;
 		node["task-id"] = i.first;
@@ -281,16 +411,27 @@ void job_evaluator::push_result()
 			subnode["message"] = sandbox->message;
 			subnode["csw-voluntary"] = sandbox->csw_voluntary;
 			subnode["csw-forced"] = sandbox->csw_forced;
+			if (sandbox->cgroup_stats) {
+				subnode["memory-peak"] = sandbox->memory_peak;
+				subnode["io-read"] = sandbox->io_read;
+				subnode["io-write"] = sandbox->io_write;
+				subnode["throttled"] = sandbox->throttled;
+				subnode["throttled-time"] = sandbox->throttled_time;
+				subnode["oom-kills"] = sandbox->oom_kills;
+			}
 
 			node["sandbox_results"] = subnode;
 		}
 
+		for (auto &timing : i.second->timings) { node["timings"][timing.first] = timing.second; }
+
 		res["results"].push_back(node);
 	}
 
 	// make sure the yaml is ascii encoded
 	YAML::Emitter yaml_out;
 	yaml_out.SetOutputCharset(YAML::EscapeNonAscii);
+	yaml_out.SetDoublePrecision(6);
 	yaml_out << res;
 	// open output stream and write constructed yaml
 	std::ofstream out(result_yaml.string());
@@ -300,23 +441,48 @@ void job_evaluator::push_result()
 
 	// compress given result.yml file
 	logger_->info("Compression of results file...");
+	helpers::phase_timer timer(job_timings_, "packaging");
 	try {
-		archivator::compress(results_path_.string(), archive_path.string());
+		fs::create_directories(archive_path.parent_path());
+		archivator::compress(results_path_.string(),
+			archive_path.string(),
+			format,
+			config_->get_result_compression_level(),
+			config_->get_compression_threads(),
+			logger_);
 	} catch (archive_exception &e) {
 		logger_->error("Results file not archived properly: {}", e.what());
-		return;
+		return std::shared_future<eval_response>();
+	} catch (fs::filesystem_error &e) {
+		logger_->error("Directory for results archive cannot be created: {}", e.what());
+		return std::shared_future<eval_response>();
 	}
+	timer.stop();
 	logger_->info("Compression done.");
 
-	// send archived result to file server
-	remote_fm_->put_file(archive_path.string(), result_url_);
+	// send archived result to file server, uploader reports the end of the job
+	return uploader_->upload(job_id_, archive_path.string(), result_url_);
+}
 
-	logger_->info("Job results uploaded succesfully.");
-	progress_callback_->job_results_uploaded(job_id_);
-	return;
+void job_evaluator::log_timings()
+{
+	logger_->info("Timings of job {}: {}", job_id_, helpers::format_timings(job_timings_));
+
+	helpers::phase_timings task_timings;
+	for (auto &result : job_results_) {
+		if (result.second != nullptr) { helpers::add_timings(task_timings, result.second->timings); }
+	}
+	if (!task_timings.empty()) {
+		logger_->info("Timings of tasks of job {} summed: {}", job_id_, helpers::format_timings(task_timings));
+	}
 }
 
 eval_response job_evaluator::evaluate(eval_request request)
+{
+	return evaluate_async(request).get();
+}
+
+std::shared_future<eval_response> job_evaluator::evaluate_async(eval_request request)
 {
 	logger_->info("Request for job evaluation arrived to worker");
 	logger_->info("Job ID of incoming job is: {}", request.job_id);
@@ -325,19 +491,27 @@ eval_response job_evaluator::evaluate(eval_request request)
 	job_id_ = request.job_id;
 	archive_url_ = request.job_url;
 	result_url_ = request.result_url;
+	result_format_ = request.result_format.empty() ? config_->get_result_format() : request.result_format;
 
 	// prepare response which will be sent to broker
 	eval_response_holder response(request.job_id, "OK");
+	auto started = std::chrono::steady_clock::now();
+
+	// submission might be already downloaded while the previous job was evaluated
+	std::future<void> prefetched = take_prefetched(job_id_);
 
-	prepare_evaluator();
+	std::shared_future<eval_response> uploaded;
+
+	prepare_evaluator(prefetched.valid());
 	try {
-		download_submission();
+		download_submission(prefetched);
 		prepare_submission();
 		build_job();
 		run_job();
-		push_result();
+		uploaded = push_result();
 
-		progress_callback_->job_finished(job_id_);
+		// results which are not uploaded end the job right away
+		if (!uploaded.valid()) { progress_callback_->job_finished(job_id_); }
 
 	} catch (job_unrecoverable_exception &e) {
 		logger_->error("Job evaluator encountered unrecoverable error: {}", e.what());
@@ -353,8 +527,16 @@ eval_response job_evaluator::evaluate(eval_request request)
 		response.set_result("INTERNAL_ERROR", e.what());
 	}
 
+	std::chrono::duration<double> duration = std::chrono::steady_clock::now() - started;
+	helpers::metrics().job_duration.observe(duration.count());
+
+	log_timings();
 	logger_->info("Job ({}) ended.", job_id_);
 	cleanup_evaluator();
 
-	return response.get_eval_response();
+	if (uploaded.valid()) { return uploaded; }
+
+	std::promise<eval_response> result;
+	result.set_value(response.get_eval_response());
+	return result.get_future().share();
 }
@@ -5,6 +5,8 @@
 #include <fstream>
 #include <vector>
 #include <utility>
+#include <future>
+#include <mutex>
 #include "helpers/logger.h"
 
 #define BOOST_FILESYSTEM_NO_DEPRECATED
@@ -18,7 +20,9 @@ namespace fs = boost::filesystem;
 #include "tasks/task_factory.h"
 #include "archives/archivator.h"
 #include "helpers/filesystem.h"
+#include "helpers/timings.h"
 #include "job_evaluator_interface.h"
+#include "result_uploader.h"
 
 
 /**
@@ -41,28 +45,69 @@ public:
 	 * @param cache_fm a file manager that works with a local cache
 	 * @param working_directory a directory in which the evaluation is done
 	 * @param progr_callback a callback for notifying the broker of progress
+	 * @param box_pool a pool of initialized isolate boxes used by sandboxed tasks (optional)
 	 */
 	job_evaluator(std::shared_ptr<spdlog::logger> logger,
 		std::shared_ptr<worker_config> config,
 		std::shared_ptr<file_manager_interface> remote_fm,
 		std::shared_ptr<file_manager_interface> cache_fm,
 		fs::path working_directory,
-		std::shared_ptr<progress_callback_interface> progr_callback);
+		std::shared_ptr<progress_callback_interface> progr_callback,
+		std::shared_ptr<isolate_box_pool> box_pool = nullptr);
 
 	/**
-	 * Process an "eval" request
+	 * Process an "eval" request, returns after the results are uploaded
 	 */
 	eval_response evaluate(eval_request request) override;
 
+	/**
+	 * Process an "eval" request, returns when the results are staged for upload
+	 */
+	std::shared_future<eval_response> evaluate_async(eval_request request) override;
+
+	/**
+	 * Start downloading and decompressing submission of the job in background.
+	 * Only one job can be prefetched, the previous prefetched job is forgotten.
+	 */
+	void prefetch(eval_request request) override;
+
 private:
 	/**
-	 * Download submission from remote source through filemanager given during construction.
+	 * Download submission from remote source through filemanager given during construction
+	 * or wait for the submission which was prefetched.
+	 * @param prefetched result of the prefetching, invalid if the submission was not prefetched
+	 */
+	void download_submission(std::future<void> &prefetched);
+
+	/**
+	 * Download submission archive of given job and decompress it into its source directory.
+	 * The archive is extracted during the download, only archives which cannot be read sequentially are
+	 * stored in the downloads directory first.
+	 * Does not touch any member variables, so it can run in parallel with evaluation of another job.
+	 * @param job_id identification of the job
+	 * @param archive_url URL of the submission archive
+	 */
+	void fetch_submission(const std::string &job_id, const std::string &archive_url);
+
+	/**
+	 * Take over result of prefetching if it belongs to the given job. Prefetched submission
+	 * of any other job is waited for and removed.
+	 * @param job_id identification of the job which is going to be evaluated
+	 * @return result of the prefetching, invalid if the submission was not prefetched
+	 */
+	std::future<void> take_prefetched(const std::string &job_id);
+
+	/**
+	 * Wait for prefetching which is not needed anymore and remove the submission.
+	 * No throw function.
+	 * @param job_id identification of the prefetched job
+	 * @param prefetched result of the prefetching
 	 */
-	void download_submission();
+	void discard_prefetched(const std::string &job_id, std::future<void> &prefetched);
 
 	/**
 	 * Downloaded submission has prepared for evaluation, that means:
-	 * Decompress archive with submission and copy source codes to working directory.
+	 * Create directories for results and temporary files of tasks.
 	 */
 	void prepare_submission();
 
@@ -84,14 +129,16 @@ private:
 	/**
 	 * Cleanup decompressed archive and all other temporary files.
 	 * This function should never throw an exception.
+	 * @param sources if false, downloaded archive and decompressed sources are kept
 	 */
-	void cleanup_submission();
+	void cleanup_submission(bool sources = true);
 
 	/**
 	 * Prepare submission paths and cleanup to be sure that nothing left from last evaluation.
 	 * No throw function.
+	 * @param prefetched if true, submission of the job is already downloaded and it is kept
 	 */
-	void prepare_evaluator();
+	void prepare_evaluator(bool prefetched);
 
 	/**
 	 * Cleanup all variables before new iteration.
@@ -99,6 +146,11 @@ private:
 	 */
 	void cleanup_evaluator();
 
+	/**
+	 * Write durations of phases of the job and summed durations of phases of its tasks to the log.
+	 */
+	void log_timings();
+
 	/**
 	 * Set variables which are connected to submission to defaults.
 	 * No throw function.
@@ -106,10 +158,10 @@ private:
 	void cleanup_variables();
 
 	/**
-	 * Get results from job and push them to filemanager.
-	 * Upload output files using the filemanager (if desired)
+	 * Get results from job and hand them over to the uploader.
+	 * @return response which is ready when the results are uploaded
 	 */
-	void push_result();
+	std::shared_future<eval_response> push_result();
 
 	/**
 	 * Initialize all paths used in job_evaluator. Has to be done before any other action.
@@ -117,6 +169,14 @@ private:
 	 */
 	void init_submission_paths();
 
+	/**
+	 * Get directory of given kind which belongs to the job.
+	 * @param kind name of the directory kind (eval, downloads, temp, results)
+	 * @param job_id identification of the job
+	 * @return path to the directory
+	 */
+	fs::path get_submission_path(const std::string &kind, const std::string &job_id) const;
+
 	/**
 	 * Initialize progress callback.
 	 * If given callback is nullptr, then construct empty one which can be called without doubts.
@@ -129,23 +189,25 @@ private:
 	fs::path working_directory_;
 	/** URL of remote archive in which is job configuration and source codes */
 	std::string archive_url_;
-	/** Archive filename is just a name and not a path */
-	fs::path archive_name_;
 	/** Path in which downloaded archive is stored */
 	fs::path archive_path_;
 	/** Path only with source codes and job configuration, no subfolders */
 	fs::path source_path_;
-	/** Results path in which result.yml and result.zip are stored */
+	/** Results path in which result.yml and other results are stored */
 	fs::path results_path_;
 	/** Path for saving temporary files by tasks */
 	fs::path job_temp_dir_;
 	/** Url of remote file server which receives result of jobs */
 	std::string result_url_;
+	/** Format of the archive with results, requested by broker or configured */
+	std::string result_format_;
 
 	/** ID of downloaded job obtained from broker */
 	std::string job_id_;
 	/** Structure of job itself, this will be evaluated */
 	std::shared_ptr<job> job_;
+	/** Durations of phases of the current job, upload is not included, it ends after the evaluation. */
+	helpers::phase_timings job_timings_;
 	/** Results of all evaluated tasks included in job. */
 	std::vector<std::pair<std::string, std::shared_ptr<task_results>>> job_results_;
 
@@ -159,6 +221,17 @@ private:
 	std::shared_ptr<worker_config> config_;
 	/** Progress callback which is used to signal progress to whoever wants */
 	std::shared_ptr<progress_callback_interface> progress_callback_;
+	/** Pool of isolate boxes given to task factory, can be @a nullptr */
+	std::shared_ptr<isolate_box_pool> box_pool_;
+	/** Uploader of the results, which may upload them in background */
+	std::shared_ptr<result_uploader> uploader_;
+
+	/** ID of the job which submission is prefetched, empty if there is none */
+	std::string prefetched_job_id_;
+	/** Result of the prefetching, rethrows an error of downloading or decompression */
+	std::future<void> prefetched_;
+	/** Guards prefetching data, prefetch is requested from another thread than evaluation runs in */
+	std::mutex prefetch_mutex_;
 };
 
 #endif // RECODEX_WORKER_JOB_EVALUATOR_HPP
@@ -1,6 +1,7 @@
 #ifndef RECODEX_WORKER_JOB_EVALUATOR_BASE_H
 #define RECODEX_WORKER_JOB_EVALUATOR_BASE_H
 
+#include <future>
 #include "eval_request.h"
 #include "eval_response.h"
 
@@ -20,6 +21,26 @@ public:
 	 * Process an "eval" request
 	 */
 	virtual eval_response evaluate(eval_request request) = 0;
+
+	/**
+	 * Process an "eval" request, but leave the upload of results to the background.
+	 * Default implementation evaluates the job synchronously.
+	 * @return response which is ready when the results are uploaded
+	 */
+	virtual std::shared_future<eval_response> evaluate_async(eval_request request)
+	{
+		std::promise<eval_response> response;
+		response.set_value(evaluate(request));
+		return response.get_future().share();
+	}
+
+	/**
+	 * Prepare a job which will be evaluated next while the current one is still running.
+	 * Default implementation does nothing, everything is done in @ref evaluate then.
+	 */
+	virtual void prefetch(eval_request request)
+	{
+	}
 };
 
 #endif // RECODEX_WORKER_JOB_EVALUATOR_BASE_H
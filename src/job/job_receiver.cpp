@@ -3,18 +3,22 @@
 #include "eval_request.h"
 #include "eval_response.h"
 #include "helpers/zmq_socket.h"
+#include "helpers/metrics.h"
 #include "commands/jobs_client_commands.h"
 
 
 job_receiver::job_receiver(const std::shared_ptr<zmq::context_t> &context,
 	std::shared_ptr<job_evaluator_interface> evaluator,
-	std::shared_ptr<spdlog::logger> logger)
-	: socket_(*context, ZMQ_PAIR), evaluator_(evaluator), logger_(logger)
+	std::shared_ptr<spdlog::logger> logger,
+	bool prefetch,
+	const std::string &socket_id)
+	: socket_(*context, ZMQ_PAIR), evaluator_(evaluator), logger_(logger), socket_id_(socket_id)
 {
 	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
+	if (socket_id_.empty()) { socket_id_ = JOB_SOCKET_ID; }
 
 	// init depandent command structure
-	job_client_context dependent_context = {evaluator_, socket_};
+	job_client_context dependent_context = {evaluator_, socket_, prefetch, postponed_, pending_};
 
 	// init command structure
 	commands_ = std::make_shared<command_holder<job_client_context>>(dependent_context, logger_);
@@ -23,22 +27,42 @@ job_receiver::job_receiver(const std::shared_ptr<zmq::context_t> &context,
 
 void job_receiver::start_receiving()
 {
-	socket_.connect("inproc://" + JOB_SOCKET_ID);
+	socket_.connect("inproc://" + socket_id_);
 
 	while (true) {
-		logger_->info("Job-receiver: Waiting for incomings requests...");
-
 		try {
+			jobs_client_commands::send_finished(socket_, pending_, logger_);
+
 			std::vector<std::string> message;
-			bool terminate;
-			if (!helpers::recv_from_socket(socket_, message, &terminate)) {
-				if (terminate) { break; }
-				logger_->warn("Job-receiver: failed to receive message. Skipping...");
-				continue;
+			bool terminate = false;
+			if (!postponed_.empty()) {
+				// message was received during evaluation of the previous job
+				message = postponed_.front();
+				postponed_.pop_front();
+				helpers::metrics().queued_jobs.add(-1);
+			} else {
+				if (pending_.empty()) {
+					logger_->info("Job-receiver: Waiting for incomings requests...");
+				} else {
+					// results are still uploaded, their replies are sent as soon as the upload ends
+					zmq::pollitem_t item = {(void *) socket_, 0, ZMQ_POLLIN, 0};
+					zmq::poll(&item, 1, 100);
+					if (!(item.revents & ZMQ_POLLIN)) { continue; }
+				}
+
+				if (!helpers::recv_from_socket(socket_, message, &terminate)) {
+					if (terminate) { break; }
+					logger_->warn("Job-receiver: failed to receive message. Skipping...");
+					continue;
+				}
 			}
 
 			// Invoke command callback
 			if (!message.empty()) { commands_->call_function(message[0], message); }
+		} catch (zmq::error_t &e) {
+			// polling of the socket fails when the context is terminated
+			if (e.num() == ETERM) { break; }
+			logger_->error("Job-receiver: unexpected error occured: {}", e.what());
 		} catch (std::exception &e) {
 			logger_->error("Job-receiver: unexpected error occured: {}", e.what());
 		}
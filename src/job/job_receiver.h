@@ -5,6 +5,7 @@
 #include <zmq.hpp>
 #include <vector>
 #include <string>
+#include <deque>
 #include "job_evaluator_interface.h"
 #include "commands/command_holder.h"
 #include "helpers/logger.h"
@@ -20,6 +21,9 @@ private:
 	std::shared_ptr<job_evaluator_interface> evaluator_;
 	std::shared_ptr<spdlog::logger> logger_;
 	std::shared_ptr<command_holder<job_client_context>> commands_;
+	std::deque<std::vector<std::string>> postponed_;
+	std::deque<std::shared_future<eval_response>> pending_;
+	std::string socket_id_;
 
 public:
 	/**
@@ -27,10 +31,15 @@ public:
 	 * @param context
 	 * @param evaluator evaluator which will evaluate received tasks
 	 * @param logger pointer to logging class
+	 * @param prefetch if true, next job is received and prefetched while the current one is evaluated
+	 * @param socket_id identifier of inproc socket from which jobs are received, empty means the socket of
+	 * broker connection, evaluation slots use sockets of @ref job_dispatcher
 	 */
 	job_receiver(const std::shared_ptr<zmq::context_t> &context,
 		std::shared_ptr<job_evaluator_interface> evaluator,
-		std::shared_ptr<spdlog::logger> logger);
+		std::shared_ptr<spdlog::logger> logger,
+		bool prefetch = false,
+		const std::string &socket_id = "");
 
 	/**
 	 * Receive jobs from an inproc socket and pass them to the evaluator
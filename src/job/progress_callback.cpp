@@ -21,6 +21,7 @@ void progress_callback::connect()
 void progress_callback::send_job_status(
 	const std::string &func_name, const std::string &job_id, const std::string &job_status)
 {
+	std::lock_guard<std::mutex> lock(mutex_);
 	try {
 		connect();
 		std::vector<std::string> msg = {command_, job_id, job_status};
@@ -69,6 +70,7 @@ void progress_callback::job_aborted(const std::string &job_id)
 void progress_callback::send_task_status(
 	const std::string &func_name, const std::string &job_id, const std::string &task_id, const std::string &task_status)
 {
+	std::lock_guard<std::mutex> lock(mutex_);
 	try {
 		connect();
 		std::vector<std::string> msg = {command_, job_id, "TASK", task_id, task_status};
@@ -5,6 +5,7 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
 #include <spdlog/spdlog.h>
 
 #include "progress_callback_interface.h"
@@ -12,7 +13,7 @@
 /**
  * Progress callback implementation which is connected to ZMQ inproc socket.
  * Through this socket information about progress are sent to broker_connection and possibly further.
- * @note No throw implementation... All public methods should be safe to use.
+ * @note No throw implementation... All public methods should be safe to use, also from more threads.
  */
 class progress_callback : public progress_callback_interface
 {
@@ -25,6 +26,8 @@ private:
 	bool connected_;
 	/** Spdlog logger shared among whole project */
 	std::shared_ptr<spdlog::logger> logger_;
+	/** Guards the socket, results are reported by uploader thread during evaluation of the next job */
+	std::mutex mutex_;
 
 	/**
 	 * If not connected to inproc socket then connect to it.
@@ -0,0 +1,125 @@
+#include "result_uploader.h"
+#include "helpers/metrics.h"
+#include <cstdio>
+
+
+result_uploader::result_uploader(std::shared_ptr<file_manager_interface> remote_fm,
+	std::shared_ptr<progress_callback_interface> progress_callback,
+	std::shared_ptr<spdlog::logger> logger,
+	std::size_t queue_size,
+	std::size_t retries,
+	std::chrono::milliseconds retry_delay)
+	: remote_fm_(remote_fm), progress_callback_(progress_callback), logger_(logger), queue_size_(queue_size),
+	  retries_(retries), retry_delay_(retry_delay)
+{
+	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
+	if (progress_callback_ == nullptr) { progress_callback_ = std::make_shared<empty_progress_callback>(); }
+
+	if (queue_size_ > 0) { thread_ = std::thread(&result_uploader::work, this); }
+}
+
+result_uploader::~result_uploader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	queued_.notify_all();
+
+	if (thread_.joinable()) { thread_.join(); }
+}
+
+std::shared_future<eval_response> result_uploader::upload(
+	const std::string &job_id, const std::string &archive, const std::string &url)
+{
+	staged_result result;
+	result.job_id = job_id;
+	result.archive = archive;
+	result.url = url;
+	auto response = result.response.get_future().share();
+
+	if (queue_size_ == 0) {
+		process(result);
+		return response;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (queue_.size() >= queue_size_) {
+			logger_->info("Upload queue is full, results of job {} wait for a free place", job_id);
+			dequeued_.wait(lock, [this]() { return queue_.size() < queue_size_; });
+		}
+		queue_.push_back(std::move(result));
+		helpers::metrics().upload_queue.add(1);
+	}
+	queued_.notify_one();
+
+	logger_->info("Results of job {} staged for upload", job_id);
+	return response;
+}
+
+void result_uploader::process(staged_result &result)
+{
+	auto delay = retry_delay_;
+	bool uploaded = false;
+	std::string error;
+	helpers::phase_timings timings;
+	helpers::phase_timer timer(timings, "upload");
+
+	for (std::size_t attempt = 0; attempt <= retries_; ++attempt) {
+		if (attempt > 0) {
+			// stopped uploader does not wait for next attempts
+			std::unique_lock<std::mutex> lock(mutex_);
+			if (queued_.wait_for(lock, delay, [this]() { return stop_; })) { break; }
+			delay *= 2;
+		}
+
+		try {
+			remote_fm_->put_file(result.archive, result.url);
+			uploaded = true;
+			break;
+		} catch (std::exception &e) {
+			error = e.what();
+			logger_->warn("Upload of results of job {} failed (attempt {} of {}): {}",
+				result.job_id,
+				attempt + 1,
+				retries_ + 1,
+				error);
+		}
+	}
+
+	std::remove(result.archive.c_str());
+	timer.stop();
+
+	if (uploaded) {
+		logger_->info("Results of job {} uploaded succesfully: {}", result.job_id, helpers::format_timings(timings));
+		progress_callback_->job_results_uploaded(result.job_id);
+		progress_callback_->job_finished(result.job_id);
+		result.response.set_value(eval_response(result.job_id, "OK"));
+	} else {
+		logger_->error("Results of job {} were not uploaded: {}", result.job_id, error);
+		progress_callback_->job_aborted(result.job_id);
+		result.response.set_value(eval_response(result.job_id, "INTERNAL_ERROR", error));
+	}
+}
+
+void result_uploader::work()
+{
+	while (true) {
+		staged_result result;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			queued_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+
+			// stop only when there is nothing more to upload
+			if (queue_.empty()) { return; }
+
+			result = std::move(queue_.front());
+			queue_.pop_front();
+			helpers::metrics().upload_queue.add(-1);
+		}
+		dequeued_.notify_one();
+
+		process(result);
+	}
+}
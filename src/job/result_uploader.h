@@ -0,0 +1,118 @@
+#ifndef RECODEX_WORKER_RESULT_UPLOADER_H
+#define RECODEX_WORKER_RESULT_UPLOADER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "helpers/logger.h"
+#include "helpers/timings.h"
+#include "eval_response.h"
+#include "fileman/file_manager_interface.h"
+#include "progress_callback_interface.h"
+
+
+/**
+ * Uploads archives with results of evaluated jobs to the file server in a background thread.
+ * Archives wait for the upload in a bounded queue, so the worker can continue with the next job while
+ * the file server is slow, but the disk is not filled by results which cannot be uploaded. Failed uploads
+ * are repeated with exponentially growing delays. When the upload ends, the end of the job is reported
+ * to the progress callback, staged archive is removed and the response for the broker becomes available.
+ */
+class result_uploader
+{
+public:
+	result_uploader() = delete;
+	result_uploader(const result_uploader &source) = delete;
+	result_uploader &operator=(const result_uploader &source) = delete;
+
+	/**
+	 * Constructor starts the background thread, unless the queue size is zero.
+	 * @param remote_fm file manager used for uploading
+	 * @param progress_callback callback notified about uploaded results, it has to be thread safe
+	 * @param logger system logger (optional)
+	 * @param queue_size maximal number of archives waiting for upload, zero means that the archives are
+	 *	uploaded synchronously by @ref upload
+	 * @param retries number of repeated attempts after failed upload
+	 * @param retry_delay delay before the first repeated attempt, it is doubled with every next attempt
+	 */
+	result_uploader(std::shared_ptr<file_manager_interface> remote_fm,
+		std::shared_ptr<progress_callback_interface> progress_callback,
+		std::shared_ptr<spdlog::logger> logger = nullptr,
+		std::size_t queue_size = 0,
+		std::size_t retries = 0,
+		std::chrono::milliseconds retry_delay = std::chrono::milliseconds(1000));
+
+	/**
+	 * Upload all queued archives and stop the background thread. Uploads are not repeated anymore.
+	 */
+	~result_uploader();
+
+	/**
+	 * Stage archive with results for the upload. If the queue is full, wait until there is a free place.
+	 * @param job_id identification of the job
+	 * @param archive path to the archive, it is removed after the upload
+	 * @param url destination of the upload
+	 * @return response for the broker which is ready when the upload ends, result is "OK" on success and
+	 *	"INTERNAL_ERROR" if all attempts failed
+	 */
+	std::shared_future<eval_response> upload(
+		const std::string &job_id, const std::string &archive, const std::string &url);
+
+private:
+	/**
+	 * Archive waiting for the upload.
+	 */
+	struct staged_result {
+		/** Identification of the job */
+		std::string job_id;
+		/** Path to the archive */
+		std::string archive;
+		/** Destination of the upload */
+		std::string url;
+		/** Response which is set when the upload ends */
+		std::promise<eval_response> response;
+	};
+
+	/**
+	 * Upload the archive with all the attempts and fulfill the promised response.
+	 * @param result the archive to be uploaded
+	 */
+	void process(staged_result &result);
+
+	/**
+	 * Body of the background thread, upload archives from the queue until the uploader is destroyed.
+	 */
+	void work();
+
+	/** File manager used for uploading */
+	std::shared_ptr<file_manager_interface> remote_fm_;
+	/** Callback notified about ends of the jobs */
+	std::shared_ptr<progress_callback_interface> progress_callback_;
+	/** System or null logger */
+	std::shared_ptr<spdlog::logger> logger_;
+	/** Maximal number of archives in the queue */
+	std::size_t queue_size_;
+	/** Number of repeated attempts */
+	std::size_t retries_;
+	/** Delay before the first repeated attempt */
+	std::chrono::milliseconds retry_delay_;
+	/** Archives waiting for upload */
+	std::deque<staged_result> queue_;
+	/** Guards the queue and the stop flag */
+	std::mutex mutex_;
+	/** Signalled when an archive is queued or the uploader is stopped */
+	std::condition_variable queued_;
+	/** Signalled when an archive is taken from the queue */
+	std::condition_variable dequeued_;
+	/** Set in destructor, remaining archives are uploaded without further attempts */
+	bool stop_ = false;
+	/** Thread uploading the archives, not started for synchronous uploads */
+	std::thread thread_;
+};
+
+#endif // RECODEX_WORKER_RESULT_UPLOADER_H
@@ -0,0 +1,63 @@
+#include "metrics_server.h"
+#include "helpers/metrics.h"
+
+
+metrics_server::metrics_server(const std::shared_ptr<zmq::context_t> &context,
+	const std::string &address,
+	std::shared_ptr<spdlog::logger> logger)
+	: context_(context), address_(address), logger_(logger), stop_(false)
+{
+	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
+
+	thread_ = std::thread(&metrics_server::serve, this);
+}
+
+metrics_server::~metrics_server()
+{
+	stop_ = true;
+	if (thread_.joinable()) { thread_.join(); }
+}
+
+void metrics_server::serve()
+{
+	try {
+		zmq::socket_t socket(*context_, ZMQ_STREAM);
+		socket.setsockopt(ZMQ_LINGER, 0);
+		socket.bind(address_);
+		logger_->info("Metrics are served on {}", address_);
+
+		while (!stop_) {
+			// polling with timeout, so that the destructor does not wait for next request
+			zmq::pollitem_t item = {(void *) socket, 0, ZMQ_POLLIN, 0};
+			zmq::poll(&item, 1, 500);
+			if (!(item.revents & ZMQ_POLLIN)) { continue; }
+
+			zmq::message_t identity;
+			zmq::message_t request;
+			socket.recv(&identity);
+			socket.recv(&request);
+
+			// empty message only notifies about opened or closed connection
+			if (request.size() == 0) { continue; }
+
+			std::string body = helpers::metrics().render();
+			std::string response = "HTTP/1.0 200 OK\r\n"
+								   "Content-Type: text/plain; version=0.0.4\r\n"
+								   "Content-Length: " +
+				std::to_string(body.size()) +
+				"\r\n"
+				"Connection: close\r\n"
+				"\r\n" +
+				body;
+
+			// data frame follows the identity of the connection, empty data frame closes the connection
+			socket.send(identity.data(), identity.size(), ZMQ_SNDMORE);
+			socket.send(response.data(), response.size());
+			socket.send(identity.data(), identity.size(), ZMQ_SNDMORE);
+			socket.send(response.data(), 0);
+		}
+	} catch (zmq::error_t &e) {
+		// context is terminated when the worker ends
+		if (e.num() != ETERM) { logger_->error("Metrics cannot be served on {}: {}", address_, e.what()); }
+	}
+}
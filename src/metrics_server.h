@@ -0,0 +1,56 @@
+#ifndef RECODEX_WORKER_METRICS_SERVER_H
+#define RECODEX_WORKER_METRICS_SERVER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <zmq.hpp>
+#include "helpers/logger.h"
+
+/**
+ * Serves metrics of the worker (see @ref helpers::worker_metrics) in Prometheus text format.
+ * ZeroMQ stream socket is used as a minimal HTTP server, any request is answered by current
+ * values of all metrics and the connection is closed.
+ */
+class metrics_server
+{
+public:
+	metrics_server() = delete;
+	metrics_server(const metrics_server &source) = delete;
+	metrics_server &operator=(const metrics_server &source) = delete;
+
+	/**
+	 * Constructor starts the serving thread.
+	 * @param context ZeroMQ context of the worker
+	 * @param address address to which the socket is bound, e.g. "tcp://127.0.0.1:9100"
+	 * @param logger system logger (optional)
+	 */
+	metrics_server(const std::shared_ptr<zmq::context_t> &context,
+		const std::string &address,
+		std::shared_ptr<spdlog::logger> logger = nullptr);
+
+	/**
+	 * Stop the serving thread.
+	 */
+	~metrics_server();
+
+private:
+	/**
+	 * Body of the serving thread, it ends when the server is destroyed or the context is terminated.
+	 */
+	void serve();
+
+	/** ZeroMQ context of the worker */
+	std::shared_ptr<zmq::context_t> context_;
+	/** Address of the socket */
+	std::string address_;
+	/** System or null logger */
+	std::shared_ptr<spdlog::logger> logger_;
+	/** Set in destructor */
+	std::atomic<bool> stop_;
+	/** Thread serving the requests */
+	std::thread thread_;
+};
+
+#endif // RECODEX_WORKER_METRICS_SERVER_H
@@ -0,0 +1,85 @@
+#ifndef _WIN32
+
+#include "cgroup_stats.h"
+#include <cstdlib>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+bool cgroup_stats::read_small_file(const std::string &path, std::string &content)
+{
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1) { return false; }
+
+	content.clear();
+	char buf[4096];
+	ssize_t ret;
+	while ((ret = read(fd, buf, sizeof(buf))) != 0) {
+		if (ret == -1) {
+			if (errno == EINTR) { continue; }
+			close(fd);
+			return false;
+		}
+		content.append(buf, ret);
+	}
+
+	close(fd);
+	return true;
+}
+
+bool cgroup_stats::read_box_stats(const std::string &cgroup_dir, sandbox_results &results)
+{
+	std::string content;
+	bool found = false;
+
+	if (read_small_file(cgroup_dir + "/cpu.stat", content)) {
+		found = true;
+		for_each_entry(content, ' ', [&results](const char *key, std::size_t length, const char *value, std::size_t) {
+			if (key_equals(key, length, "nr_throttled")) {
+				results.throttled = std::strtoull(value, nullptr, 10);
+			} else if (key_equals(key, length, "throttled_usec")) {
+				results.throttled_time = std::strtoull(value, nullptr, 10) / 1e6f;
+			}
+		});
+	}
+
+	if (read_small_file(cgroup_dir + "/memory.peak", content)) {
+		found = true;
+		results.memory_peak = std::strtoull(content.c_str(), nullptr, 10) / 1024;
+	}
+
+	if (read_small_file(cgroup_dir + "/memory.events", content)) {
+		found = true;
+		for_each_entry(content, ' ', [&results](const char *key, std::size_t length, const char *value, std::size_t) {
+			if (key_equals(key, length, "oom_kill")) { results.oom_kills = std::strtoull(value, nullptr, 10); }
+		});
+	}
+
+	if (read_small_file(cgroup_dir + "/io.stat", content)) {
+		found = true;
+		// one line per device "<major>:<minor> rbytes=<n> wbytes=<n> rios=<n> ...", all devices are summed
+		for_each_entry(content, ' ', [&results](const char *, std::size_t, const char *fields, std::size_t length) {
+			const char *end = fields + length;
+			const char *field = fields;
+			while (field < end) {
+				const char *field_end = static_cast<const char *>(std::memchr(field, ' ', end - field));
+				if (field_end == nullptr) { field_end = end; }
+
+				const char *eq = static_cast<const char *>(std::memchr(field, '=', field_end - field));
+				if (eq != nullptr && key_equals(field, eq - field, "rbytes")) {
+					results.io_read += std::strtoull(eq + 1, nullptr, 10);
+				} else if (eq != nullptr && key_equals(field, eq - field, "wbytes")) {
+					results.io_write += std::strtoull(eq + 1, nullptr, 10);
+				}
+
+				field = field_end + 1;
+			}
+		});
+	}
+
+	results.cgroup_stats = found;
+	return found;
+}
+
+#endif // _WIN32
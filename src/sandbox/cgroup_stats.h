@@ -0,0 +1,72 @@
+#ifndef RECODEX_WORKER_CGROUP_STATS_H
+#define RECODEX_WORKER_CGROUP_STATS_H
+
+#ifndef _WIN32
+
+#include <cstring>
+#include <string>
+#include "config/task_results.h"
+
+/**
+ * Reading of small text files with counters, which are written by isolate (meta file) and by the kernel
+ * (cgroup v2 interface files). Files are read by one system call and parsed in place, no string is
+ * allocated per line.
+ */
+namespace cgroup_stats
+{
+	/**
+	 * Read whole content of a small file.
+	 * @param path path to the file
+	 * @param content replaced by content of the file
+	 * @return @a false if the file cannot be read
+	 */
+	bool read_small_file(const std::string &path, std::string &content);
+
+	/**
+	 * Call given function for every "key<separator>value" line of the content. Lines without the
+	 * separator are skipped. Value is not terminated by zero, but it always ends by a new line or by
+	 * the end of the content, so it can be parsed by strtoul and similar functions.
+	 * @param content text with the lines
+	 * @param separator character between the key and the value
+	 * @param callback called as callback(key, key_length, value, value_length)
+	 */
+	template <typename callback_t> void for_each_entry(const std::string &content, char separator, callback_t callback)
+	{
+		const char *line = content.c_str();
+		const char *end = line + content.size();
+		while (line < end) {
+			const char *line_end = static_cast<const char *>(std::memchr(line, '\n', end - line));
+			if (line_end == nullptr) { line_end = end; }
+
+			const char *sep = static_cast<const char *>(std::memchr(line, separator, line_end - line));
+			if (sep != nullptr) { callback(line, sep - line, sep + 1, line_end - sep - 1); }
+
+			line = line_end + 1;
+		}
+	}
+
+	/**
+	 * Compare key given by pointer and length with a string literal.
+	 * @param key start of the key
+	 * @param length length of the key
+	 * @param expected zero terminated expected key
+	 * @return @a true if they are equal
+	 */
+	inline bool key_equals(const char *key, std::size_t length, const char *expected)
+	{
+		return std::strlen(expected) == length && std::memcmp(key, expected, length) == 0;
+	}
+
+	/**
+	 * Read counters of the cgroup of isolate box and store them into the results. Files cpu.stat,
+	 * memory.peak, memory.events and io.stat are read, the missing ones (e.g. memory.peak on kernels
+	 * older than 5.19 or io.stat without io controller) leave their fields zero.
+	 * @param cgroup_dir directory of the cgroup in cgroup v2 hierarchy
+	 * @param results results which fields are filled
+	 * @return @a false if no file of the cgroup can be read
+	 */
+	bool read_box_stats(const std::string &cgroup_dir, sandbox_results &results);
+} // namespace cgroup_stats
+
+#endif // _WIN32
+#endif // RECODEX_WORKER_CGROUP_STATS_H
@@ -0,0 +1,175 @@
+#ifndef _WIN32
+
+#include "isolate_box_pool.h"
+#include "isolate_sandbox.h"
+#include "helpers/logger.h"
+#include <algorithm>
+
+
+isolate_box_pool::isolate_box_pool(std::size_t first_id, std::size_t size, std::shared_ptr<spdlog::logger> logger)
+	: logger_(logger), size_(size), hits_(0), misses_(0), reuses_(0)
+{
+	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
+
+	// boxes may be left over from previous run, so all of them start as dirty
+	for (std::size_t i = 0; i < size; ++i) { dirty_.push_back(first_id + i); }
+
+	thread_ = std::thread(&isolate_box_pool::reset_boxes, this);
+}
+
+isolate_box_pool::~isolate_box_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	dirty_cond_.notify_all();
+	thread_.join();
+
+	// remaining boxes are cleaned up synchronously, boxes still in use are left as they are
+	for (auto &box : ready_) { dirty_.push_back(box.id); }
+	for (auto &item : parked_) { dirty_.push_back(item.second.id); }
+	for (auto id : dirty_) {
+		try {
+			isolate_sandbox::cleanup_box(id, logger_);
+		} catch (...) {
+			// We don't care if this failed. Box will be cleaned up on next start.
+		}
+	}
+
+	logger_->info("Isolate box pool destroyed, hits: {}, misses: {}, reuses: {}", get_hits(), get_misses(), get_reuses());
+}
+
+isolate_box isolate_box_pool::acquire(const std::string &batch)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+
+	if (!batch.empty()) {
+		auto it = std::find_if(parked_.begin(), parked_.end(), [&batch](const std::pair<std::string, isolate_box> &item) {
+			return item.first == batch;
+		});
+		if (it != parked_.end()) {
+			auto box = it->second;
+			parked_.erase(it);
+			++reuses_;
+			logger_->debug("Isolate box {} of batch {} reused", box.id, batch);
+			return box;
+		}
+	}
+
+	if (!ready_.empty()) {
+		++hits_;
+	} else {
+		++misses_;
+		logger_->debug("No initialized isolate box in the pool, waiting for one");
+	}
+
+	// at most one box parked by a batch is taken over for one acquisition, so the batches cannot exhaust the pool,
+	// but they do not lose more boxes than needed
+	bool taken_over = false;
+	while (ready_.empty() && size_ > 0) {
+		if (!taken_over && !parked_.empty() && dirty_.empty()) {
+			taken_over = true;
+			logger_->debug("Isolate box {} of batch {} taken over", parked_.front().second.id, parked_.front().first);
+			dirty_.push_back(parked_.front().second.id);
+			parked_.pop_front();
+			dirty_cond_.notify_one();
+		}
+		ready_cond_.wait(lock);
+	}
+	if (ready_.empty()) { throw sandbox_exception("No isolate box in the pool can be initialized"); }
+
+	auto box = ready_.front();
+	ready_.pop_front();
+	logger_->debug("Isolate box {} taken from the pool (hits: {}, misses: {})", box.id, get_hits(), get_misses());
+	return box;
+}
+
+void isolate_box_pool::release(const isolate_box &box)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		dirty_.push_back(box.id);
+	}
+	dirty_cond_.notify_one();
+}
+
+void isolate_box_pool::park(const isolate_box &box, const std::string &batch)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		parked_.emplace_back(batch, box);
+	}
+	// someone may wait for a box to take over
+	ready_cond_.notify_all();
+}
+
+void isolate_box_pool::release_batches()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (parked_.empty()) { return; }
+
+		for (auto &item : parked_) { dirty_.push_back(item.second.id); }
+		parked_.clear();
+	}
+	dirty_cond_.notify_one();
+}
+
+std::size_t isolate_box_pool::get_hits() const
+{
+	return hits_;
+}
+
+std::size_t isolate_box_pool::get_misses() const
+{
+	return misses_;
+}
+
+std::size_t isolate_box_pool::get_reuses() const
+{
+	return reuses_;
+}
+
+void isolate_box_pool::reset_boxes()
+{
+	while (true) {
+		std::size_t id;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			dirty_cond_.wait(lock, [this]() { return stop_ || !dirty_.empty(); });
+			if (stop_) { return; }
+
+			id = dirty_.front();
+			dirty_.pop_front();
+		}
+
+		isolate_box box;
+		box.id = id;
+		try {
+			isolate_sandbox::cleanup_box(id, logger_);
+		} catch (sandbox_exception &) {
+			// already logged, new initialization will tell whether the box is usable
+		}
+
+		try {
+			box.dir = isolate_sandbox::init_box(id, logger_);
+		} catch (sandbox_exception &) {
+			logger_->error("Isolate box {} cannot be initialized and is removed from the pool", id);
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				--size_;
+			}
+			ready_cond_.notify_all();
+			continue;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			ready_.push_back(box);
+		}
+		ready_cond_.notify_one();
+	}
+}
+
+#endif // _WIN32
@@ -0,0 +1,138 @@
+#ifndef RECODEX_WORKER_ISOLATE_BOX_POOL_H
+#define RECODEX_WORKER_ISOLATE_BOX_POOL_H
+
+#ifndef _WIN32
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include "spdlog/spdlog.h"
+
+
+/**
+ * Initialized isolate box handed out by @ref isolate_box_pool.
+ */
+struct isolate_box {
+	/** Identifier of the box (isolate's box-id) */
+	std::size_t id;
+	/** Directory inside the box which is accessible by the sandboxed program */
+	std::string dir;
+};
+
+
+/**
+ * Pool of isolate boxes which are initialized in advance and reused across tasks and jobs.
+ * Initialization of the boxes and their reset after use (cleanup followed by new initialization)
+ * is done in a background thread, so sandboxed tasks do not have to wait for isolate.
+ * Pool uses boxes with identifiers from @a first_id to @a first_id + @a size - 1, these have to be
+ * used exclusively by the pool.
+ *
+ * Boxes used by tasks of one test batch are not reset between the tasks. Such a box is parked in the pool
+ * under the name of the batch and handed out again to the next task of the same batch. Parked boxes are
+ * reset when the batches are released at the end of the job or when a box is needed and none is ready.
+ */
+class isolate_box_pool
+{
+public:
+	isolate_box_pool() = delete;
+	isolate_box_pool(const isolate_box_pool &source) = delete;
+	isolate_box_pool &operator=(const isolate_box_pool &source) = delete;
+
+	/**
+	 * Constructor starts background initialization of all boxes.
+	 * @param first_id identifier of the first box in the pool
+	 * @param size number of boxes in the pool
+	 * @param logger system logger (optional)
+	 */
+	isolate_box_pool(std::size_t first_id, std::size_t size, std::shared_ptr<spdlog::logger> logger = nullptr);
+
+	/**
+	 * Stop background thread and cleanup all boxes which are in the pool.
+	 */
+	~isolate_box_pool();
+
+	/**
+	 * Take initialized box from the pool. If there is none, wait for one.
+	 * @param batch name of the test batch, box parked under this name is preferred (optional)
+	 * @return initialized box which has to be returned by @ref release or @ref park
+	 * @throws sandbox_exception if no box in the pool can be initialized
+	 */
+	isolate_box acquire(const std::string &batch = "");
+
+	/**
+	 * Give box back to the pool, box will be reset in background.
+	 * @param box previously acquired box
+	 */
+	void release(const isolate_box &box);
+
+	/**
+	 * Give box back to the pool without reset, it is reused by the next task of the same batch.
+	 * @param box previously acquired box
+	 * @param batch name of the test batch
+	 */
+	void park(const isolate_box &box, const std::string &batch);
+
+	/**
+	 * Reset all parked boxes in background, batches using them are finished.
+	 */
+	void release_batches();
+
+	/**
+	 * Get number of acquisitions which got already initialized box.
+	 * @return number of pool hits
+	 */
+	std::size_t get_hits() const;
+
+	/**
+	 * Get number of acquisitions which had to wait for box initialization.
+	 * @return number of pool misses
+	 */
+	std::size_t get_misses() const;
+
+	/**
+	 * Get number of acquisitions which got parked box of their batch.
+	 * @return number of reused boxes
+	 */
+	std::size_t get_reuses() const;
+
+private:
+	/**
+	 * Body of background thread, resets released boxes until the pool is destroyed.
+	 */
+	void reset_boxes();
+
+	/** System logger */
+	std::shared_ptr<spdlog::logger> logger_;
+	/** Number of boxes which can be handed out, broken boxes are not counted */
+	std::size_t size_;
+	/** Initialized boxes ready to be acquired */
+	std::deque<isolate_box> ready_;
+	/** Identifiers of boxes waiting for reset */
+	std::deque<std::size_t> dirty_;
+	/** Boxes used by test batches which are not reset yet, with names of the batches */
+	std::deque<std::pair<std::string, isolate_box>> parked_;
+	/** Guards both queues, size and stop flag */
+	std::mutex mutex_;
+	/** Signalled when some box needs reset or the pool is stopped */
+	std::condition_variable dirty_cond_;
+	/** Signalled when some box is ready, parked or was removed from the pool */
+	std::condition_variable ready_cond_;
+	/** Set in destructor to stop background thread */
+	bool stop_ = false;
+	/** Number of pool hits */
+	std::atomic<std::size_t> hits_;
+	/** Number of pool misses */
+	std::atomic<std::size_t> misses_;
+	/** Number of reused boxes */
+	std::atomic<std::size_t> reuses_;
+	/** Background thread */
+	std::thread thread_;
+};
+
+#endif // _WIN32
+#endif // RECODEX_WORKER_ISOLATE_BOX_POOL_H
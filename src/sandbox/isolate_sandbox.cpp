@@ -12,14 +12,24 @@
 #include <string>
 #include <iostream>
 #include <fstream>
-#include <map>
+#include <sstream>
+#include <cstdlib>
+#include <set>
+#include <mutex>
+#include <system_error>
 #define BOOST_FILESYSTEM_NO_DEPRECATED
 #define BOOST_NO_CXX11_SCOPED_ENUMS
 #include <boost/filesystem.hpp>
 #include "helpers/filesystem.h"
+#include "helpers/timings.h"
+#include "helpers/metrics.h"
+#include "helpers/process.h"
+#include "cgroup_stats.h"
 
 namespace fs = boost::filesystem;
 
+const char *const isolate_sandbox::isolate_binary = "isolate";
+
 namespace
 {
 	void move_or_throw(std::shared_ptr<spdlog::logger> logger, const std::string &from, const std::string &to)
@@ -35,6 +45,118 @@ namespace
 		} catch (fs::filesystem_error &) {
 		}
 	}
+
+	/**
+	 * Get user identifier under which the program in the box with given identifier runs. Isolate derives it from
+	 * the first_uid of its configuration file, the default of isolate is used when the file cannot be read.
+	 */
+	unsigned int isolate_box_uid(std::size_t id)
+	{
+		static const unsigned int first_uid = []() {
+			const char *env = std::getenv("ISOLATE_CONFIG_FILE");
+			for (const char *path : {env, "/usr/local/etc/isolate", "/etc/isolate"}) {
+				if (path == nullptr) { continue; }
+				std::ifstream config(path);
+				std::string line;
+				while (std::getline(config, line)) {
+					std::istringstream tokens(line);
+					std::string key, equals;
+					unsigned int value;
+					if (tokens >> key >> equals >> value && key == "first_uid" && equals == "=") { return value; }
+				}
+			}
+			return 60000u;
+		}();
+		return first_uid + id;
+	}
+
+	/**
+	 * ACLs are read and written as a whole, concurrent boxes bound to the same directory must not interleave.
+	 */
+	std::mutex grant_access_mutex;
+
+	/**
+	 * Copy declared output files written into upper layer of an overlay to the lower directory, other files written
+	 * by the program are discarded with the layer, so they do not leak into the following tasks. The discarded files
+	 * are logged as a warning, so that a later task missing them can be explained.
+	 */
+	void copy_outputs(const std::vector<std::string> &files,
+		const std::string &chdir,
+		const fs::path &upper_dir,
+		const fs::path &data_dir,
+		std::shared_ptr<spdlog::logger> logger)
+	{
+		// only the files inside the box are in the upper layer, bound directories are written directly
+		std::vector<std::tuple<std::string, std::string, sandbox_limits::dir_perm>> no_bound_dirs;
+		std::set<fs::path> kept;
+		for (auto &file : files) {
+			if (file.empty()) { continue; }
+
+			auto upper_path = helpers::find_path_outside_sandbox(file, chdir, no_bound_dirs, upper_dir.string());
+			if (upper_path.empty() || !fs::is_regular_file(fs::symlink_status(upper_path))) { continue; }
+			boost::system::error_code ec;
+			kept.insert(fs::canonical(upper_path, ec));
+
+			auto relative = upper_path.string().substr(upper_dir.string().length());
+			auto data_path = fs::path(data_dir.string() + relative);
+			try {
+				fs::create_directories(data_path.parent_path());
+				helpers::copy_file(upper_path, data_path);
+			} catch (fs::filesystem_error &e) {
+				logger->warn("Output file {} written in the sandbox cannot be kept: {}", file, e.what());
+			} catch (helpers::filesystem_exception &e) {
+				logger->warn("Output file {} written in the sandbox cannot be kept: {}", file, e.what());
+			}
+		}
+
+		// later tasks would miss the discarded files without any hint, so they are reported
+		boost::system::error_code ec;
+		std::string discarded;
+		fs::recursive_directory_iterator endit;
+		for (fs::recursive_directory_iterator it(upper_dir, ec); !ec && it != endit; it.increment(ec)) {
+			boost::system::error_code entry_ec;
+			if (!fs::is_regular_file(it->symlink_status(entry_ec)) ||
+				kept.count(fs::canonical(it->path(), entry_ec)) > 0) {
+				continue;
+			}
+			discarded += (discarded.empty() ? "" : ", ") + it->path().string().substr(upper_dir.string().length());
+		}
+		if (!discarded.empty()) {
+			logger->warn("Files written in the sandbox are discarded, they are not listed in output-files "
+						 "of the task: {}",
+				discarded);
+		}
+	}
+
+	/**
+	 * Remove all contents of a directory, the directory itself is kept.
+	 * @return true if everything was removed (or the directory does not exist), false otherwise
+	 */
+	bool empty_directory(const fs::path &dir)
+	{
+		boost::system::error_code ec;
+		if (!fs::exists(fs::symlink_status(dir, ec))) { return true; }
+
+		fs::directory_iterator endit;
+		fs::directory_iterator it(dir, ec);
+		for (; !ec && it != endit; it.increment(ec)) {
+			boost::system::error_code remove_ec;
+			fs::remove_all(it->path(), remove_ec);
+			if (remove_ec) { return false; }
+		}
+		return !ec && fs::is_empty(dir, ec) && !ec;
+	}
+
+	/** Escape characters which separate mount options and overlay layers in a path. */
+	std::string escape_overlay_path(const std::string &path)
+	{
+		std::string escaped;
+		for (char c : path) {
+			if (c == '\\' || c == ',' || c == ':') { escaped += '\\'; }
+			escaped += c;
+		}
+		return escaped;
+	}
 } // namespace
 
 isolate_sandbox::isolate_sandbox(std::shared_ptr<sandbox_config> sandbox_config,
@@ -42,9 +164,14 @@ isolate_sandbox::isolate_sandbox(std::shared_ptr<sandbox_config> sandbox_config,
 	std::size_t id,
 	const std::string &temp_dir,
 	const std::string &data_dir,
-	std::shared_ptr<spdlog::logger> logger)
-	: sandbox_config_(sandbox_config), limits_(limits), logger_(logger), id_(id), isolate_binary_("isolate"),
-	  data_dir_(data_dir)
+	std::shared_ptr<spdlog::logger> logger,
+	std::shared_ptr<isolate_box_pool> box_pool,
+	sandbox_data_mode data_mode,
+	const std::string &cgroup_root,
+	const std::string &batch)
+	: sandbox_config_(sandbox_config), limits_(limits), logger_(logger), id_(id), isolate_binary_(isolate_binary),
+	  data_dir_(data_dir), box_pool_(box_pool), data_mode_(data_mode), transfer_mode_(data_mode),
+	  cgroup_root_(cgroup_root), batch_(batch)
 {
 	if (logger_ == nullptr) { logger_ = helpers::create_null_logger(); }
 
@@ -52,6 +179,18 @@ isolate_sandbox::isolate_sandbox(std::shared_ptr<sandbox_config> sandbox_config,
 
 	if (data_dir_ == "") { logger_->info("Empty data directory for moving to sandbox."); }
 
+	auto started = std::chrono::steady_clock::now();
+
+	// box from the pool is already initialized and its identifier is given by the pool
+	if (box_pool_ != nullptr) {
+		auto box = box_pool_->acquire(batch_);
+		id_ = box.id;
+		sandboxed_dir_ = box.dir;
+	} else if (!batch_.empty()) {
+		logger_->debug("Box of test batch {} is not reused, there is no box pool", batch_);
+		batch_ = "";
+	}
+
 	// Set backup limit (for killing isolate if it hasn't finished yet)
 	max_timeout_ = limits_.wall_time > limits_.cpu_time ? limits_.wall_time : limits_.cpu_time;
 	max_timeout_ += 300; // plus 5 minutes (for short tasks)
@@ -61,246 +200,341 @@ isolate_sandbox::isolate_sandbox(std::shared_ptr<sandbox_config> sandbox_config,
 	try {
 		fs::create_directories(temp_dir_);
 	} catch (fs::filesystem_error &e) {
+		if (box_pool_ != nullptr) { box_pool_->release({id_, sandboxed_dir_}); }
 		log_and_throw(logger_, "Failed to create directory for isolate meta file. Error: ", e.what());
 	}
 
 	meta_file_ = (fs::path(temp_dir_) / "meta.log").string();
+	overlay_dir_ = (fs::path(temp_dir_) / "overlay").string();
 
 	try {
-		isolate_init();
+		if (box_pool_ == nullptr) { sandboxed_dir_ = init_box(id_, logger_); }
 	} catch (...) {
 		fs::remove_all(temp_dir_);
 		throw;
 	}
+
+	std::chrono::duration<double> duration = std::chrono::steady_clock::now() - started;
+	helpers::metrics().sandbox_init.observe(duration.count());
 }
 
 isolate_sandbox::~isolate_sandbox()
 {
+	auto started = std::chrono::steady_clock::now();
 	try {
-		isolate_cleanup();
-		fs::remove_all(temp_dir_);
+		if (box_pool_ != nullptr && !batch_.empty()) {
+			// next task of the batch gets the box without reset, only files left by this run (in the box and
+			// its /tmp) are removed, the box is reset if any of them cannot be removed
+			auto root = fs::path(sandboxed_dir_).parent_path();
+			if (empty_directory(sandboxed_dir_) && empty_directory(root / "tmp")) {
+				box_pool_->park({id_, sandboxed_dir_}, batch_);
+			} else {
+				logger_->warn("Box {} cannot be cleaned for the next task of its test batch, it is reset", id_);
+				box_pool_->release({id_, sandboxed_dir_});
+			}
+		} else if (box_pool_ != nullptr) {
+			// pool resets the box in background
+			box_pool_->release({id_, sandboxed_dir_});
+		} else {
+			cleanup_box(id_, logger_);
+		}
+		if (overlay_mounted_) {
+			logger_->warn("Overlay in {} is still mounted, the directory is not removed", overlay_dir_);
+		} else {
+			fs::remove_all(temp_dir_);
+		}
 	} catch (...) {
 		// We don't care if this failed. We can't fix it either. Just don't throw an exception in destructor.
 	}
+
+	std::chrono::duration<double> duration = std::chrono::steady_clock::now() - started;
+	helpers::metrics().sandbox_cleanup.observe(duration.count());
 }
 
 sandbox_results isolate_sandbox::run(const std::string &binary, const std::vector<std::string> &arguments)
 {
+	helpers::phase_timings timings;
+
 	// move data to isolate directory
-	if (data_dir_ != "") { move_or_throw(logger_, data_dir_, sandboxed_dir_); }
+	if (data_dir_ != "") {
+		helpers::phase_timer timer(timings, "copy-in");
+		move_data_in();
+	}
 
 	try {
 		// run isolate
-		isolate_run(binary, arguments);
+		{
+			helpers::phase_timer timer(timings, "run");
+			isolate_run(binary, arguments);
+		}
 
 		// move data from isolate directory back to data directory
-		if (data_dir_ != "") { move_or_throw(logger_, sandboxed_dir_, data_dir_); }
+		if (data_dir_ != "") {
+			helpers::phase_timer timer(timings, "copy-out");
+			move_data_out();
+		}
 	} catch (const std::exception &) {
 		// on errors also move data from isolate directory back to data directory
-		if (data_dir_ != "") { move_or_throw(logger_, sandboxed_dir_, data_dir_); }
+		if (data_dir_ != "") { move_data_out(); }
 
 		// rethrow the original exception when data are saved
 		throw;
 	}
 
-	return process_meta_file();
+	auto results = process_meta_file();
+	results.timings = std::move(timings);
+	return results;
 }
 
-void isolate_sandbox::isolate_init()
+void isolate_sandbox::move_data_in()
 {
-	int fd[2];
-	pid_t childpid;
+	transfer_mode_ = data_mode_;
 
-	logger_->debug("Initializing isolate...");
+	if (transfer_mode_ == sandbox_data_mode::OVERLAY) {
+		mount_overlay();
+		log_avoided_copy(data_dir_);
+		return;
+	}
 
-	// Create unnamend pipe
-	if (pipe(fd) == -1) { log_and_throw(logger_, "Cannot create pipe: ", strerror(errno)); }
+	if (transfer_mode_ == sandbox_data_mode::BIND) {
+		if (limits_.disk_size != 0 || limits_.disk_files != 0) {
+			logger_->warn("Disk quota of box {} is not applied, {} is bound into the box", id_, data_dir_);
+		}
 
-	childpid = fork();
+		// directory is bound as the box, so the whole tree has to be writable by the box user as the box is,
+		// access is granted only to this user, the mode of the files stays untouched
+		try {
+			std::lock_guard<std::mutex> lock(grant_access_mutex);
+			auto denied = helpers::grant_user_access(data_dir_, isolate_box_uid(id_));
+			if (denied > 0) {
+				logger_->warn("Box user of box {} cannot write {} items of {} created by other box users",
+					id_,
+					denied,
+					data_dir_);
+			}
+		} catch (helpers::filesystem_exception &e) {
+			log_and_throw(logger_, "Failed to grant box user access to ", data_dir_, ", error: ", e.what());
+		}
+		log_avoided_copy(data_dir_);
+		return;
+	}
 
-	switch (childpid) {
-	case -1: log_and_throw(logger_, "Fork failed: ", strerror(errno)); break;
-	case 0: isolate_init_child(fd[0], fd[1]); break;
-	default:
-		//---Parent---
-		// Close up input side of pipe
-		close(fd[1]);
+	if (transfer_mode_ == sandbox_data_mode::RENAME) {
+		bool renamed = false;
+		try {
+			renamed = helpers::rename_directory_content(data_dir_, sandboxed_dir_);
+		} catch (helpers::filesystem_exception &e) {
+			log_and_throw(logger_, "Failed renaming ", data_dir_, " to ", sandboxed_dir_, ", error: ", e.what());
+		}
 
-		char buf[256];
-		int ret;
-		while ((ret = read(fd[0], (void *) buf, 256)) > 0) {
-			if (buf[ret - 1] == '\n') { buf[ret - 1] = '\0'; }
-			sandboxed_dir_ += std::string(buf);
+		if (renamed) {
+			log_avoided_copy(sandboxed_dir_);
+			return;
 		}
-		sandboxed_dir_ += "/box";
-		if (ret == -1) { log_and_throw(logger_, "Read from pipe error."); }
 
-		int status;
-		waitpid(childpid, &status, 0);
-		if (WEXITSTATUS(status) != 0) {
-			log_and_throw(logger_, "Isolate init error. Return value: ", WEXITSTATUS(status));
+		logger_->info("Directory {} is not on the same filesystem as the sandbox, data will be copied", data_dir_);
+		transfer_mode_ = sandbox_data_mode::COPY;
+	}
+
+	move_or_throw(logger_, data_dir_, sandboxed_dir_);
+}
+
+void isolate_sandbox::move_data_out()
+{
+	if (transfer_mode_ == sandbox_data_mode::OVERLAY) {
+		unmount_overlay();
+		return;
+	}
+
+	if (transfer_mode_ == sandbox_data_mode::BIND) { return; }
+
+	if (transfer_mode_ == sandbox_data_mode::RENAME) {
+		try {
+			// data came from the same filesystem, so they can be renamed back
+			if (helpers::rename_directory_content(sandboxed_dir_, data_dir_)) { return; }
+		} catch (helpers::filesystem_exception &e) {
+			log_and_throw(logger_, "Failed renaming ", sandboxed_dir_, " to ", data_dir_, ", error: ", e.what());
 		}
-		logger_->debug("Isolate initialized in {}", sandboxed_dir_);
-		close(fd[0]);
-		break;
 	}
+
+	move_or_throw(logger_, sandboxed_dir_, data_dir_);
+}
+
+void isolate_sandbox::log_avoided_copy(const std::string &dir)
+{
+	const char *how = "renamed";
+	if (transfer_mode_ == sandbox_data_mode::BIND) { how = "bound"; }
+	if (transfer_mode_ == sandbox_data_mode::OVERLAY) { how = "overlaid"; }
+
+	// size of the data takes a walk through the whole tree, so it is found out only when it is logged
+	if (!logger_->should_log(spdlog::level::debug)) { return; }
+	logger_->debug(
+		"Data of the sandbox were {} instead of copying, {} bytes were not copied", how, helpers::directory_size(dir));
 }
 
-void isolate_sandbox::isolate_init_child(int fd_0, int fd_1)
+void isolate_sandbox::mount_overlay()
 {
-	// Close up output side of pipe
-	close(fd_0);
+	auto upper_dir = fs::path(overlay_dir_) / "upper";
+	auto work_dir = fs::path(overlay_dir_) / "work";
+	auto merged_dir = fs::path(overlay_dir_) / "merged";
 
-	// Close stdout, duplicate the input side of pipe to stdout
-	dup2(fd_1, 1);
+	try {
+		fs::create_directories(upper_dir);
+		fs::create_directories(work_dir);
+		fs::create_directories(merged_dir);
+		// root of the overlay takes attributes of the upper layer, it has to be writable by the sandbox users
+		fs::permissions(upper_dir, fs::add_perms | fs::others_all);
+	} catch (fs::filesystem_error &e) {
+		log_and_throw(logger_, "Failed to create directories of overlay in ", overlay_dir_, ", error: ", e.what());
+	}
 
-	// Redirect stderr to /dev/null file
-	int devnull;
-	devnull = open("/dev/null", O_WRONLY);
-	if (devnull == -1) { log_and_throw(logger_, "Cannot open /dev/null file for writing."); }
-	dup2(devnull, 2);
+	std::string options = "lowerdir=" + escape_overlay_path(data_dir_) +
+		",upperdir=" + escape_overlay_path(upper_dir.string()) + ",workdir=" + escape_overlay_path(work_dir.string());
+	if (mount("overlay", merged_dir.c_str(), "overlay", 0, options.c_str()) == -1) {
+		int mount_error = errno;
+		boost::system::error_code ec;
+		fs::remove_all(overlay_dir_, ec);
+		log_and_throw(logger_, "Mounting overlay of ", data_dir_, " failed: ", strerror(mount_error));
+	}
+	overlay_mounted_ = true;
+}
 
-	// Exec isolate init command
-	const char *args[5];
+void isolate_sandbox::unmount_overlay()
+{
+	auto merged_dir = fs::path(overlay_dir_) / "merged";
 
-	args[0] = isolate_binary_.c_str();
-	args[1] = "--cg";
-	args[2] = ("--box-id=" + std::to_string(id_)).c_str();
-	args[3] = "--init";
-	args[4] = NULL;
+	// upper layer of overlay which is still mounted cannot be trusted and removing it would descend into the mount
+	if (umount2(merged_dir.c_str(), MNT_DETACH) == -1) {
+		log_and_throw(logger_, "Unmounting overlay ", merged_dir.string(), " failed: ", strerror(errno));
+	}
+	overlay_mounted_ = false;
 
-	// const_cast is ugly, but this is working with C code - execv does not modify its arguments
-	execvp(isolate_binary_.c_str(), const_cast<char **>(args));
+	// job runs only other overlaid programs at the same time, changes of the lower layer of their overlays do not
+	// break them, they only might not see the new files
+	std::vector<std::string> outputs = {sandbox_config_->std_output, sandbox_config_->std_error};
+	outputs.insert(outputs.end(), sandbox_config_->output_files.begin(), sandbox_config_->output_files.end());
+	copy_outputs(outputs, sandbox_config_->chdir, fs::path(overlay_dir_) / "upper", data_dir_, logger_);
 
-	// Never reached
-	log_and_throw(logger_, "Exec returned to child: ", strerror(errno));
+	boost::system::error_code ec;
+	fs::remove_all(overlay_dir_, ec);
 }
 
-void isolate_sandbox::isolate_cleanup()
+void isolate_sandbox::check_overlay(const std::string &dir)
 {
-	pid_t childpid;
-
-	logger_->debug("Cleaning up isolate...");
-
-	childpid = fork();
-
-	switch (childpid) {
-	case -1: log_and_throw(logger_, "Fork failed: ", strerror(errno)); break;
-	case 0:
-		//---Child---
-		// Redirect stderr to /dev/null file
-		int devnull;
-		devnull = open("/dev/null", O_WRONLY);
-		if (devnull == -1) { log_and_throw(logger_, "Cannot open /dev/null file for writing."); }
-		dup2(devnull, 2);
-
-		// Exec isolate cleanup command
-		const char *args[5];
-		args[0] = isolate_binary_.c_str();
-		args[1] = "--cg";
-		args[2] = ("--box-id=" + std::to_string(id_)).c_str();
-		args[3] = "--cleanup";
-		args[4] = NULL;
-		// const_cast is ugly, but this is working with C code - execv does not modify its arguments
-		execvp(isolate_binary_.c_str(), const_cast<char **>(args));
-
-		// Never reached
-		log_and_throw(logger_, "Exec returned to child: ", strerror(errno));
-		break;
-	default:
-		//---Parent---
-		int status;
-		waitpid(childpid, &status, 0);
-		if (WEXITSTATUS(status) != 0) {
-			log_and_throw(logger_, "Isolate cleanup error. Return value: ", WEXITSTATUS(status));
+	auto check_dir = fs::path(dir) / "overlay-check";
+	auto merged_dir = check_dir / "merged";
+	std::string options = "lowerdir=" + escape_overlay_path((check_dir / "lower").string()) +
+		",upperdir=" + escape_overlay_path((check_dir / "upper").string()) +
+		",workdir=" + escape_overlay_path((check_dir / "work").string());
+
+	std::string error;
+	try {
+		for (auto name : {"lower", "upper", "work", "merged"}) { fs::create_directories(check_dir / name); }
+		if (mount("overlay", merged_dir.c_str(), "overlay", 0, options.c_str()) == -1) {
+			error = std::string("mount failed: ") + strerror(errno);
+		} else if (umount2(merged_dir.c_str(), MNT_DETACH) == -1) {
+			// directory is left as it is, removing it would descend into the mount
+			throw sandbox_exception("Unmounting overlay " + merged_dir.string() + " failed: " + strerror(errno));
 		}
-		logger_->debug("Isolate box {} cleaned up.", id_);
-		break;
+	} catch (fs::filesystem_error &e) {
+		error = e.what();
 	}
+
+	boost::system::error_code ec;
+	fs::remove_all(check_dir, ec);
+	if (!error.empty()) { throw sandbox_exception("Overlay cannot be mounted in " + dir + ", " + error); }
 }
 
-void isolate_sandbox::isolate_run(const std::string &binary, const std::vector<std::string> &arguments)
+std::string isolate_sandbox::init_box(std::size_t id, std::shared_ptr<spdlog::logger> logger)
 {
-	pid_t childpid;
+	int fd[2];
+	std::string box_dir;
+
+	logger->debug("Initializing isolate box {}...", id);
+
+	// Create unnamed pipe, its ends are not inherited, only the duplicated stdout of isolate is
+	if (pipe2(fd, O_CLOEXEC) == -1) { log_and_throw(logger, "Cannot create pipe: ", strerror(errno)); }
+
+	std::vector<std::string> args = {isolate_binary, "--cg", "--box-id=" + std::to_string(id), "--init"};
+	pid_t childpid = helpers::spawn_process(args, fd[1]);
+	int spawn_error = errno;
+	// Close up input side of pipe, isolate has its own copy
+	close(fd[1]);
+
+	if (childpid == -1) {
+		close(fd[0]);
+		log_and_throw(logger, "Spawn of isolate failed: ", strerror(spawn_error));
+	}
+
+	char buf[256];
+	ssize_t ret;
+	while ((ret = read(fd[0], (void *) buf, 256)) > 0 || (ret == -1 && errno == EINTR)) {
+		if (ret == -1) { continue; }
+		if (buf[ret - 1] == '\n') { buf[ret - 1] = '\0'; }
+		box_dir += std::string(buf, strnlen(buf, ret));
+	}
+	close(fd[0]);
+	box_dir += "/box";
+
+	int status;
+	waitpid(childpid, &status, 0);
+	if (ret == -1) { log_and_throw(logger, "Read from pipe error."); }
+	if (WEXITSTATUS(status) != 0) {
+		log_and_throw(logger, "Isolate init error. Return value: ", WEXITSTATUS(status));
+	}
+	logger->debug("Isolate initialized in {}", box_dir);
+
+	return box_dir;
+}
 
+void isolate_sandbox::cleanup_box(std::size_t id, std::shared_ptr<spdlog::logger> logger)
+{
+	logger->debug("Cleaning up isolate box {}...", id);
+
+	std::vector<std::string> args = {isolate_binary, "--cg", "--box-id=" + std::to_string(id), "--cleanup"};
+	pid_t childpid = helpers::spawn_process(args);
+	if (childpid == -1) { log_and_throw(logger, "Spawn of isolate failed: ", strerror(errno)); }
+
+	int status;
+	waitpid(childpid, &status, 0);
+	if (WEXITSTATUS(status) != 0) {
+		log_and_throw(logger, "Isolate cleanup error. Return value: ", WEXITSTATUS(status));
+	}
+	logger->debug("Isolate box {} cleaned up.", id);
+}
+
+void isolate_sandbox::isolate_run(const std::string &binary, const std::vector<std::string> &arguments)
+{
 	logger_->debug("Running isolate...");
-	logger_->debug("Running the first fork");
-
-	childpid = fork();
-
-	switch (childpid) {
-	case -1: log_and_throw(logger_, "Fork failed: ", strerror(errno)); break;
-	case 0: {
-		//---Child---
-		logger_->debug("Returned from the first fork as child");
-
-		// Redirect stderr and stdout to /dev/null file
-		int devnull;
-		devnull = open("/dev/null", O_WRONLY);
-		if (devnull == -1) { log_and_throw(logger_, "Cannot open /dev/null file for writing."); }
-		dup2(devnull, 0); // Don't allow process inside isolate to read from current standard input
-		dup2(devnull, 1);
-		dup2(devnull, 2);
-
-		auto args = isolate_run_args(binary, arguments);
-		execvp(isolate_binary_.c_str(), args);
-
-		// Never reached
-		log_and_throw(logger_, "Exec returned to child: ", strerror(errno));
-	} break;
-	default: {
-		//---Parent---
-		/* Spawn a control process, that will wait given timeout and then kills isolate process.
-		 * When a isolate process finishes before the timeout, parent thread kills control process
-		 * and calls waitpid() to remove zombie from system.
-		 */
-
-		logger_->debug("Returned from the first fork as parent");
-
-		pid_t controlpid;
-		logger_->debug("Running the second fork");
-		controlpid = fork();
-		switch (controlpid) {
-		case -1: log_and_throw(logger_, "Fork failed: ", strerror(errno)); break;
-		case 0:
-			// Child---
-			{
-				logger_->debug("Returned from the second fork as child (control process)");
-
-				int remaining = max_timeout_;
-				// Sleep can be interrupted by signal, so make sure to sleep whole time
-				while (remaining > 0) { remaining = sleep(remaining); }
-				kill(childpid, SIGKILL);
-			}
-			break;
-		default:
-			// Parent---
-			logger_->debug("Returned from the second fork as parent");
-
-			int status;
-			// Wait for isolate process. Waitpid returns no much longer than timeout if not earlier.
-			waitpid(childpid, &status, 0);
-			// Kill control process. If it already exits, nothing will be done
-			kill(controlpid, SIGKILL);
-			// Remove zombie from controll process.
-			waitpid(controlpid, NULL, 0);
-
-			// isolate was killed
-			if (WIFSIGNALED(status)) {
-				log_and_throw(logger_, "Isolate process was killed by signal ", WTERMSIG(status), " due to timeout.");
-			}
-			// isolate exited, but with return value signify internal error
-			if (WEXITSTATUS(status) != 0 && WEXITSTATUS(status) != 1) {
-				log_and_throw(logger_, "Isolate run into internal error. Return value: ", WEXITSTATUS(status));
-			}
-			logger_->debug("Isolate box {} ran successfully.", id_);
-			break;
-		}
-	} break;
+
+	// Standard streams of isolate are redirected to /dev/null, the sandboxed program cannot read
+	// from standard input of the worker
+	pid_t childpid = helpers::spawn_process(isolate_run_args(binary, arguments));
+	if (childpid == -1) { log_and_throw(logger_, "Spawn of isolate failed: ", strerror(errno)); }
+
+	/* Wait for isolate process at most given timeout, then it is killed. The process is
+	 * supervised directly by this thread, no control process is spawned.
+	 */
+	int status;
+	bool ended = false;
+	try {
+		ended = helpers::wait_for_child(childpid, std::chrono::seconds(max_timeout_), status);
+	} catch (std::system_error &e) {
+		log_and_throw(logger_, "Waiting for isolate process failed: ", e.what());
+	}
+	if (!ended) { log_and_throw(logger_, "Isolate process was killed due to timeout of ", max_timeout_, " seconds."); }
+
+	// isolate was killed by someone else
+	if (WIFSIGNALED(status)) { log_and_throw(logger_, "Isolate process was killed by signal ", WTERMSIG(status)); }
+	// isolate exited, but with return value signify internal error
+	if (WEXITSTATUS(status) != 0 && WEXITSTATUS(status) != 1) {
+		log_and_throw(logger_, "Isolate run into internal error. Return value: ", WEXITSTATUS(status));
 	}
+	logger_->debug("Isolate box {} ran successfully.", id_);
 }
 
-char **isolate_sandbox::isolate_run_args(const std::string &binary, const std::vector<std::string> &arguments)
+std::vector<std::string> isolate_sandbox::isolate_run_args(
+	const std::string &binary, const std::vector<std::string> &arguments)
 {
 	std::vector<std::string> vargs;
 
@@ -348,6 +582,14 @@ char **isolate_sandbox::isolate_run_args(const std::string &binary, const std::v
 		std::string dirVal = (src == dst) ? src : (dst + "=" + src);
 		vargs.push_back(std::string("--dir=") + dirVal + mode);
 	}
+	// Data directory is used directly as the box
+	if (transfer_mode_ == sandbox_data_mode::BIND && !data_dir_.empty()) {
+		vargs.push_back("--dir=box=" + data_dir_ + ":rw");
+	}
+	// Overlay over data directory is used as the box
+	if (transfer_mode_ == sandbox_data_mode::OVERLAY) {
+		vargs.push_back("--dir=box=" + (fs::path(overlay_dir_) / "merged").string() + ":rw");
+	}
 	// Bind /etc/alternatives directory if exists
 	vargs.push_back("--dir=etc/alternatives=/etc/alternatives:maybe");
 
@@ -358,67 +600,64 @@ char **isolate_sandbox::isolate_run_args(const std::string &binary, const std::v
 	vargs.push_back(binary);
 	for (auto &i : arguments) { vargs.push_back(i); }
 
-	// Convert string to char ** for execv call
-	char **c_args = new char *[vargs.size() + 1];
-	int i = 0;
-	for (auto &it : vargs) {
-		c_args[i++] = strdup(it.c_str());
-		logger_->debug("  {}", it);
-	}
-	c_args[i] = NULL;
-	return c_args;
+	for (auto &it : vargs) { logger_->debug("  {}", it); }
+	return vargs;
 }
 
 sandbox_results isolate_sandbox::process_meta_file()
 {
 	sandbox_results results;
 
-	std::ifstream meta_stream;
-	meta_stream.open(meta_file_);
-	if (meta_stream.is_open()) {
-		std::string line;
-		while (std::getline(meta_stream, line)) {
-			std::size_t pos = line.find(':');
-			std::size_t value_size = line.size() - (pos + 1);
-			auto first = line.substr(0, pos);
-			auto second = line.substr(pos + 1, value_size);
-			if (first == "time") {
-				results.time = std::stof(second);
-			} else if (first == "time-wall") {
-				results.wall_time = std::stof(second);
-			} else if (first == "killed") {
+	std::string content;
+	if (!cgroup_stats::read_small_file(meta_file_, content)) {
+		log_and_throw(logger_, "Cannot open ", meta_file_, " for reading.");
+	}
+
+	using cgroup_stats::key_equals;
+	cgroup_stats::for_each_entry(
+		content, ':', [&results](const char *key, std::size_t length, const char *value, std::size_t value_length) {
+			if (key_equals(key, length, "time")) {
+				results.time = std::strtof(value, nullptr);
+			} else if (key_equals(key, length, "time-wall")) {
+				results.wall_time = std::strtof(value, nullptr);
+			} else if (key_equals(key, length, "killed")) {
 				results.killed = true;
-			} else if (first == "status") {
-				if (second == "RE") {
+			} else if (key_equals(key, length, "status")) {
+				if (key_equals(value, value_length, "RE")) {
 					results.status = isolate_status::RE;
-				} else if (second == "SG") {
+				} else if (key_equals(value, value_length, "SG")) {
 					results.status = isolate_status::SG;
-				} else if (second == "TO") {
+				} else if (key_equals(value, value_length, "TO")) {
 					results.status = isolate_status::TO;
-				} else if (second == "XX") {
+				} else if (key_equals(value, value_length, "XX")) {
 					results.status = isolate_status::XX;
 				}
-			} else if (first == "message") {
-				results.message = second;
-			} else if (first == "exitsig") {
-				results.exitsig = std::stoi(second);
-			} else if (first == "exitcode") {
-				results.exitcode = std::stoi(second);
-			} else if (first == "cg-mem") {
-				results.memory = std::stoul(second);
-			} else if (first == "max-rss") {
-				results.max_rss = std::stoul(second);
-			} else if (first == "csw-voluntary") {
-				results.csw_voluntary = std::stoul(second);
-			} else if (first == "csw-forced") {
-				results.csw_forced = std::stoul(second);
+			} else if (key_equals(key, length, "message")) {
+				results.message.assign(value, value_length);
+			} else if (key_equals(key, length, "exitsig")) {
+				results.exitsig = std::strtol(value, nullptr, 10);
+			} else if (key_equals(key, length, "exitcode")) {
+				results.exitcode = std::strtol(value, nullptr, 10);
+			} else if (key_equals(key, length, "cg-mem")) {
+				results.memory = std::strtoul(value, nullptr, 10);
+			} else if (key_equals(key, length, "max-rss")) {
+				results.max_rss = std::strtoul(value, nullptr, 10);
+			} else if (key_equals(key, length, "csw-voluntary")) {
+				results.csw_voluntary = std::strtoul(value, nullptr, 10);
+			} else if (key_equals(key, length, "csw-forced")) {
+				results.csw_forced = std::strtoul(value, nullptr, 10);
 			}
+		});
+
+	// counters which isolate does not write are read from the cgroup of the box directly
+	if (!cgroup_root_.empty()) {
+		auto cgroup_dir = cgroup_root_ + "/box-" + std::to_string(id_);
+		if (!cgroup_stats::read_box_stats(cgroup_dir, results)) {
+			logger_->warn("Counters of cgroup {} cannot be read", cgroup_dir);
 		}
-		return results;
-	} else {
-		log_and_throw(logger_, "Cannot open ", meta_file_, " for reading.");
-		return results; // never reached
 	}
+
+	return results;
 }
 
 #endif
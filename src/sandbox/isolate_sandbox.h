@@ -8,6 +8,7 @@
 #include "helpers/logger.h"
 #include "sandbox_base.h"
 #include "config/sandbox_config.h"
+#include "isolate_box_pool.h"
 
 /**
  * Class implementing operations with Isolate sandbox.
@@ -38,19 +39,56 @@ public:
 	 * @param temp_dir Directory to store temporary files (generated isolate's meta log)
 	 * @param data_dit Directory containing sources which will be copied into sandbox
 	 * @param logger Set system logger (optional).
+	 * @param box_pool Pool of initialized boxes (optional). If given, box is taken from the pool
+	 * instead of initialization and @a id is not used.
+	 * @param data_mode The way in which data directory is handed over to the sandbox (optional).
+	 * @param cgroup_root Directory with cgroups of isolate boxes (optional). If given, counters of the box
+	 * cgroup are read after the run in addition to the meta file.
+	 * @param batch Name of the test batch of the sandboxed task (optional). If given together with @a box_pool,
+	 * the box is not reset after the run, only its files are removed and the box is reused by the next task
+	 * of the same batch.
 	 */
 	isolate_sandbox(std::shared_ptr<sandbox_config> sandbox_config,
 		sandbox_limits limits,
 		std::size_t id,
 		const std::string &temp_dir,
 		const std::string &data_dir,
-		std::shared_ptr<spdlog::logger> logger = nullptr);
+		std::shared_ptr<spdlog::logger> logger = nullptr,
+		std::shared_ptr<isolate_box_pool> box_pool = nullptr,
+		sandbox_data_mode data_mode = sandbox_data_mode::COPY,
+		const std::string &cgroup_root = "",
+		const std::string &batch = "");
 	/**
 	 * Destructor.
 	 */
 	~isolate_sandbox() override;
 	sandbox_results run(const std::string &binary, const std::vector<std::string> &arguments) override;
 
+	/**
+	 * Initialize isolate box with given identifier.
+	 * @param id Identifier of the box.
+	 * @param logger Logger for reporting errors.
+	 * @return Path to the directory inside the box which is accessible by sandboxed program.
+	 * @throws sandbox_exception if the box cannot be initialized
+	 */
+	static std::string init_box(std::size_t id, std::shared_ptr<spdlog::logger> logger);
+	/**
+	 * Cleanup isolate box with given identifier.
+	 * @param id Identifier of the box.
+	 * @param logger Logger for reporting errors.
+	 * @throws sandbox_exception if the box cannot be cleaned up
+	 */
+	static void cleanup_box(std::size_t id, std::shared_ptr<spdlog::logger> logger);
+	/**
+	 * Check that the worker is able to mount overlay in given directory, it is needed by overlay data mode.
+	 * @param dir Directory in which a temporary overlay is mounted and unmounted.
+	 * @throws sandbox_exception if the overlay cannot be mounted
+	 */
+	static void check_overlay(const std::string &dir);
+
+	/** Name of isolate binary which is searched in PATH */
+	static const char *const isolate_binary;
+
 private:
 	/** General sandbox configuration */
 	std::shared_ptr<sandbox_config> sandbox_config_;
@@ -70,16 +108,37 @@ private:
 	int max_timeout_;
 	/** Path to the directory containing sources moved to sandbox and back */
 	std::string data_dir_;
-	/** Initialize isolate */
-	void isolate_init();
-	/** Actual code for isolate initialization inside a process. Called by isolate_init(). */
-	void isolate_init_child(int fd_0, int fd_1);
-	/** Cleanup isolate after finish evaluation */
-	void isolate_cleanup();
+	/** Pool from which the box was taken, @a nullptr if box is initialized by this sandbox */
+	std::shared_ptr<isolate_box_pool> box_pool_;
+	/** Requested way of handing data directory over to the sandbox */
+	sandbox_data_mode data_mode_;
+	/** The way which was actually used for current run, renaming may fall back to copying */
+	sandbox_data_mode transfer_mode_;
+	/** Directory with upper layer, work directory and mount point of the overlay */
+	std::string overlay_dir_;
+	/** Whether the overlay is mounted, its directory must not be removed then */
+	bool overlay_mounted_ = false;
+	/** Directory with cgroups of isolate boxes, empty if counters are taken only from the meta file */
+	std::string cgroup_root_;
+	/** Name of the test batch whose tasks reuse the box, empty if the box is used only once */
+	std::string batch_;
+	/** Hand data directory over to the sandbox according to the data mode. */
+	void move_data_in();
+	/** Get data directory back from the sandbox, the same way it was handed over. */
+	void move_data_out();
+	/** Report to the debug log how many bytes were not copied thanks to the data mode. */
+	void log_avoided_copy(const std::string &dir);
+	/** Mount overlay with data directory as the lower layer, throws sandbox_exception if it cannot be mounted. */
+	void mount_overlay();
+	/**
+	 * Unmount overlay, copy declared output files from its upper layer to data directory, discard the layer.
+	 * Throws sandbox_exception if it cannot be unmounted, nothing is copied or removed then.
+	 */
+	void unmount_overlay();
 	/** Run isolate evaluation with sandboxed program inside. */
 	void isolate_run(const std::string &binary, const std::vector<std::string> &arguments);
-	/** Get isolate command line arguments as plain C string including sandboxed binary with its arguments. */
-	char **isolate_run_args(const std::string &binary, const std::vector<std::string> &arguments);
+	/** Get isolate command line arguments including sandboxed binary with its arguments. */
+	std::vector<std::string> isolate_run_args(const std::string &binary, const std::vector<std::string> &arguments);
 	/** Parse isolate's meta file with evaluation informations. Must be called after isolate_run() method. */
 	sandbox_results process_meta_file();
 };
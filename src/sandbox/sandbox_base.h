@@ -13,6 +13,21 @@
 #include "helpers/format.h"
 
 
+/**
+ * Ways of handing the directory with evaluation data over to the sandbox.
+ */
+enum class sandbox_data_mode {
+	/** Data are copied into the sandbox and back */
+	COPY,
+	/** Data are renamed into the sandbox and back, copying is used if not on the same filesystem */
+	RENAME,
+	/** Directory with data is bound into the sandbox, nothing is moved */
+	BIND,
+	/** Directory with data is a read-only lower layer of an overlay bound into the sandbox, writes are discarded */
+	OVERLAY
+};
+
+
 /**
  * Base class for all sandbox implementations.
  */
@@ -2,6 +2,7 @@
 #include "sandbox/isolate_sandbox.h"
 #include "helpers/string_utils.h"
 #include "helpers/filesystem.h"
+#include "helpers/timings.h"
 #include <fstream>
 #include <algorithm>
 #include <memory>
@@ -12,10 +13,10 @@
 
 namespace fs = boost::filesystem;
 
-external_task::external_task(const create_params &data)
+external_task::external_task(const create_params &data, std::shared_ptr<isolate_box_pool> box_pool)
 	: task_base(data.id, data.task_meta), worker_config_(data.worker_conf), sandbox_(nullptr),
 	  sandbox_config_(data.task_meta->sandbox), limits_(data.limits), logger_(data.logger), temp_dir_(data.temp_dir),
-	  evaluation_dir_(data.source_path), sandbox_working_dir_(data.sandbox_working_path)
+	  evaluation_dir_(data.source_path), sandbox_working_dir_(data.sandbox_working_path), box_pool_(box_pool)
 {
 	if (worker_config_ == nullptr) { throw task_exception("No worker configuration provided."); }
 
@@ -55,8 +56,21 @@ void external_task::sandbox_init()
 
 			// TODO: a better way would be to make this optional (a job will define, whether it requires net or not)
 		}
-		sandbox_ = std::make_shared<isolate_sandbox>(
-			sandbox_config_, limits, worker_config_->get_worker_id(), temp_dir_, evaluation_dir_.string(), logger_);
+		auto data_mode = worker_config_->get_sandbox_data_mode();
+		if (data_mode == sandbox_data_mode::OVERLAY && this->get_type() != task_type::EXECUTION) {
+			// only tested programs run on top of the overlay, compilations and judges have to keep their files
+			data_mode = sandbox_data_mode::BIND;
+		}
+		sandbox_ = std::make_shared<isolate_sandbox>(sandbox_config_,
+			limits,
+			worker_config_->get_worker_id(),
+			temp_dir_,
+			evaluation_dir_.string(),
+			logger_,
+			box_pool_,
+			data_mode,
+			worker_config_->get_box_cgroup_root(),
+			sandbox_config_->batch);
 	}
 #endif
 }
@@ -68,13 +82,17 @@ void external_task::sandbox_fini()
 
 std::shared_ptr<task_results> external_task::run()
 {
+	helpers::phase_timings timings;
+	helpers::phase_timer init_timer(timings, "sandbox-init");
 	sandbox_init();
+	init_timer.stop();
 
 	if (sandbox_ == nullptr) {
 		// should never happen, unless we are doomed
 		return nullptr;
 	}
 
+	helpers::phase_timer setup_timer(timings, "setup");
 	// initialize output from stdout and stderr
 	results_output_init();
 
@@ -85,15 +103,20 @@ std::shared_ptr<task_results> external_task::run()
 
 	// check if binary is executable and set it otherwise
 	make_binary_executable(task_meta_->binary);
+	setup_timer.stop();
 
 	auto res = std::make_shared<task_results>();
 	res->sandbox_status =
 		std::unique_ptr<sandbox_results>(new sandbox_results(sandbox_->run(task_meta_->binary, task_meta_->cmd_args)));
+	timings.insert(timings.end(), res->sandbox_status->timings.begin(), res->sandbox_status->timings.end());
 
 	// get output from stdout and stderr
+	helpers::phase_timer output_timer(timings, "output");
 	get_results_output(res);
+	output_timer.stop();
 
 	sandbox_fini();
+	res->timings = std::move(timings);
 
 	// Check if sandbox ran successfully, else report error
 	if (res->sandbox_status->status != isolate_status::OK) {
@@ -104,6 +127,19 @@ std::shared_ptr<task_results> external_task::run()
 	return res;
 }
 
+bool external_task::is_exclusive()
+{
+	// bound directory stays in place, so only boxes have to be distinct
+	auto data_mode = worker_config_->get_sandbox_data_mode();
+	return (data_mode != sandbox_data_mode::BIND && data_mode != sandbox_data_mode::OVERLAY) || box_pool_ == nullptr;
+}
+
+bool external_task::is_overlaid()
+{
+	return worker_config_->get_sandbox_data_mode() == sandbox_data_mode::OVERLAY &&
+		this->get_type() == task_type::EXECUTION;
+}
+
 std::shared_ptr<sandbox_limits> external_task::get_limits()
 {
 	return limits_;
@@ -8,6 +8,7 @@
 #include "sandbox/sandbox_base.h"
 #include "config/sandbox_limits.h"
 
+class isolate_box_pool;
 
 /**
  * Class which handles external tasks, aka tasks which will be executed in sandbox.
@@ -25,9 +26,10 @@ public:
 	 * Only way to construct external task is through this constructor.
 	 * Choosing propriate sandbox and constructing it, is also done here.
 	 * @param data Data to create external task class.
+	 * @param box_pool Pool of initialized isolate boxes, if @a nullptr, each run initializes its own box.
 	 * @throws task_exception if name of the sandbox in data argument is unknown.
 	 */
-	external_task(const create_params &data);
+	external_task(const create_params &data, std::shared_ptr<isolate_box_pool> box_pool = nullptr);
 	/**
 	 * Destructor, empty right now.
 	 */
@@ -39,6 +41,17 @@ public:
 	 * @throws sandbox_exception if fatal error occured in sandbox
 	 */
 	std::shared_ptr<task_results> run() override;
+	/**
+	 * Sandboxed program works with whole evaluation directory which is moved into sandbox and back.
+	 * Only bound or overlaid evaluation directory with boxes taken from a pool can be used by more tasks at once.
+	 * @return @a false if evaluation directory is bound or overlaid and box pool is used, @a true otherwise
+	 */
+	bool is_exclusive() override;
+	/**
+	 * Only tested programs run on top of an overlay, other tasks have the evaluation directory bound.
+	 * @return @a true if the task is an execution and the data mode is overlay
+	 */
+	bool is_overlaid() override;
 
 	/**
 	 * Get sandbox_limits structure, given during construction.
@@ -103,6 +116,8 @@ private:
 	fs::path evaluation_dir_;
 	/** Directory binded to the sandbox as default working dir */
 	fs::path sandbox_working_dir_;
+	/** Pool of initialized isolate boxes, can be @a nullptr */
+	std::shared_ptr<isolate_box_pool> box_pool_;
 	/** After execution delete stdout file produced by sandbox */
 	bool remove_stdout_ = false;
 	/** After execution delete stderr file produced by sandbox */
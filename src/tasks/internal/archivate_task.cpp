@@ -2,7 +2,9 @@
 #include "archives/archivator.h"
 
 
-archivate_task::archivate_task(std::size_t id, std::shared_ptr<task_metadata> task_meta) : task_base(id, task_meta)
+archivate_task::archivate_task(
+	std::size_t id, std::shared_ptr<task_metadata> task_meta, std::size_t compression_threads)
+	: task_base(id, task_meta), compression_threads_(compression_threads)
 {
 	if (task_meta_->cmd_args.size() != 2) {
 		throw task_exception(
@@ -16,7 +18,16 @@ std::shared_ptr<task_results> archivate_task::run()
 	std::shared_ptr<task_results> result(new task_results());
 
 	try {
-		archivator::compress(task_meta_->cmd_args[0], task_meta_->cmd_args[1]);
+		auto &destination = task_meta_->cmd_args[1];
+		const std::string zstd_suffix = ".tar.zst";
+		bool zstd = destination.size() > zstd_suffix.size() &&
+			destination.compare(destination.size() - zstd_suffix.size(), zstd_suffix.size(), zstd_suffix) == 0;
+
+		archivator::compress(task_meta_->cmd_args[0],
+			destination,
+			zstd ? archive_type::TAR_ZSTD : archive_type::ZIP,
+			0,
+			compression_threads_);
 	} catch (archive_exception &e) {
 		result->status = task_status::FAILED;
 		result->error_message = std::string("Cannot create archive. Error: ") + e.what();
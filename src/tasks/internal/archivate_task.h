@@ -15,10 +15,12 @@ public:
 	 * @param id Unique identificator of load order of tasks.
 	 * @param task_meta Variable containing further info about task. It's required that
 	 * @a cmd_args entry has just 2 arguments - directory to be archived and name of the archive.
-	 * For more info about archivation see @ref archivator class.
+	 * For more info about archivation see @ref archivator class. Archives with @a .tar.zst suffix
+	 * are tar archives compressed by zstd, others are zip archives.
+	 * @param compression_threads Number of threads compressing tar.zst archive.
 	 * @throws task_exception on invalid number of arguments.
 	 */
-	archivate_task(std::size_t id, std::shared_ptr<task_metadata> task_meta);
+	archivate_task(std::size_t id, std::shared_ptr<task_metadata> task_meta, std::size_t compression_threads = 1);
 	/**
 	 * Destructor.
 	 */
@@ -28,6 +30,10 @@ public:
 	 * @return Evaluation results to be pushed back to frontend.
 	 */
 	std::shared_ptr<task_results> run() override;
+
+private:
+	/** Number of threads compressing tar.zst archive. */
+	std::size_t compression_threads_;
 };
 
 #endif // RECODEX_WORKER_INTERNAL_ARCHIVATE_TASK_H
@@ -1,4 +1,7 @@
 #include "fetch_task.h"
+#include "helpers/logger.h"
+#include <map>
+#include <set>
 
 
 fetch_task::fetch_task(
@@ -16,6 +19,30 @@ std::shared_ptr<task_results> fetch_task::run()
 {
 	std::shared_ptr<task_results> result(new task_results());
 
+	// prefetched file is only moved into place, so files are written in the order of tasks
+	if (prefetched_.valid()) {
+		auto failure = prefetched_.get()[prefetch_position_];
+		if (failure != nullptr) {
+			result->status = task_status::FAILED;
+			try {
+				std::rethrow_exception(failure);
+			} catch (std::exception &e) {
+				result->error_message = std::string("Cannot fetch files. Error: ") + e.what();
+			} catch (...) {
+				result->error_message = "Cannot fetch files. Error: unknown";
+			}
+			return result;
+		}
+
+		boost::system::error_code error;
+		fs::rename(staged_path_, task_meta_->cmd_args[1], error);
+		if (!error) { return result; }
+		logger_->warn("Prefetched file {} cannot be moved to {}, it is fetched again: {}",
+			task_meta_->cmd_args[0],
+			task_meta_->cmd_args[1],
+			error.message());
+	}
+
 	try {
 		filemanager_->get_file(task_meta_->cmd_args[0], task_meta_->cmd_args[1]);
 	} catch (fm_exception &e) {
@@ -25,3 +52,49 @@ std::shared_ptr<task_results> fetch_task::run()
 
 	return result;
 }
+
+void fetch_task::prefetch(const std::vector<std::shared_ptr<fetch_task>> &tasks,
+	const fs::path &staging_dir,
+	std::shared_ptr<spdlog::logger> logger)
+{
+	if (logger == nullptr) { logger = helpers::create_null_logger(); }
+
+	boost::system::error_code error;
+	fs::create_directories(staging_dir, error);
+	if (error) { return; }
+
+	// files are requested in one batch from each file manager, only the first task of each destination
+	// is prefetched and the others fetch their files by themselves
+	std::set<std::string> destinations;
+	std::map<file_manager_interface *, std::vector<std::shared_ptr<fetch_task>>> batches;
+	for (auto &task : tasks) {
+		if (destinations.insert(task->task_meta_->cmd_args[1]).second) {
+			batches[task->filemanager_.get()].push_back(task);
+		}
+	}
+
+	std::size_t staged_count = 0;
+	for (auto &batch : batches) {
+		auto filemanager = batch.second.front()->filemanager_;
+		std::vector<std::pair<std::string, std::string>> files;
+		for (auto &task : batch.second) {
+			task->staged_path_ = staging_dir / std::to_string(staged_count++);
+			files.emplace_back(task->task_meta_->cmd_args[0], task->staged_path_.string());
+		}
+
+		std::shared_future<std::vector<std::exception_ptr>> prefetched =
+			std::async(std::launch::async, [filemanager, files]() {
+				try {
+					return filemanager->get_files(files);
+				} catch (...) {
+					return std::vector<std::exception_ptr>(files.size(), std::current_exception());
+				}
+			});
+
+		for (std::size_t i = 0; i < batch.second.size(); ++i) {
+			batch.second[i]->prefetched_ = prefetched;
+			batch.second[i]->prefetch_position_ = i;
+			batch.second[i]->logger_ = logger;
+		}
+	}
+}
@@ -4,6 +4,15 @@
 #include "tasks/task_base.h"
 #include "fileman/file_manager_interface.h"
 #include <memory>
+#include <future>
+#include <vector>
+#include <spdlog/spdlog.h>
+
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+#define BOOST_NO_CXX11_SCOPED_ENUMS
+#include <boost/filesystem.hpp>
+
+namespace fs = boost::filesystem;
 
 
 /**
@@ -32,7 +41,29 @@ public:
 	 */
 	std::shared_ptr<task_results> run() override;
 
+	/**
+	 * Start fetching files of all given tasks at once in background into a private staging directory,
+	 * the tasks then only wait for their files and move them to the destination when they are run,
+	 * so the destinations are written in the order of tasks. Only the first task of each destination
+	 * is prefetched. Failure of prefetching is reported as the failure of the task, only a file which
+	 * cannot be moved to its destination is fetched again by the task.
+	 * @param tasks fetch tasks of one job
+	 * @param staging_dir directory for prefetched files, it is created if it does not exist
+	 * @param logger job logger used by prefetched tasks, may be @a nullptr
+	 */
+	static void prefetch(const std::vector<std::shared_ptr<fetch_task>> &tasks,
+		const fs::path &staging_dir,
+		std::shared_ptr<spdlog::logger> logger = nullptr);
+
 private:
+	/** Results of prefetching shared by all prefetched tasks, not valid if the task was not prefetched. */
+	std::shared_future<std::vector<std::exception_ptr>> prefetched_;
+	/** Position of the file of this task in the prefetched results. */
+	std::size_t prefetch_position_ = 0;
+	/** Path of the prefetched file in the staging directory. */
+	fs::path staged_path_;
+	/** Job logger, set only if the task was prefetched. */
+	std::shared_ptr<spdlog::logger> logger_;
 	/** Pointer to filemanager instance. */
 	std::shared_ptr<file_manager_interface> filemanager_;
 };
@@ -1,5 +1,6 @@
 #include <boost/filesystem.hpp>
 #include "truncate_task.h"
+#include "helpers/filesystem.h"
 
 namespace fs = boost::filesystem;
 
@@ -21,6 +22,14 @@ std::shared_ptr<task_results> truncate_task::run()
 	limit *= 1024;
 
 	if (fs::file_size(file) > limit) {
+		// file might be hardlinked from the cache, which must not be truncated
+		try {
+			helpers::unshare_file(file);
+		} catch (helpers::filesystem_exception &) {
+			results->status = task_status::FAILED;
+			return results;
+		}
+
 		boost::system::error_code error_code;
 		fs::resize_file(file, limit, error_code);
 
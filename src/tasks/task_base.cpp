@@ -71,6 +71,16 @@ task_type task_base::get_type()
 	return task_meta_->type;
 }
 
+bool task_base::is_exclusive()
+{
+	return false;
+}
+
+bool task_base::is_overlaid()
+{
+	return false;
+}
+
 bool task_base::is_executable()
 {
 	return execute_;
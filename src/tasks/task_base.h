@@ -43,6 +43,17 @@ public:
 	 * @return Evaluation results to be pushed back to frontend.
 	 */
 	virtual std::shared_ptr<task_results> run() = 0;
+	/**
+	 * Tells whether task has to be executed alone, without any other task running at the same time.
+	 * @return @a true if task cannot run in parallel with other tasks, default is @a false.
+	 */
+	virtual bool is_exclusive();
+	/**
+	 * Tells whether task works on top of an overlay of the evaluation directory, so it only reads it. Such tasks
+	 * may run together, but not with tasks which might write into the directory.
+	 * @return @a true if evaluation directory is the lower layer of an overlay of the task, default is @a false.
+	 */
+	virtual bool is_overlaid();
 	/**
 	 * Add child to this task. Once given, child cannot be deleted.
 	 * @param add Pointer to child task (task dependent on current one).
@@ -1,7 +1,10 @@
 #include "task_factory.h"
 
 
-task_factory::task_factory(std::shared_ptr<file_manager_interface> fileman) : fileman_(fileman)
+task_factory::task_factory(std::shared_ptr<file_manager_interface> fileman,
+	std::shared_ptr<isolate_box_pool> box_pool,
+	std::size_t compression_threads)
+	: fileman_(fileman), box_pool_(box_pool), compression_threads_(compression_threads)
 {
 }
 
@@ -22,7 +25,7 @@ std::shared_ptr<task_base> task_factory::create_internal_task(std::size_t id, st
 	} else if (task_meta->binary == "rm") {
 		task = std::make_shared<rm_task>(id, task_meta);
 	} else if (task_meta->binary == "archivate") {
-		task = std::make_shared<archivate_task>(id, task_meta);
+		task = std::make_shared<archivate_task>(id, task_meta, compression_threads_);
 	} else if (task_meta->binary == "extract") {
 		task = std::make_shared<extract_task>(id, task_meta);
 	} else if (task_meta->binary == "fetch") {
@@ -40,5 +43,5 @@ std::shared_ptr<task_base> task_factory::create_internal_task(std::size_t id, st
 
 std::shared_ptr<task_base> task_factory::create_sandboxed_task(const create_params &data)
 {
-	return std::make_shared<external_task>(data);
+	return std::make_shared<external_task>(data, box_pool_);
 }
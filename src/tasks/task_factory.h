@@ -27,8 +27,12 @@ public:
 	/**
 	 * Constructor
 	 * @param fileman Instance of file manager to be used. It's required by @ref fetch_task to work properly.
+	 * @param box_pool Pool of initialized isolate boxes given to sandboxed tasks (optional).
+	 * @param compression_threads Number of threads compressing archives of @ref archivate_task.
 	 */
-	task_factory(std::shared_ptr<file_manager_interface> fileman);
+	task_factory(std::shared_ptr<file_manager_interface> fileman,
+		std::shared_ptr<isolate_box_pool> box_pool = nullptr,
+		std::size_t compression_threads = 1);
 
 	/**
 	 * Virtual destructor
@@ -59,6 +63,10 @@ public:
 private:
 	/** Pointer to given file manager instance. */
 	std::shared_ptr<file_manager_interface> fileman_;
+	/** Pool of isolate boxes for sandboxed tasks, can be @a nullptr. */
+	std::shared_ptr<isolate_box_pool> box_pool_;
+	/** Number of threads compressing archives. */
+	std::size_t compression_threads_;
 };
 
 
@@ -7,11 +7,13 @@
 #include "fileman/http_manager.h"
 #include "job/job_receiver.h"
 #include "job/progress_callback.h"
+#include "sandbox/isolate_box_pool.h"
+#include "sandbox/isolate_sandbox.h"
 
 
 worker_core::worker_core(std::vector<std::string> args)
 	: args_(args), config_filename_("config.yml"), working_directory_(fs::temp_directory_path() / "isoeval"),
-	  logger_(nullptr), remote_fm_(nullptr), cache_fm_(nullptr), job_receiver_(nullptr), broker_(nullptr)
+	  logger_(nullptr), remote_fm_(nullptr), cache_fm_(nullptr), job_dispatcher_(nullptr), broker_(nullptr)
 {
 	// Initialize the ZMQ context
 	zmq_context_ = std::make_shared<zmq::context_t>(1);
@@ -29,8 +31,12 @@ worker_core::worker_core(std::vector<std::string> args)
 	broker_init();
 	// construct filemanagers
 	fileman_init();
+	// construct pool of sandboxes
+	sandbox_init();
 	// evaluator initialization
 	receiver_init();
+	// start serving metrics
+	metrics_init();
 }
 
 worker_core::~worker_core()
@@ -54,9 +60,24 @@ void worker_core::run()
 	}
 	logger_->info("Broker connection thread created succesfully.");
 
+	// every slot but the first one receives jobs in its own thread, dispatcher too
+	std::vector<std::thread> slot_threads;
+	try {
+		if (job_dispatcher_ != nullptr) {
+			slot_threads.emplace_back(std::bind(&job_dispatcher::start_dispatching, job_dispatcher_));
+		}
+		for (std::size_t i = 1; i < job_receivers_.size(); ++i) {
+			slot_threads.emplace_back(std::bind(&job_receiver::start_receiving, job_receivers_[i]));
+		}
+	} catch (std::system_error &e) {
+		logger_->critical("Evaluation slot thread cannot be started: {}", e.what());
+		force_exit();
+	}
+
 	logger_->info("Job receiver will now start receiving.");
-	job_receiver_->start_receiving();
+	job_receivers_.front()->start_receiving();
 
+	for (auto &thread : slot_threads) { thread.join(); }
 	broker_thread.join();
 	return;
 }
@@ -95,6 +116,16 @@ void worker_core::load_config()
 	try {
 		YAML::Node config_yaml = YAML::LoadFile(config_filename_);
 		config_ = std::make_shared<worker_config>(config_yaml);
+#ifndef _WIN32
+		// overlays are mounted by the worker itself, so it has to be privileged to do so
+		if (config_->get_sandbox_data_mode() == sandbox_data_mode::OVERLAY) {
+			try {
+				isolate_sandbox::check_overlay(config_->get_working_directory());
+			} catch (sandbox_exception &e) {
+				throw config_error("Item sandbox-data-mode cannot be overlay: " + std::string(e.what()));
+			}
+		}
+#endif
 	} catch (std::exception &e) {
 		force_exit("Error loading config file: " + std::string(e.what()));
 	}
@@ -194,20 +225,61 @@ void worker_core::fileman_init()
 	logger_->info("Initializing file managers...");
 	auto fileman_conf = config_->get_filemans_configs();
 	remote_fm_ = std::make_shared<http_manager>(fileman_conf, logger_);
-	cache_fm_ = std::make_shared<cache_manager>(config_->get_cache_dir(), logger_);
+	cache_fm_ = std::make_shared<cache_manager>(
+		config_->get_cache_dir(), logger_, config_->get_cache_max_size(), config_->get_cache_hardlinks());
 	logger_->info("File managers initialized.");
 
 	return;
 }
 
+void worker_core::sandbox_init()
+{
+#ifndef _WIN32
+	auto pool_size = config_->get_box_pool_size();
+	if (pool_size == 0) { return; }
+
+	for (std::size_t slot = 0; slot < config_->get_slots(); ++slot) {
+		auto first_id = config_->get_slot_config(slot)->get_box_pool_first_id();
+		logger_->info("Initializing pool of {} isolate boxes starting with {}...", pool_size, first_id);
+		box_pools_.push_back(std::make_shared<isolate_box_pool>(first_id, pool_size, logger_));
+	}
+	logger_->info("Isolate box pools initialized.");
+#endif
+
+	return;
+}
+
 void worker_core::receiver_init()
 {
-	logger_->info("Initializing job receiver and evaluator...");
+	auto slots = config_->get_slots();
+	logger_->info("Initializing job receivers and evaluators of {} slot(s)...", slots);
 	auto progr_callback = std::make_shared<progress_callback>(zmq_context_, logger_);
-	auto evaluator =
-		std::make_shared<job_evaluator>(logger_, config_, remote_fm_, cache_fm_, working_directory_, progr_callback);
-	job_receiver_ = std::make_shared<job_receiver>(zmq_context_, evaluator, logger_);
-	logger_->info("Job receiver and evaluator initialized.");
+
+	// with more slots the jobs are dispatched to sockets of the slots instead of the socket of broker connection
+	if (slots > 1) { job_dispatcher_ = std::make_shared<job_dispatcher>(zmq_context_, slots, logger_); }
+
+	for (std::size_t slot = 0; slot < slots; ++slot) {
+		auto slot_config = slots > 1 ? config_->get_slot_config(slot) : config_;
+		auto box_pool = box_pools_.empty() ? nullptr : box_pools_[slot];
+		auto evaluator = std::make_shared<job_evaluator>(
+			logger_, slot_config, remote_fm_, cache_fm_, working_directory_, progr_callback, box_pool);
+		auto socket_id = slots > 1 ? job_dispatcher::get_slot_socket_id(slot) : "";
+		job_receivers_.push_back(std::make_shared<job_receiver>(
+			zmq_context_, evaluator, logger_, config_->get_prefetch_next_job(), socket_id));
+	}
+	logger_->info("Job receivers and evaluators initialized.");
+	return;
+}
+
+void worker_core::metrics_init()
+{
+	auto endpoint = config_->get_metrics_endpoint();
+	if (endpoint.empty()) { return; }
+
+	logger_->info("Initializing metrics endpoint...");
+	metrics_server_ = std::unique_ptr<metrics_server>(new metrics_server(zmq_context_, endpoint, logger_));
+	logger_->info("Metrics endpoint initialized.");
+
 	return;
 }
 
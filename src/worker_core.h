@@ -25,6 +25,8 @@ namespace fs = boost::filesystem;
 #include "fileman/file_manager_interface.h"
 #include "job/job_receiver.h"
 #include "job/job_evaluator.h"
+#include "job/job_dispatcher.h"
+#include "metrics_server.h"
 
 
 /**
@@ -54,7 +56,7 @@ public:
 
 	/**
 	 * Constructors initializes all things,	all we have to do now is launch all the fun.
-	 * This method creates separate thread for broker_connection and starts job_evaluator service.
+	 * This method creates separate thread for broker_connection and starts job receivers of all slots.
 	 */
 	void run();
 
@@ -105,10 +107,21 @@ private:
 	void fileman_init();
 
 	/**
-	 * Job receiver and evaluator construction and initialization.
+	 * Construct pools of isolate boxes for all slots if enabled in configuration.
+	 */
+	void sandbox_init();
+
+	/**
+	 * Job receivers and evaluators of all slots construction and initialization.
+	 * Dispatcher of the jobs is constructed if there is more than one slot.
 	 */
 	void receiver_init();
 
+	/**
+	 * Start serving metrics if enabled in configuration.
+	 */
+	void metrics_init();
+
 	/**
 	 * Initialize working directory of whole worker.
 	 */
@@ -135,14 +148,23 @@ private:
 	/** File manager that works with a local cache */
 	std::shared_ptr<file_manager_interface> cache_fm_;
 
-	/** Handles evaluation and all things around */
-	std::shared_ptr<job_receiver> job_receiver_;
+	/** Pools of initialized isolate boxes for each slot, empty if disabled */
+	std::vector<std::shared_ptr<isolate_box_pool>> box_pools_;
+
+	/** Handle evaluation and all things around, one for each evaluation slot */
+	std::vector<std::shared_ptr<job_receiver>> job_receivers_;
+
+	/** Distributes jobs among the slots, @a nullptr if there is only one slot */
+	std::shared_ptr<job_dispatcher> job_dispatcher_;
 
 	/** Handles connection to broker, receiving submission and pushing results */
 	std::shared_ptr<broker_connection<connection_proxy>> broker_;
 
 	/** A ZeroMQ context */
 	std::shared_ptr<zmq::context_t> zmq_context_;
+
+	/** Serves metrics of the worker, @a nullptr if disabled; destroyed before the context */
+	std::unique_ptr<metrics_server> metrics_server_;
 };
 
 #endif // RECODEX_WORKER_ISOEVAL_CORE_HPP
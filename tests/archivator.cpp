@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <fstream>
+#include <iterator>
+#include <sstream>
 
 #include "archives/archivator.h"
 
@@ -52,6 +54,41 @@ TEST(Archivator, DecompressTarBz2)
 	fs::remove_all(fs::temp_directory_path() / "valid_tar");
 }
 
+TEST(Archivator, DecompressTarGzStream)
+{
+	auto destination = fs::temp_directory_path() / fs::unique_path("recodex_stream_%%%%-%%%%");
+	fs::create_directories(destination);
+	std::ifstream input("testing_archives/valid_tar.tar.gz", std::ios::binary);
+	ASSERT_NO_THROW(archivator::decompress(input, destination.string()));
+	EXPECT_TRUE(fs::is_regular_file(destination / "subdir" / "subfile.txt"));
+	EXPECT_EQ((std::size_t) 7, fs::file_size(destination / "a.txt"));
+	EXPECT_EQ((std::size_t) 5, fs::file_size(destination / "b.txt"));
+	fs::remove_all(destination);
+}
+
+TEST(Archivator, DecompressZipStream)
+{
+	auto destination = fs::temp_directory_path() / fs::unique_path("recodex_stream_%%%%-%%%%");
+	fs::create_directories(destination);
+	std::ifstream input("testing_archives/valid_zip.zip", std::ios::binary);
+	ASSERT_NO_THROW(archivator::decompress(input, destination.string()));
+	EXPECT_TRUE(fs::is_regular_file(destination / "subdir" / "subfile.txt"));
+	EXPECT_EQ((std::size_t) 7, fs::file_size(destination / "a.txt"));
+	EXPECT_EQ((std::size_t) 5, fs::file_size(destination / "b.txt"));
+	fs::remove_all(destination);
+}
+
+TEST(Archivator, DecompressTruncatedStream)
+{
+	auto destination = fs::temp_directory_path() / fs::unique_path("recodex_stream_%%%%-%%%%");
+	fs::create_directories(destination);
+	std::ifstream file("testing_archives/valid_tar.tar.gz", std::ios::binary);
+	std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	std::istringstream input(content.substr(0, content.size() / 2));
+	EXPECT_THROW(archivator::decompress(input, destination.string()), archive_exception);
+	fs::remove_all(destination);
+}
+
 TEST(Archivator, DecompressCorruptedZip)
 {
 	EXPECT_THROW(archivator::decompress("testing_archives/corrupted_zip.zip", fs::temp_directory_path().string()),
@@ -103,3 +140,75 @@ TEST(Archivator, CompressAbsolutePath)
 	fs::remove_all(extracted_path);
 	fs::remove(result_path);
 }
+
+TEST(Archivator, CompressTarZstd)
+{
+	auto archive_path = fs::temp_directory_path() / "archive_test";
+	fs::create_directories(archive_path / "subdir");
+	fs::path result_path = fs::temp_directory_path() / "archive.tar.zst";
+	fs::path extracted_path = fs::temp_directory_path() / "archive";
+
+	{
+		std::ofstream test_file((archive_path / "test_file.txt").string());
+		test_file << "1234567";
+		std::ofstream empty_file((archive_path / "subdir" / "empty.txt").string());
+	}
+
+	ASSERT_NO_THROW(archivator::compress(
+		archive_path.string(), result_path.string(), archive_type::TAR_ZSTD, 19));
+	ASSERT_TRUE(fs::is_regular_file(result_path));
+
+	ASSERT_NO_THROW(archivator::decompress(result_path.string(), fs::temp_directory_path().string()));
+	ASSERT_TRUE(fs::is_regular_file(extracted_path / "test_file.txt"));
+	ASSERT_EQ((std::size_t) 7, fs::file_size(extracted_path / "test_file.txt"));
+	ASSERT_TRUE(fs::is_regular_file(extracted_path / "subdir" / "empty.txt"));
+	ASSERT_EQ((std::size_t) 0, fs::file_size(extracted_path / "subdir" / "empty.txt"));
+
+	fs::remove_all(archive_path);
+	fs::remove_all(extracted_path);
+	fs::remove(result_path);
+}
+
+TEST(Archivator, CompressTarZstdThreads)
+{
+	auto archive_path = fs::temp_directory_path() / "archive_test";
+	fs::create_directories(archive_path);
+	auto first_dir = fs::temp_directory_path() / "archive_threads_2";
+	auto second_dir = fs::temp_directory_path() / "archive_threads_4";
+	fs::create_directories(first_dir);
+	fs::create_directories(second_dir);
+
+	{
+		std::ofstream test_file((archive_path / "log.txt").string());
+		for (int i = 0; i < 200000; ++i) { test_file << "line " << i << " of the judge log\n"; }
+	}
+
+	// archives have the same name, so that they have the same root directory
+	auto first = first_dir / "archive.tar.zst";
+	auto second = second_dir / "archive.tar.zst";
+	ASSERT_NO_THROW(archivator::compress(archive_path.string(), first.string(), archive_type::TAR_ZSTD, 3, 2));
+	ASSERT_NO_THROW(archivator::compress(archive_path.string(), second.string(), archive_type::TAR_ZSTD, 3, 4));
+
+	// output does not depend on number of threads
+	std::ifstream first_file(first.string(), std::ios::binary);
+	std::ifstream second_file(second.string(), std::ios::binary);
+	std::string first_content((std::istreambuf_iterator<char>(first_file)), std::istreambuf_iterator<char>());
+	std::string second_content((std::istreambuf_iterator<char>(second_file)), std::istreambuf_iterator<char>());
+	ASSERT_FALSE(first_content.empty());
+	ASSERT_EQ(first_content, second_content);
+
+	ASSERT_NO_THROW(archivator::decompress(first.string(), first_dir.string()));
+	ASSERT_EQ(fs::file_size(archive_path / "log.txt"), fs::file_size(first_dir / "archive" / "log.txt"));
+
+	fs::remove_all(archive_path);
+	fs::remove_all(first_dir);
+	fs::remove_all(second_dir);
+}
+
+TEST(Archivator, ParseFormat)
+{
+	EXPECT_EQ(archive_type::ZIP, archivator::parse_format("zip"));
+	EXPECT_EQ(archive_type::TAR_ZSTD, archivator::parse_format("tar.zst"));
+	EXPECT_EQ("tar.zst", archivator::get_format_name(archive_type::TAR_ZSTD));
+	EXPECT_THROW(archivator::parse_format("rar"), archive_exception);
+}
@@ -41,6 +41,37 @@ TEST(broker_connection, sends_init)
 	connection.connect();
 }
 
+TEST(broker_connection, advertises_result_format)
+{
+	auto config = std::make_shared<mock_worker_config>();
+	auto proxy = std::make_shared<StrictMock<mock_connection_proxy>>();
+	broker_connection<mock_connection_proxy> connection(config, proxy);
+
+	std::string addr("tcp://localhost:9876");
+	std::string description("linux_worker_1");
+	std::string hwgroup = "group_1";
+	std::string format = "tar.zst";
+	worker_config::header_map_t headers = {std::make_pair("env", "c")};
+
+	EXPECT_CALL(*config, get_broker_uri()).WillRepeatedly(ReturnRef(addr));
+	EXPECT_CALL(*config, get_headers()).WillRepeatedly(ReturnRef(headers));
+	EXPECT_CALL(*config, get_worker_description()).WillRepeatedly(ReturnRef(description));
+	EXPECT_CALL(*config, get_hwgroup()).WillRepeatedly(ReturnRef(hwgroup));
+	EXPECT_CALL(*config, get_result_format()).WillRepeatedly(ReturnRef(format));
+
+	{
+		InSequence s;
+
+		EXPECT_CALL(*proxy, connect(StrEq(addr)));
+		EXPECT_CALL(*proxy,
+			send_broker(
+				ElementsAre("init", hwgroup, "env=c", "", "description=linux_worker_1", "result_format=tar.zst")))
+			.WillOnce(Return(true));
+	}
+
+	connection.connect();
+}
+
 ACTION(ClearFlags)
 {
 	((message_origin::set &) arg0).reset();
@@ -111,3 +142,139 @@ TEST(broker_connection, sends_ping)
 
 	connection.receive_tasks();
 }
+
+TEST(broker_connection, reports_queued_job)
+{
+	auto config = std::make_shared<NiceMock<mock_worker_config>>();
+	auto proxy = std::make_shared<StrictMock<mock_connection_proxy>>();
+	broker_connection<mock_connection_proxy> connection(config, proxy);
+
+	std::string description("linux_worker_1");
+	worker_config::header_map_t headers = {std::make_pair("env", "c")};
+	std::string hwgroup = "group_1";
+
+	EXPECT_CALL(*config, get_headers()).WillRepeatedly(ReturnRef(headers));
+	EXPECT_CALL(*config, get_worker_description()).WillRepeatedly(ReturnRef(description));
+	EXPECT_CALL(*config, get_hwgroup()).WillRepeatedly(ReturnRef(hwgroup));
+	EXPECT_CALL(*config, get_prefetch_next_job()).WillRepeatedly(Return(true));
+
+	EXPECT_CALL(*proxy, send_broker(ElementsAre("ping"))).WillRepeatedly(Return(true));
+
+	{
+		InSequence s;
+
+		for (auto &id : {"10", "11"}) {
+			EXPECT_CALL(*proxy, poll(_, _, _, _)).WillOnce(DoAll(ClearFlags(), SetFlag(message_origin::BROKER)));
+			EXPECT_CALL(*proxy, recv_broker(_, _))
+				.WillOnce(DoAll(SetArgReferee<0>(std::vector<std::string>{"eval", id, "archive_url", "result_url"}),
+					Return(true)));
+			EXPECT_CALL(*proxy, send_jobs(ElementsAre("eval", id, "archive_url", "result_url")))
+				.WillOnce(Return(true));
+		}
+
+		EXPECT_CALL(*proxy, poll(_, _, _, _)).WillOnce(DoAll(ClearFlags(), SetFlag(message_origin::BROKER)));
+		EXPECT_CALL(*proxy, recv_broker(_, _))
+			.WillOnce(DoAll(SetArgReferee<0>(std::vector<std::string>{"intro"}), Return(true)));
+		EXPECT_CALL(*proxy,
+			send_broker(ElementsAre("init",
+				hwgroup,
+				"env=c",
+				"",
+				"description=linux_worker_1",
+				"current_job=10",
+				"max_queued_jobs=1",
+				"queued_job=11")))
+			.WillOnce(Return(true));
+
+		// first job is done, the queued one becomes current
+		EXPECT_CALL(*proxy, poll(_, _, _, _)).WillOnce(DoAll(ClearFlags(), SetFlag(message_origin::JOBS)));
+		EXPECT_CALL(*proxy, recv_jobs(_, _))
+			.WillOnce(DoAll(SetArgReferee<0>(std::vector<std::string>{"done", "10", "OK", ""}), Return(true)));
+		EXPECT_CALL(*proxy, send_broker(ElementsAre("done", "10", "OK", ""))).WillOnce(Return(true));
+
+		EXPECT_CALL(*proxy, poll(_, _, _, _)).WillOnce(DoAll(ClearFlags(), SetFlag(message_origin::BROKER)));
+		EXPECT_CALL(*proxy, recv_broker(_, _))
+			.WillOnce(DoAll(SetArgReferee<0>(std::vector<std::string>{"intro"}), Return(true)));
+		EXPECT_CALL(*proxy,
+			send_broker(ElementsAre(
+				"init", hwgroup, "env=c", "", "description=linux_worker_1", "current_job=11", "max_queued_jobs=1")))
+			.WillOnce(Return(true));
+
+		EXPECT_CALL(*proxy, poll(_, _, _, _)).WillRepeatedly(SetArgReferee<2>(true));
+	}
+
+	connection.receive_tasks();
+}
+
+TEST(broker_connection, reports_jobs_of_slots)
+{
+	auto config = std::make_shared<NiceMock<mock_worker_config>>();
+	auto proxy = std::make_shared<StrictMock<mock_connection_proxy>>();
+	broker_connection<mock_connection_proxy> connection(config, proxy);
+
+	std::string description("linux_worker_1");
+	worker_config::header_map_t headers = {std::make_pair("env", "c")};
+	std::string hwgroup = "group_1";
+
+	EXPECT_CALL(*config, get_headers()).WillRepeatedly(ReturnRef(headers));
+	EXPECT_CALL(*config, get_worker_description()).WillRepeatedly(ReturnRef(description));
+	EXPECT_CALL(*config, get_hwgroup()).WillRepeatedly(ReturnRef(hwgroup));
+	EXPECT_CALL(*config, get_prefetch_next_job()).WillRepeatedly(Return(true));
+	EXPECT_CALL(*config, get_slots()).WillRepeatedly(Return(2));
+
+	EXPECT_CALL(*proxy, send_broker(ElementsAre("ping"))).WillRepeatedly(Return(true));
+
+	{
+		InSequence s;
+
+		for (auto &id : {"10", "11", "12"}) {
+			EXPECT_CALL(*proxy, poll(_, _, _, _)).WillOnce(DoAll(ClearFlags(), SetFlag(message_origin::BROKER)));
+			EXPECT_CALL(*proxy, recv_broker(_, _))
+				.WillOnce(DoAll(SetArgReferee<0>(std::vector<std::string>{"eval", id, "archive_url", "result_url"}),
+					Return(true)));
+			EXPECT_CALL(*proxy, send_jobs(ElementsAre("eval", id, "archive_url", "result_url")))
+				.WillOnce(Return(true));
+		}
+
+		EXPECT_CALL(*proxy, poll(_, _, _, _)).WillOnce(DoAll(ClearFlags(), SetFlag(message_origin::BROKER)));
+		EXPECT_CALL(*proxy, recv_broker(_, _))
+			.WillOnce(DoAll(SetArgReferee<0>(std::vector<std::string>{"intro"}), Return(true)));
+		EXPECT_CALL(*proxy,
+			send_broker(ElementsAre("init",
+				hwgroup,
+				"env=c",
+				"",
+				"description=linux_worker_1",
+				"slots=2",
+				"current_job=10",
+				"current_job=11",
+				"max_queued_jobs=2",
+				"queued_job=12")))
+			.WillOnce(Return(true));
+
+		// job of the second slot is done, the queued job is evaluated instead
+		EXPECT_CALL(*proxy, poll(_, _, _, _)).WillOnce(DoAll(ClearFlags(), SetFlag(message_origin::JOBS)));
+		EXPECT_CALL(*proxy, recv_jobs(_, _))
+			.WillOnce(DoAll(SetArgReferee<0>(std::vector<std::string>{"done", "11", "OK", ""}), Return(true)));
+		EXPECT_CALL(*proxy, send_broker(ElementsAre("done", "11", "OK", ""))).WillOnce(Return(true));
+
+		EXPECT_CALL(*proxy, poll(_, _, _, _)).WillOnce(DoAll(ClearFlags(), SetFlag(message_origin::BROKER)));
+		EXPECT_CALL(*proxy, recv_broker(_, _))
+			.WillOnce(DoAll(SetArgReferee<0>(std::vector<std::string>{"intro"}), Return(true)));
+		EXPECT_CALL(*proxy,
+			send_broker(ElementsAre("init",
+				hwgroup,
+				"env=c",
+				"",
+				"description=linux_worker_1",
+				"slots=2",
+				"current_job=10",
+				"current_job=12",
+				"max_queued_jobs=2")))
+			.WillOnce(Return(true));
+
+		EXPECT_CALL(*proxy, poll(_, _, _, _)).WillRepeatedly(SetArgReferee<2>(true));
+	}
+
+	connection.receive_tasks();
+}
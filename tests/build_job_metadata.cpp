@@ -34,6 +34,7 @@ TEST(job_metadata, build_all_from_yaml)
 							   "          stderr: before_stderr_${RESULT_DIR}_after_stderr\n"
 							   "          output: true\n"
 							   "          chdir: ${EVAL_DIR}\n"
+							   "          batch: tests\n"
 							   "          limits:\n"
 							   "              - hw-group-id: group1\n"
 							   "                time: 5\n"
@@ -93,6 +94,7 @@ TEST(job_metadata, build_all_from_yaml)
 	EXPECT_EQ(sandbox->std_error, "before_stderr_${RESULT_DIR}_after_stderr");
 	EXPECT_EQ(sandbox->output, true);
 	EXPECT_EQ(sandbox->chdir, "${EVAL_DIR}");
+	EXPECT_EQ(sandbox->batch, "tests");
 
 	EXPECT_EQ(1u, limits->environ_vars.size());
 	auto envs = std::pair<std::string, std::string>{"ISOLATE_TMP", "/tmp"};
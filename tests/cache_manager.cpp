@@ -52,6 +52,26 @@ TEST(CacheManager, GetExistingFile)
 	fs::remove_all(tmp / "recodex");
 }
 
+TEST(CacheManager, OpenFile)
+{
+	auto tmp = fs::temp_directory_path();
+	fs::create_directory(tmp / "recodex");
+	{
+		ofstream file((tmp / "recodex" / "test.txt").string());
+		file << "testing input" << endl;
+	}
+	cache_manager m((tmp / "recodex").string());
+
+	auto input = m.open_file("test.txt");
+	std::string line;
+	ASSERT_TRUE(static_cast<bool>(std::getline(*input, line)));
+	EXPECT_EQ("testing input", line);
+
+	EXPECT_THROW(m.open_file("nonexisting.txt"), fm_exception);
+
+	fs::remove_all(tmp / "recodex");
+}
+
 TEST(CacheManager, GetNonexistingFile)
 {
 	auto tmp = fs::temp_directory_path();
@@ -82,3 +102,93 @@ TEST(CacheManager, PutNonexistingFile)
 	EXPECT_THROW(m.put_file((tmp / "as4df.txt").string(), "as4df.txt"), fm_exception);
 	fs::remove_all((tmp / "recodex").string());
 }
+
+TEST(CacheManager, PutSameContentStoredOnce)
+{
+	auto tmp = fs::temp_directory_path();
+	auto cache = tmp / "recodex";
+	{
+		ofstream file((tmp / "test.txt").string());
+		file << "testing input" << endl;
+	}
+	cache_manager m(cache.string());
+	m.put_file((tmp / "test.txt").string(), "first.txt");
+	m.put_file((tmp / "test.txt").string(), "second.txt");
+
+	// both names refer to a single object named by digest of the content
+	EXPECT_TRUE(fs::equivalent(cache / "first.txt", cache / "second.txt"));
+	EXPECT_TRUE(fs::is_regular_file(cache / "objects" / "29a629cc616e51d081869ca3b51cac5a59367a59"));
+	EXPECT_EQ(fs::file_size(tmp / "test.txt"), m.get_size());
+
+	m.get_file("second.txt", (tmp / "copy.txt").string());
+	EXPECT_EQ(fs::file_size(tmp / "test.txt"), fs::file_size(tmp / "copy.txt"));
+
+	// index is rebuilt from the disk by another instance
+	cache_manager n(cache.string());
+	EXPECT_EQ(m.get_size(), n.get_size());
+
+	fs::remove(tmp / "test.txt");
+	fs::remove(tmp / "copy.txt");
+	fs::remove_all(cache);
+}
+
+TEST(CacheManager, EvictLeastRecentlyUsed)
+{
+	auto tmp = fs::temp_directory_path();
+	auto cache = tmp / "recodex";
+	fs::create_directory(cache);
+	// file stored by older worker directly in the cache directory
+	{
+		ofstream file((cache / "old.txt").string());
+		file << string(100, 'a');
+	}
+	fs::last_write_time(cache / "old.txt", std::time(nullptr) - 1000);
+
+	cache_manager m(cache.string(), nullptr, 250);
+	EXPECT_EQ(100u, m.get_size());
+
+	for (auto content : {'b', 'c'}) {
+		{
+			ofstream file((tmp / "test.txt").string());
+			file << string(100, content);
+		}
+		m.put_file((tmp / "test.txt").string(), string(1, content) + ".txt");
+	}
+
+	// the oldest file does not fit into the limit anymore
+	EXPECT_FALSE(fs::exists(cache / "old.txt"));
+	EXPECT_TRUE(fs::is_regular_file(cache / "b.txt"));
+	EXPECT_TRUE(fs::is_regular_file(cache / "c.txt"));
+	EXPECT_EQ(200u, m.get_size());
+	EXPECT_THROW(m.get_file("old.txt", (tmp / "copy.txt").string()), fm_exception);
+
+	fs::remove(tmp / "test.txt");
+	fs::remove_all(cache);
+}
+
+TEST(CacheManager, GetFileAsHardlink)
+{
+	auto tmp = fs::temp_directory_path();
+	auto cache = tmp / "recodex";
+	{
+		ofstream file((tmp / "test.txt").string());
+		file << "testing input" << endl;
+	}
+	cache_manager m(cache.string(), nullptr, 0, true);
+	m.put_file((tmp / "test.txt").string(), "test.txt");
+	m.get_file("test.txt", (tmp / "copy.txt").string());
+	EXPECT_EQ(fs::file_size(tmp / "test.txt"), fs::file_size(tmp / "copy.txt"));
+
+	// shared file must not be writable, otherwise the task could change content of the cache
+	if (fs::equivalent(cache / "test.txt", tmp / "copy.txt")) {
+		EXPECT_EQ(fs::perms::no_perms, fs::status(tmp / "copy.txt").permissions() & fs::perms::owner_write);
+	}
+
+	// fetching again replaces the link and does not write through it into the cache
+	m.get_file("test.txt", (tmp / "copy.txt").string());
+	EXPECT_EQ(fs::file_size(tmp / "test.txt"), fs::file_size(cache / "test.txt"));
+
+	fs::remove(tmp / "test.txt");
+	fs::remove(tmp / "copy.txt");
+	fs::remove_all(cache);
+}
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <fstream>
+
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+#define BOOST_NO_CXX11_SCOPED_ENUMS
+#include <boost/filesystem.hpp>
+
+#include "sandbox/cgroup_stats.h"
+
+namespace fs = boost::filesystem;
+using namespace testing;
+
+
+class cgroup_stats_test : public ::testing::Test
+{
+protected:
+	fs::path dir_;
+
+	void SetUp() override
+	{
+		dir_ = fs::temp_directory_path() / fs::unique_path("recodex_cgroup_stats_test_%%%%-%%%%");
+		fs::create_directories(dir_);
+	}
+
+	void TearDown() override
+	{
+		fs::remove_all(dir_);
+	}
+
+	void write(const std::string &name, const std::string &content)
+	{
+		std::ofstream file((dir_ / name).string());
+		file << content;
+	}
+};
+
+TEST_F(cgroup_stats_test, entries)
+{
+	std::vector<std::string> entries;
+	cgroup_stats::for_each_entry("time:0.012\nmessage:Exited with error status 1\nkilled\nexitcode:1",
+		':',
+		[&entries](const char *key, std::size_t length, const char *value, std::size_t value_length) {
+			entries.push_back(std::string(key, length) + "=" + std::string(value, value_length));
+		});
+
+	ASSERT_THAT(entries, ElementsAre("time=0.012", "message=Exited with error status 1", "exitcode=1"));
+}
+
+TEST_F(cgroup_stats_test, read_box_stats)
+{
+	write("cpu.stat",
+		"usage_usec 1250\nuser_usec 1000\nsystem_usec 250\nnr_periods 10\nnr_throttled 3\nthrottled_usec 1500000\n");
+	write("memory.peak", "2097152\n");
+	write("memory.events", "low 0\nhigh 0\nmax 2\noom 1\noom_kill 1\n");
+	write("io.stat", "8:0 rbytes=4096 wbytes=100 rios=1 wios=1 dbytes=0 dios=0\n8:16 rbytes=1024 wbytes=0\n");
+
+	sandbox_results results;
+	ASSERT_TRUE(cgroup_stats::read_box_stats(dir_.string(), results));
+	ASSERT_TRUE(results.cgroup_stats);
+	ASSERT_EQ((std::size_t) 3, results.throttled);
+	ASSERT_FLOAT_EQ(1.5, results.throttled_time);
+	ASSERT_EQ((std::size_t) 2048, results.memory_peak);
+	ASSERT_EQ((std::size_t) 1, results.oom_kills);
+	ASSERT_EQ((std::size_t) 5120, results.io_read);
+	ASSERT_EQ((std::size_t) 100, results.io_write);
+}
+
+TEST_F(cgroup_stats_test, missing_cgroup)
+{
+	sandbox_results results;
+	ASSERT_FALSE(cgroup_stats::read_box_stats((dir_ / "box-1").string(), results));
+	ASSERT_FALSE(results.cgroup_stats);
+	ASSERT_EQ((std::size_t) 0, results.memory_peak);
+}
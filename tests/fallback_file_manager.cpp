@@ -84,3 +84,26 @@ TEST(fallback_file_manager, PutOperationFailed)
 	fallback_file_manager m(move(cache), move(remote));
 	EXPECT_THROW(m.put_file(local_path, remote_path), fm_exception);
 }
+
+TEST(fallback_file_manager, GetFilesBatch)
+{
+	auto cache = unique_ptr<mock_file_manager>(new mock_file_manager);
+	auto remote = unique_ptr<mock_file_manager>(new StrictMock<mock_file_manager>);
+
+	// only files missing in cache are requested from remote and saved to cache afterwards
+	EXPECT_CALL((*cache), get_file("cached.txt", "/tmp/cached.txt")).Times(1);
+	EXPECT_CALL((*cache), get_file("remote.txt", "/tmp/remote.txt")).WillOnce(Throw(fm_exception("")));
+	EXPECT_CALL((*cache), get_file("missing.txt", "/tmp/missing.txt")).WillOnce(Throw(fm_exception("")));
+	EXPECT_CALL((*remote), get_file("remote.txt", "/tmp/remote.txt")).Times(1);
+	EXPECT_CALL((*remote), get_file("missing.txt", "/tmp/missing.txt")).WillOnce(Throw(fm_exception("")));
+	EXPECT_CALL((*cache), put_file("/tmp/remote.txt", "remote.txt")).Times(1);
+
+	fallback_file_manager m(move(cache), move(remote));
+	auto results = m.get_files({{"cached.txt", "/tmp/cached.txt"},
+		{"remote.txt", "/tmp/remote.txt"},
+		{"missing.txt", "/tmp/missing.txt"}});
+	ASSERT_EQ(3u, results.size());
+	EXPECT_EQ(nullptr, results[0]);
+	EXPECT_EQ(nullptr, results[1]);
+	EXPECT_NE(nullptr, results[2]);
+}
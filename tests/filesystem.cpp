@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <fstream>
 
 #include "helpers/filesystem.h"
 
+#ifndef _WIN32
+#include <sys/xattr.h>
+#endif
+
 typedef std::tuple<std::string, std::string, sandbox_limits::dir_perm> bound_dirs_tuple;
 typedef std::vector<bound_dirs_tuple> bound_dirs_type;
 
@@ -142,3 +147,117 @@ TEST(filesystem_test, test_absolute_8)
 		(fs::path("/path/outside/sandbox") / fs::path("test1") / fs::path("sub") / fs::path("output.stderr")).string(),
 		result.string());
 }
+
+TEST(filesystem_test, rename_directory_content)
+{
+	fs::path root = fs::temp_directory_path() / "recodex_rename_test";
+	fs::remove_all(root);
+	fs::create_directories(root / "src" / "sub");
+	fs::create_directories(root / "dest");
+	std::ofstream((root / "src" / "file").string()) << "hello";
+	std::ofstream((root / "src" / "sub" / "inner").string()) << "world!";
+
+	ASSERT_EQ((std::uintmax_t) 11, helpers::directory_size(root / "src"));
+	ASSERT_TRUE(helpers::rename_directory_content(root / "src", root / "dest"));
+	ASSERT_TRUE(fs::is_empty(root / "src"));
+	ASSERT_TRUE(fs::is_regular_file(root / "dest" / "file"));
+	ASSERT_TRUE(fs::is_regular_file(root / "dest" / "sub" / "inner"));
+	ASSERT_EQ((std::uintmax_t) 11, helpers::directory_size(root / "dest"));
+
+	fs::remove_all(root);
+}
+
+TEST(filesystem_test, copy_file)
+{
+	fs::path root = fs::temp_directory_path() / "recodex_copy_test";
+	fs::remove_all(root);
+	fs::create_directories(root);
+	std::ofstream((root / "src").string()) << std::string(100000, 'x');
+	fs::permissions(root / "src", fs::perms::owner_read | fs::perms::owner_exe);
+	std::ofstream((root / "dest").string()) << "old content";
+
+	// existing destination is replaced, the source is never hardlinked unless allowed
+	auto strategy = helpers::copy_file(root / "src", root / "dest");
+	ASSERT_NE(helpers::copy_strategy::HARDLINK, strategy);
+	ASSERT_FALSE(fs::equivalent(root / "src", root / "dest"));
+	ASSERT_EQ((std::uintmax_t) 100000, fs::file_size(root / "dest"));
+	ASSERT_EQ(fs::status(root / "src").permissions(), fs::status(root / "dest").permissions());
+
+	// reflink is preferred, hardlink is used only where reflinks are not supported
+	strategy = helpers::copy_file(root / "src", root / "link", true);
+	ASSERT_EQ(strategy == helpers::copy_strategy::HARDLINK, fs::equivalent(root / "src", root / "link"));
+	ASSERT_EQ((std::uintmax_t) 100000, fs::file_size(root / "link"));
+
+	ASSERT_THROW(helpers::copy_file(root / "nonexisting", root / "dest"), helpers::filesystem_exception);
+	ASSERT_THROW(helpers::copy_file(root / "src", root / "nonexisting" / "dest"), helpers::filesystem_exception);
+
+	fs::remove_all(root);
+}
+
+#ifndef _WIN32
+TEST(filesystem_test, grant_user_access)
+{
+	fs::path root = fs::temp_directory_path() / "recodex_acl_test";
+	fs::remove_all(root);
+	fs::create_directories(root / "sub");
+	std::ofstream((root / "sub" / "file").string()) << "hello";
+	fs::permissions(root / "sub" / "file", fs::perms::owner_read | fs::perms::owner_write);
+	std::ofstream((root / "shared").string()) << "cached";
+	fs::permissions(root / "shared", fs::perms::owner_read | fs::perms::others_read);
+	fs::create_hard_link(root / "shared", root / "link");
+
+	try {
+		ASSERT_EQ(0u, helpers::grant_user_access(root, 65000));
+	} catch (helpers::filesystem_exception &) {
+		// filesystem of temporary directory does not support ACLs
+		fs::remove_all(root);
+		return;
+	}
+
+	// mode of the files is kept, the group class permissions reflect the mask of the ACL
+	ASSERT_EQ(fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read | fs::perms::group_write,
+		fs::status(root / "sub" / "file").permissions());
+	ASSERT_TRUE((fs::status(root / "sub").permissions() & fs::perms::group_exe) != fs::perms::no_perms);
+
+	// hardlinked files are left untouched
+	ASSERT_EQ(fs::perms::owner_read | fs::perms::others_read, fs::status(root / "link").permissions());
+
+	// new items inherit the entry from their directory, but their mode limits it until the tree is processed again
+	std::ofstream((root / "sub" / "new").string()) << "created later";
+	fs::permissions(root / "sub" / "new", fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read);
+	ASSERT_GT(getxattr((root / "sub" / "new").c_str(), "system.posix_acl_access", nullptr, 0), 0);
+	ASSERT_EQ(0u, helpers::grant_user_access(root, 65000));
+	ASSERT_EQ(fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read | fs::perms::group_write,
+		fs::status(root / "sub" / "new").permissions());
+
+	// another user gets the access as well, the entry of the first one is kept
+	ASSERT_EQ(0u, helpers::grant_user_access(root, 65001));
+	ASSERT_EQ(0u, helpers::grant_user_access(root, 65000));
+
+	ASSERT_THROW(helpers::grant_user_access(root / "nonexisting", 65000), helpers::filesystem_exception);
+
+	fs::remove_all(root);
+}
+#endif
+
+TEST(filesystem_test, unshare_file)
+{
+	fs::path root = fs::temp_directory_path() / "recodex_unshare_test";
+	fs::remove_all(root);
+	fs::create_directories(root);
+	std::ofstream((root / "file").string()) << "cached";
+	fs::permissions(root / "file", fs::perms::owner_read | fs::perms::group_read);
+
+	ASSERT_FALSE(helpers::unshare_file(root / "file"));
+	ASSERT_FALSE(helpers::unshare_file(root / "nonexisting"));
+
+	fs::create_hard_link(root / "file", root / "link");
+	ASSERT_TRUE(helpers::unshare_file(root / "link"));
+	ASSERT_FALSE(fs::equivalent(root / "file", root / "link"));
+	ASSERT_EQ((std::uintmax_t) 1, fs::hard_link_count(root / "file"));
+	ASSERT_EQ((std::uintmax_t) 6, fs::file_size(root / "link"));
+	ASSERT_EQ(fs::status(root / "file").permissions(), fs::status(root / "link").permissions());
+	ASSERT_FALSE(fs::exists(root / "link.unshare"));
+
+	fs::remove_all(root);
+}
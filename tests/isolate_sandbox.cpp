@@ -182,5 +182,49 @@ TEST(IsolateSandbox, BindDirsExecuteGCC)
 	fs::remove_all(tmp / "recodex_35_test");
 }
 
+TEST(IsolateSandbox, BoxPool)
+{
+	std::shared_ptr<sandbox_config> config = std::make_shared<sandbox_config>();
+	sandbox_limits limits;
+	auto pool = std::make_shared<isolate_box_pool>(40, 2);
+	{
+		isolate_sandbox first(config, limits, 34, "/tmp", "", nullptr, pool);
+		isolate_sandbox second(config, limits, 34, "/tmp", "", nullptr, pool);
+		EXPECT_NE(first.get_dir(), second.get_dir());
+		EXPECT_EQ(first.get_dir().find("/var/local/lib/isolate/4"), 0u);
+	}
+	EXPECT_EQ(pool->get_hits() + pool->get_misses(), 2u);
+
+	// released boxes are reset in background and handed out again
+	isolate_sandbox third(config, limits, 34, "/tmp", "", nullptr, pool);
+	EXPECT_EQ(pool->get_hits() + pool->get_misses(), 3u);
+}
+
+TEST(IsolateSandbox, BoxPoolBatch)
+{
+	std::shared_ptr<sandbox_config> config = std::make_shared<sandbox_config>();
+	sandbox_limits limits;
+	auto pool = std::make_shared<isolate_box_pool>(42, 1);
+	std::string dir;
+	{
+		isolate_sandbox first(config, limits, 34, "/tmp", "", nullptr, pool, sandbox_data_mode::COPY, "", "tests");
+		dir = first.get_dir();
+		std::ofstream((fs::path(dir) / "01.out").string()) << "output";
+	}
+
+	// box of the batch is reused without reset, only its files are removed
+	{
+		isolate_sandbox second(config, limits, 34, "/tmp", "", nullptr, pool, sandbox_data_mode::COPY, "", "tests");
+		EXPECT_EQ(second.get_dir(), dir);
+		EXPECT_FALSE(fs::exists(fs::path(dir) / "01.out"));
+		EXPECT_EQ(pool->get_reuses(), 1u);
+	}
+
+	// parked box is taken over by a task outside of the batch
+	isolate_sandbox third(config, limits, 34, "/tmp", "", nullptr, pool);
+	EXPECT_EQ(third.get_dir(), dir);
+	EXPECT_EQ(pool->get_reuses(), 1u);
+}
+
 
 #endif
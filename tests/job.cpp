@@ -1,8 +1,11 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <future>
 #include <iostream>
 #include <fstream>
 #include <type_traits>
+#include <atomic>
+#include <thread>
 
 #define BOOST_FILESYSTEM_NO_DEPRECATED
 #define BOOST_NO_CXX11_SCOPED_ENUMS
@@ -623,10 +626,270 @@ TEST(job_test, correctly_executed_job)
 	// and run it!...
 	result.run();
 
+	// duration of each executed task is measured
+	ASSERT_EQ((std::size_t) 1, failed_results->timings.size());
+	EXPECT_EQ("total", failed_results->timings[0].first);
+
 	// cleanup after yourself
 	remove_all(dir_root);
 }
 
+TEST(job_test, parallel_executed_job)
+{
+	// prepare all things which need to be prepared
+	path dir_root = temp_directory_path() / "isoeval";
+	path dir = dir_root / "job_test";
+
+	auto job_meta = get_correct_meta();
+
+	/*
+	 * TASK TREE:
+	 *
+	 *      A
+	 *     / \
+	 *    B   D _
+	 *     \ /  \\
+	 *      C   E F
+	 *             \
+	 *              G
+	 *
+	 * Executed with three slots, B, E and F can run at the same time.
+	 *
+	 * progress_callback: F will fail, G will be skipped
+	 */
+	job_meta->tasks.clear();
+	job_meta->tasks.push_back(get_simple_task("A", 1, {}));
+	job_meta->tasks.push_back(get_simple_task("B", 4, {"A"}));
+	job_meta->tasks.push_back(get_simple_task("C", 6, {"B", "D"}));
+	job_meta->tasks.push_back(get_simple_task("D", 2, {"A"}));
+	job_meta->tasks.push_back(get_simple_task("E", 5, {"D"}));
+	job_meta->tasks.push_back(get_simple_task("F", 3, {"D"}));
+	job_meta->tasks.push_back(get_simple_task("G", 7, {"F"}));
+
+	std::size_t tasks_count = job_meta->tasks.size() + 1;
+
+	auto worker_conf = std::make_shared<mock_worker_config>();
+	auto default_limits = get_default_limits();
+	std::string group_name = "group1";
+	EXPECT_CALL((*worker_conf), get_hwgroup()).WillRepeatedly(ReturnRef(group_name));
+	EXPECT_CALL((*worker_conf), get_worker_id()).WillRepeatedly(Return(8));
+	EXPECT_CALL((*worker_conf), get_limits()).WillRepeatedly(ReturnRef(default_limits));
+	EXPECT_CALL((*worker_conf), get_max_parallel_tasks()).WillRepeatedly(Return(3));
+
+	auto progress_callback = std::make_shared<mock_progress_callback>();
+	auto factory = std::make_shared<mock_task_factory>();
+	std::vector<std::shared_ptr<mock_task>> mock_tasks;
+	auto empty_task = std::make_shared<mock_task>();
+	auto failed_results = std::make_shared<task_results>();
+	failed_results->status = task_status::FAILED;
+
+	for (std::size_t i = 1; i < tasks_count; i++) {
+		mock_tasks.push_back(std::make_shared<mock_task>(i, job_meta->tasks[i - 1]));
+	}
+	{
+		InSequence s;
+		// expect root task to be created
+		EXPECT_CALL((*factory), create_internal_task(0, _)).WillOnce(Return(empty_task));
+
+		for (std::size_t i = 1; i < tasks_count; i++) {
+			// expect tasks A to G to be created
+			EXPECT_CALL((*factory), create_internal_task(i, job_meta->tasks[i - 1]))
+				.WillOnce(Return(mock_tasks[i - 1]));
+		}
+	}
+
+	// order of the task callbacks depends on thread scheduling
+	EXPECT_CALL(*progress_callback, job_started(_)).Times(1);
+	EXPECT_CALL(*progress_callback, task_completed(_, _)).Times(5);
+	EXPECT_CALL(*progress_callback, task_failed(_, "F")).Times(1);
+	EXPECT_CALL(*progress_callback, task_skipped(_, "G")).Times(1);
+	EXPECT_CALL(*progress_callback, job_ended(_)).Times(1);
+
+	for (std::size_t i = 1; i < tasks_count - 2; i++) {
+		// expect tasks A to E will be executed each at once, results of parallel tasks are distinct objects
+		EXPECT_CALL(*mock_tasks[i - 1], run()).WillOnce(Return(std::make_shared<task_results>()));
+	}
+	// task F will fail and G will not be executed
+	EXPECT_CALL(*mock_tasks[tasks_count - 3], run()).WillOnce(Return(failed_results));
+	EXPECT_CALL(*mock_tasks[tasks_count - 2], run()).Times(0);
+
+	create_directories(dir);
+	std::ofstream hello((dir / "hello").string());
+	hello << "hello" << std::endl;
+	hello.close();
+
+	// construct
+	job result(job_meta, worker_conf, dir_root, dir, temp_directory_path(), factory, progress_callback);
+
+	// and run it!...
+	auto results = result.run();
+
+	// results are in the order of the task queue
+	auto &queue = result.get_task_queue();
+	ASSERT_EQ(queue.size(), results.size());
+	for (std::size_t i = 0; i < queue.size(); i++) {
+		EXPECT_EQ(queue[i]->get_task_id(), results[i].first);
+		if (results[i].first == "G") { EXPECT_EQ(task_status::SKIPPED, results[i].second->status); }
+	}
+
+	// cleanup after yourself
+	remove_all(dir_root);
+}
+
+TEST(job_test, running_task_behind_fatal_failure)
+{
+	path dir_root = temp_directory_path() / "isoeval";
+	path dir = dir_root / "job_test";
+
+	/*
+	 * B and C run at the same time after A, B fails fatally while C is still running,
+	 * so C is behind the fatal failure and it is neither reported nor in the results.
+	 */
+	auto job_meta = get_correct_meta();
+	job_meta->tasks.clear();
+	job_meta->tasks.push_back(get_simple_task("A", 1, {}));
+	job_meta->tasks.push_back(get_simple_task("B", 3, {"A"}));
+	job_meta->tasks.push_back(get_simple_task("C", 2, {"A"}));
+	job_meta->tasks[1]->fatal_failure = true;
+
+	auto worker_conf = std::make_shared<mock_worker_config>();
+	auto default_limits = get_default_limits();
+	std::string group_name = "group1";
+	EXPECT_CALL((*worker_conf), get_hwgroup()).WillRepeatedly(ReturnRef(group_name));
+	EXPECT_CALL((*worker_conf), get_worker_id()).WillRepeatedly(Return(8));
+	EXPECT_CALL((*worker_conf), get_limits()).WillRepeatedly(ReturnRef(default_limits));
+	EXPECT_CALL((*worker_conf), get_max_parallel_tasks()).WillRepeatedly(Return(2));
+
+	auto progress_callback = std::make_shared<mock_progress_callback>();
+	auto factory = std::make_shared<mock_task_factory>();
+	auto failed_results = std::make_shared<task_results>();
+	failed_results->status = task_status::FAILED;
+	EXPECT_CALL((*factory), create_internal_task(0, _)).WillOnce(Return(std::make_shared<mock_task>()));
+
+	std::vector<std::shared_ptr<mock_task>> mock_tasks;
+	for (std::size_t i = 1; i <= job_meta->tasks.size(); i++) {
+		mock_tasks.push_back(std::make_shared<mock_task>(i, job_meta->tasks[i - 1]));
+		EXPECT_CALL((*factory), create_internal_task(i, job_meta->tasks[i - 1])).WillOnce(Return(mock_tasks.back()));
+	}
+
+	// C finishes only after the failure of B is processed
+	std::promise<void> failed;
+	auto failed_future = failed.get_future().share();
+	EXPECT_CALL(*mock_tasks[0], run()).WillOnce(Return(std::make_shared<task_results>()));
+	EXPECT_CALL(*mock_tasks[1], run()).WillOnce(Return(failed_results));
+	EXPECT_CALL(*mock_tasks[2], run()).WillOnce(InvokeWithoutArgs([failed_future]() {
+		failed_future.wait();
+		return std::make_shared<task_results>();
+	}));
+
+	EXPECT_CALL(*progress_callback, job_started(_)).Times(1);
+	EXPECT_CALL(*progress_callback, task_completed(_, "A")).Times(1);
+	EXPECT_CALL(*progress_callback, task_failed(_, "B")).WillOnce(InvokeWithoutArgs([&failed]() {
+		failed.set_value();
+	}));
+	EXPECT_CALL(*progress_callback, task_completed(_, "C")).Times(0);
+	EXPECT_CALL(*progress_callback, job_ended(_)).Times(1);
+
+	create_directories(dir);
+	job result(job_meta, worker_conf, dir_root, dir, temp_directory_path(), factory, progress_callback);
+
+	// B is in front of C in the task queue
+	auto &queue = result.get_task_queue();
+	ASSERT_EQ(3u, queue.size());
+	ASSERT_EQ("B", queue[1]->get_task_id());
+	ASSERT_EQ("C", queue[2]->get_task_id());
+
+	auto results = result.run();
+	ASSERT_EQ(2u, results.size());
+	EXPECT_EQ("B", results[1].first);
+
+	remove_all(dir_root);
+}
+
+/**
+ * Task running on top of an overlay of the evaluation directory.
+ */
+class overlaid_mock_task : public mock_task
+{
+public:
+	overlaid_mock_task(std::size_t id, std::shared_ptr<task_metadata> meta) : mock_task(id, meta)
+	{
+	}
+
+	bool is_overlaid() override
+	{
+		return true;
+	}
+};
+
+TEST(job_test, overlaid_tasks_run_apart)
+{
+	path dir_root = temp_directory_path() / "isoeval";
+	path dir = dir_root / "job_test";
+
+	/*
+	 * A is followed by overlaid B, C, E and ordinary D, which may write into evaluation directory,
+	 * so D never runs together with any of the overlaid tasks.
+	 */
+	auto job_meta = get_correct_meta();
+	job_meta->tasks.clear();
+	job_meta->tasks.push_back(get_simple_task("A", 1, {}));
+	job_meta->tasks.push_back(get_simple_task("B", 2, {"A"}));
+	job_meta->tasks.push_back(get_simple_task("C", 3, {"A"}));
+	job_meta->tasks.push_back(get_simple_task("D", 4, {"A"}));
+	job_meta->tasks.push_back(get_simple_task("E", 5, {"A"}));
+
+	auto worker_conf = std::make_shared<mock_worker_config>();
+	auto default_limits = get_default_limits();
+	std::string group_name = "group1";
+	EXPECT_CALL((*worker_conf), get_hwgroup()).WillRepeatedly(ReturnRef(group_name));
+	EXPECT_CALL((*worker_conf), get_worker_id()).WillRepeatedly(Return(8));
+	EXPECT_CALL((*worker_conf), get_limits()).WillRepeatedly(ReturnRef(default_limits));
+	EXPECT_CALL((*worker_conf), get_max_parallel_tasks()).WillRepeatedly(Return(4));
+
+	auto progress_callback = std::make_shared<NiceMock<mock_progress_callback>>();
+	auto factory = std::make_shared<mock_task_factory>();
+	auto empty_results = std::make_shared<task_results>();
+	EXPECT_CALL((*factory), create_internal_task(0, _)).WillOnce(Return(std::make_shared<mock_task>()));
+
+	std::atomic<int> overlaid_running(0);
+	std::atomic<int> others_running(0);
+	std::atomic<bool> mixed(false);
+	auto run_as = [&](std::atomic<int> &mine, std::atomic<int> &others) {
+		++mine;
+		if (others > 0) { mixed = true; }
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		if (others > 0) { mixed = true; }
+		--mine;
+		return empty_results;
+	};
+
+	std::vector<std::shared_ptr<mock_task>> mock_tasks;
+	for (std::size_t i = 1; i <= job_meta->tasks.size(); i++) {
+		auto &meta = job_meta->tasks[i - 1];
+		bool overlaid = meta->task_id != "A" && meta->task_id != "D";
+		std::shared_ptr<mock_task> task;
+		if (overlaid) {
+			task = std::make_shared<overlaid_mock_task>(i, meta);
+			EXPECT_CALL(*task, run()).WillOnce(Invoke([&]() { return run_as(overlaid_running, others_running); }));
+		} else {
+			task = std::make_shared<mock_task>(i, meta);
+			EXPECT_CALL(*task, run()).WillOnce(Invoke([&]() { return run_as(others_running, overlaid_running); }));
+		}
+		EXPECT_CALL((*factory), create_internal_task(i, meta)).WillOnce(Return(task));
+		mock_tasks.push_back(task);
+	}
+
+	create_directories(dir);
+	job result(job_meta, worker_conf, dir_root, dir, temp_directory_path(), factory, progress_callback);
+	auto results = result.run();
+
+	ASSERT_EQ(job_meta->tasks.size(), results.size());
+	ASSERT_FALSE(mixed);
+
+	remove_all(dir_root);
+}
+
 /**
  * Internal error means error in execution of inner task.
  * These errors can be possibly only "localy" place
@@ -204,6 +204,9 @@ TEST(job_config_test, config_data)
 						   "          carboncopy-stderr: carbon-copy-stderr\n"
 						   "          chdir: /eval\n"
 						   "          working-directory: working\n"
+						   "          output-files:\n"
+						   "              - result.txt\n"
+						   "              - /box/log.txt\n"
 						   "          limits:\n"
 						   "              - hw-group-id: group1\n"
 						   "                time: 5\n"
@@ -263,6 +266,9 @@ TEST(job_config_test, config_data)
 	ASSERT_EQ(task2->sandbox->carboncopy_stderr, "carbon-copy-stderr");
 	ASSERT_EQ(task2->sandbox->chdir, "/eval");
 	ASSERT_EQ(task2->sandbox->working_directory, "working");
+	ASSERT_EQ(task2->sandbox->output_files.size(), 2u);
+	ASSERT_EQ(task2->sandbox->output_files[0], "result.txt");
+	ASSERT_EQ(task2->sandbox->output_files[1], "/box/log.txt");
 
 	ASSERT_EQ(task2->sandbox->loaded_limits.size(), 2u);
 	EXPECT_NO_THROW(task2->sandbox->loaded_limits.at("group1"));
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <zmq.hpp>
+#include <thread>
+
+#include "job/job_dispatcher.h"
+#include "connection_proxy.h"
+#include "helpers/zmq_socket.h"
+
+using namespace testing;
+
+
+TEST(job_dispatcher, distributes_jobs)
+{
+	auto context = std::make_shared<zmq::context_t>(1);
+	zmq::socket_t broker(*context, ZMQ_PAIR);
+	broker.bind("inproc://" + JOB_SOCKET_ID);
+
+	job_dispatcher dispatcher(context, 2, nullptr);
+	std::thread d([&dispatcher]() { dispatcher.start_dispatching(); });
+
+	zmq::socket_t first(*context, ZMQ_PAIR);
+	first.connect("inproc://" + job_dispatcher::get_slot_socket_id(0));
+	zmq::socket_t second(*context, ZMQ_PAIR);
+	second.connect("inproc://" + job_dispatcher::get_slot_socket_id(1));
+
+	std::vector<std::string> message;
+
+	// idle slots get the jobs first
+	helpers::send_through_socket(broker, {"eval", "1", "job_url", "result_url"});
+	ASSERT_TRUE(helpers::recv_from_socket(first, message));
+	ASSERT_THAT(message, ElementsAre("eval", "1", "job_url", "result_url"));
+
+	helpers::send_through_socket(broker, {"eval", "2", "job_url", "result_url"});
+	ASSERT_TRUE(helpers::recv_from_socket(second, message));
+	ASSERT_THAT(message, ElementsAre("eval", "2", "job_url", "result_url"));
+
+	// reply of a slot is passed to broker connection and the slot gets the next job
+	helpers::send_through_socket(second, {"done", "2", "OK", ""});
+	ASSERT_TRUE(helpers::recv_from_socket(broker, message));
+	ASSERT_THAT(message, ElementsAre("done", "2", "OK", ""));
+
+	helpers::send_through_socket(broker, {"eval", "3", "job_url", "result_url"});
+	ASSERT_TRUE(helpers::recv_from_socket(second, message));
+	ASSERT_THAT(message, ElementsAre("eval", "3", "job_url", "result_url"));
+
+	broker.close();
+	first.close();
+	second.close();
+	context->close();
+	d.join();
+}
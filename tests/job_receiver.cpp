@@ -3,11 +3,13 @@
 #include <zmq.hpp>
 #include <thread>
 #include <chrono>
+#include <future>
 
 #include "mocks.h"
 #include "job/job_receiver.h"
 #include "eval_request.h"
 #include "connection_proxy.h"
+#include "helpers/zmq_socket.h"
 
 using namespace testing;
 
@@ -90,3 +92,115 @@ TEST(job_receiver, incomplete_msg)
 	context->close();
 	r.join();
 }
+
+TEST(job_receiver, requested_result_format)
+{
+	auto context = std::make_shared<zmq::context_t>(1);
+	zmq::socket_t socket(*context, ZMQ_PAIR);
+	socket.bind("inproc://" + JOB_SOCKET_ID);
+
+	auto evaluator = std::make_shared<StrictMock<mock_job_evaluator>>();
+	std::promise<void> evaluated;
+
+	EXPECT_CALL(*evaluator,
+		evaluate(AllOf(Field(&eval_request::job_id, StrEq("eval_123")),
+			Field(&eval_request::result_format, StrEq("tar.zst")))))
+		.WillOnce(DoAll(InvokeWithoutArgs([&evaluated]() { evaluated.set_value(); }),
+			Return(eval_response("eval_123", "OK"))));
+
+	job_receiver receiver(context, evaluator, nullptr);
+	std::thread r([&receiver]() { receiver.start_receiving(); });
+
+	helpers::send_through_socket(socket, {"eval", "eval_123", "job_url", "result_url", "tar.zst"});
+
+	ASSERT_EQ(std::future_status::ready, evaluated.get_future().wait_for(std::chrono::seconds(5)));
+	std::vector<std::string> reply;
+	ASSERT_TRUE(helpers::recv_from_socket(socket, reply));
+	ASSERT_THAT(reply, ElementsAre("done", "eval_123", "OK", ""));
+
+	context->close();
+	r.join();
+}
+
+TEST(job_receiver, prefetch_next_job)
+{
+	auto context = std::make_shared<zmq::context_t>(1);
+	zmq::socket_t socket(*context, ZMQ_PAIR);
+	socket.bind("inproc://" + JOB_SOCKET_ID);
+
+	auto evaluator = std::make_shared<StrictMock<mock_job_evaluator>>();
+
+	// evaluation of the first job lasts until the second job is prefetched
+	std::promise<void> prefetched;
+	auto prefetched_future = prefetched.get_future().share();
+
+	{
+		InSequence s;
+
+		EXPECT_CALL(*evaluator, evaluate(Field(&eval_request::job_id, StrEq("job_1"))))
+			.WillOnce(InvokeWithoutArgs([prefetched_future]() {
+				prefetched_future.wait();
+				return eval_response("job_1", "OK");
+			}));
+		EXPECT_CALL(*evaluator, evaluate(Field(&eval_request::job_id, StrEq("job_2"))))
+			.WillOnce(Return(eval_response("job_2", "OK")));
+	}
+	EXPECT_CALL(*evaluator,
+		prefetch(AllOf(Field(&eval_request::job_id, StrEq("job_2")), Field(&eval_request::job_url, StrEq("url_2")))))
+		.WillOnce(InvokeWithoutArgs([&prefetched]() { prefetched.set_value(); }));
+
+	job_receiver receiver(context, evaluator, nullptr, true);
+	std::thread r([&receiver]() { receiver.start_receiving(); });
+
+	helpers::send_through_socket(socket, {"eval", "job_1", "url_1", "result_1"});
+	helpers::send_through_socket(socket, {"eval", "job_2", "url_2", "result_2"});
+
+	std::vector<std::string> message;
+	ASSERT_TRUE(helpers::recv_from_socket(socket, message));
+	ASSERT_EQ(std::vector<std::string>({"done", "job_1", "OK", ""}), message);
+	ASSERT_TRUE(helpers::recv_from_socket(socket, message));
+	ASSERT_EQ(std::vector<std::string>({"done", "job_2", "OK", ""}), message);
+
+	context->close();
+	r.join();
+}
+
+/**
+ * Evaluator which leaves the upload of results to the background.
+ */
+class mock_async_job_evaluator : public mock_job_evaluator
+{
+public:
+	MOCK_METHOD1(evaluate_async, std::shared_future<eval_response>(eval_request));
+};
+
+TEST(job_receiver, done_after_upload)
+{
+	auto context = std::make_shared<zmq::context_t>(1);
+	zmq::socket_t socket(*context, ZMQ_PAIR);
+	socket.bind("inproc://" + JOB_SOCKET_ID);
+
+	// evaluation ends right away, but the results are uploaded later
+	std::promise<eval_response> uploaded;
+	auto response = uploaded.get_future().share();
+	auto evaluator = std::make_shared<StrictMock<mock_async_job_evaluator>>();
+	EXPECT_CALL(*evaluator, evaluate_async(Field(&eval_request::job_id, StrEq("job_1")))).WillOnce(Return(response));
+
+	job_receiver receiver(context, evaluator, nullptr);
+	std::thread r([&receiver]() { receiver.start_receiving(); });
+
+	helpers::send_through_socket(socket, {"eval", "job_1", "url_1", "result_1"});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	zmq::message_t msg;
+	ASSERT_FALSE(socket.recv(&msg, ZMQ_NOBLOCK));
+
+	uploaded.set_value(eval_response("job_1", "OK"));
+
+	std::vector<std::string> message;
+	ASSERT_TRUE(helpers::recv_from_socket(socket, message));
+	ASSERT_EQ(std::vector<std::string>({"done", "job_1", "OK", ""}), message);
+
+	context->close();
+	r.join();
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "helpers/metrics.h"
+
+using namespace testing;
+
+
+TEST(metrics_test, counter_and_gauge)
+{
+	helpers::metric_counter counter;
+	counter.add();
+	counter.add(41);
+	ASSERT_EQ((std::uint64_t) 42, counter.get());
+
+	helpers::metric_gauge gauge;
+	gauge.set(3);
+	gauge.add(-5);
+	ASSERT_EQ(-2, gauge.get());
+}
+
+TEST(metrics_test, histogram_buckets)
+{
+	helpers::metric_histogram histogram;
+	histogram.observe(0.0005);
+	histogram.observe(0.001);
+	histogram.observe(0.3);
+	histogram.observe(120);
+
+	ASSERT_EQ((std::uint64_t) 2, histogram.get_bucket(0));
+	ASSERT_EQ((std::uint64_t) 0, histogram.get_bucket(1));
+	ASSERT_EQ((std::uint64_t) 1, histogram.get_bucket(6));
+	ASSERT_EQ((std::uint64_t) 1, histogram.get_bucket(helpers::metric_histogram::bucket_count));
+	ASSERT_EQ((std::uint64_t) 4, histogram.get_count());
+	ASSERT_NEAR(120.3015, histogram.get_sum(), 1e-6);
+}
+
+TEST(metrics_test, render)
+{
+	helpers::worker_metrics metrics;
+	metrics.jobs_ok.add(2);
+	metrics.tasks_failed.add();
+	metrics.fetched_bytes.add(1024);
+	metrics.job_duration.observe(0.2);
+	metrics.job_duration.observe(7);
+	metrics.upload_queue.set(1);
+
+	std::string text = metrics.render();
+
+	ASSERT_THAT(text, HasSubstr("# TYPE recodex_worker_jobs_total counter\n"));
+	ASSERT_THAT(text, HasSubstr("recodex_worker_jobs_total{result=\"OK\"} 2\n"));
+	ASSERT_THAT(text, HasSubstr("recodex_worker_jobs_total{result=\"FAILED\"} 0\n"));
+	ASSERT_THAT(text, HasSubstr("recodex_worker_tasks_total{status=\"FAILED\"} 1\n"));
+	ASSERT_THAT(text, HasSubstr("recodex_worker_fetched_bytes_total 1024\n"));
+	ASSERT_THAT(text, HasSubstr("# TYPE recodex_worker_job_duration_seconds histogram\n"));
+	// buckets are cumulative
+	ASSERT_THAT(text, HasSubstr("recodex_worker_job_duration_seconds_bucket{le=\"0.1\"} 0\n"));
+	ASSERT_THAT(text, HasSubstr("recodex_worker_job_duration_seconds_bucket{le=\"0.25\"} 1\n"));
+	ASSERT_THAT(text, HasSubstr("recodex_worker_job_duration_seconds_bucket{le=\"10\"} 2\n"));
+	ASSERT_THAT(text, HasSubstr("recodex_worker_job_duration_seconds_bucket{le=\"+Inf\"} 2\n"));
+	ASSERT_THAT(text, HasSubstr("recodex_worker_job_duration_seconds_sum 7.2\n"));
+	ASSERT_THAT(text, HasSubstr("recodex_worker_job_duration_seconds_count 2\n"));
+	ASSERT_THAT(text, HasSubstr("recodex_worker_upload_queue 1\n"));
+}
@@ -31,6 +31,10 @@ public:
 	mock_worker_config()
 	{
 		ON_CALL(*this, get_broker_ping_interval()).WillByDefault(Return(std::chrono::milliseconds(1000)));
+		ON_CALL(*this, get_max_parallel_tasks()).WillByDefault(Return(1));
+		ON_CALL(*this, get_prefetch_next_job()).WillByDefault(Return(false));
+		ON_CALL(*this, get_result_format()).WillByDefault(ReturnRefOfCopy(std::string("zip")));
+		ON_CALL(*this, get_slots()).WillByDefault(Return(1));
 	}
 
 	MOCK_CONST_METHOD0(get_broker_uri, const std::string &());
@@ -41,6 +45,10 @@ public:
 	MOCK_CONST_METHOD0(get_worker_description, const std::string &());
 	MOCK_CONST_METHOD0(get_limits, const sandbox_limits &());
 	MOCK_CONST_METHOD0(get_max_output_length, std::size_t());
+	MOCK_CONST_METHOD0(get_max_parallel_tasks, std::size_t());
+	MOCK_CONST_METHOD0(get_prefetch_next_job, bool());
+	MOCK_CONST_METHOD0(get_result_format, const std::string &());
+	MOCK_CONST_METHOD0(get_slots, std::size_t());
 };
 
 /**
@@ -147,6 +155,7 @@ public:
 	{
 	}
 	MOCK_METHOD1(evaluate, eval_response(eval_request));
+	MOCK_METHOD1(prefetch, void(eval_request));
 };
 
 #endif // RECODEX_WORKER_TESTS_MOCKS_H
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <system_error>
+#include <unistd.h>
+
+#include "helpers/process.h"
+
+
+TEST(process_test, child_ends_in_time)
+{
+	pid_t pid = fork();
+	ASSERT_NE(-1, pid);
+	if (pid == 0) { _exit(3); }
+
+	int status;
+	ASSERT_TRUE(helpers::wait_for_child(pid, std::chrono::seconds(10), status));
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(3, WEXITSTATUS(status));
+}
+
+TEST(process_test, child_killed_after_timeout)
+{
+	pid_t pid = fork();
+	ASSERT_NE(-1, pid);
+	if (pid == 0) {
+		sleep(10);
+		_exit(0);
+	}
+
+	auto started = std::chrono::steady_clock::now();
+	int status;
+	ASSERT_FALSE(helpers::wait_for_child(pid, std::chrono::milliseconds(100), status));
+	ASSERT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(5));
+	ASSERT_TRUE(WIFSIGNALED(status));
+	ASSERT_EQ(SIGKILL, WTERMSIG(status));
+
+	// the process is reaped
+	ASSERT_EQ(-1, waitpid(pid, &status, WNOHANG));
+}
+
+TEST(process_test, wait_for_reaped_child)
+{
+	pid_t pid = fork();
+	ASSERT_NE(-1, pid);
+	if (pid == 0) { _exit(0); }
+
+	int status;
+	ASSERT_EQ(pid, waitpid(pid, &status, 0));
+	ASSERT_THROW(helpers::wait_for_child(pid, std::chrono::seconds(10), status), std::system_error);
+}
+
+TEST(process_test, spawn_with_output)
+{
+	int fd[2];
+	ASSERT_EQ(0, pipe2(fd, O_CLOEXEC));
+
+	pid_t pid = helpers::spawn_process({"sh", "-c", "echo hello; exit 5"}, fd[1]);
+	close(fd[1]);
+	ASSERT_NE(-1, pid);
+
+	char buf[16];
+	ssize_t size = read(fd[0], buf, sizeof(buf));
+	close(fd[0]);
+	ASSERT_EQ("hello\n", std::string(buf, size > 0 ? size : 0));
+
+	int status;
+	ASSERT_TRUE(helpers::wait_for_child(pid, std::chrono::seconds(10), status));
+	ASSERT_EQ(5, WEXITSTATUS(status));
+}
+
+TEST(process_test, spawn_missing_program)
+{
+	ASSERT_EQ(-1, helpers::spawn_process({"recodex-nonexisting-program"}));
+	ASSERT_EQ(ENOENT, errno);
+}
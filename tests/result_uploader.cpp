@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <fstream>
+#include <future>
+
+#include "mocks.h"
+#include "job/result_uploader.h"
+
+#define BOOST_FILESYSTEM_NO_DEPRECATED
+#define BOOST_NO_CXX11_SCOPED_ENUMS
+#include <boost/filesystem.hpp>
+namespace fs = boost::filesystem;
+
+
+class result_uploader_test : public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		archive_ = (fs::temp_directory_path() / fs::unique_path("recodex_upload_%%%%-%%%%.zip")).string();
+		std::ofstream(archive_) << "results";
+		fm_ = std::make_shared<StrictMock<mock_file_manager>>();
+		callback_ = std::make_shared<StrictMock<mock_progress_callback>>();
+	}
+
+	void TearDown() override
+	{
+		fs::remove(archive_);
+	}
+
+	std::string archive_;
+	std::shared_ptr<StrictMock<mock_file_manager>> fm_;
+	std::shared_ptr<StrictMock<mock_progress_callback>> callback_;
+};
+
+
+TEST_F(result_uploader_test, synchronous_upload)
+{
+	result_uploader uploader(fm_, callback_);
+
+	{
+		InSequence s;
+		EXPECT_CALL(*fm_, put_file(archive_, "http://results/job_1"));
+		EXPECT_CALL(*callback_, job_results_uploaded("job_1"));
+		EXPECT_CALL(*callback_, job_finished("job_1"));
+	}
+
+	auto response = uploader.upload("job_1", archive_, "http://results/job_1");
+	ASSERT_EQ(std::future_status::ready, response.wait_for(std::chrono::milliseconds(0)));
+	ASSERT_EQ("job_1", response.get().job_id);
+	ASSERT_EQ("OK", response.get().result);
+	ASSERT_FALSE(fs::exists(archive_));
+}
+
+TEST_F(result_uploader_test, failed_upload_is_repeated)
+{
+	result_uploader uploader(fm_, callback_, nullptr, 0, 2, std::chrono::milliseconds(1));
+
+	EXPECT_CALL(*fm_, put_file(archive_, "url"))
+		.WillOnce(Throw(fm_exception("server unavailable")))
+		.WillOnce(Return());
+	EXPECT_CALL(*callback_, job_results_uploaded("job_1"));
+	EXPECT_CALL(*callback_, job_finished("job_1"));
+
+	auto response = uploader.upload("job_1", archive_, "url");
+	ASSERT_EQ("OK", response.get().result);
+}
+
+TEST_F(result_uploader_test, all_attempts_failed)
+{
+	result_uploader uploader(fm_, callback_, nullptr, 0, 2, std::chrono::milliseconds(1));
+
+	EXPECT_CALL(*fm_, put_file(archive_, "url")).Times(3).WillRepeatedly(Throw(fm_exception("server unavailable")));
+	EXPECT_CALL(*callback_, job_aborted("job_1"));
+
+	auto response = uploader.upload("job_1", archive_, "url");
+	ASSERT_EQ("INTERNAL_ERROR", response.get().result);
+	ASSERT_EQ("server unavailable", response.get().message);
+	ASSERT_FALSE(fs::exists(archive_));
+}
+
+TEST_F(result_uploader_test, background_upload)
+{
+	std::promise<void> server_ready;
+	auto server = server_ready.get_future().share();
+
+	EXPECT_CALL(*fm_, put_file(archive_, "url")).WillOnce(InvokeWithoutArgs([server]() { server.wait(); }));
+	EXPECT_CALL(*callback_, job_results_uploaded("job_1"));
+	EXPECT_CALL(*callback_, job_finished("job_1"));
+
+	result_uploader uploader(fm_, callback_, nullptr, 1);
+
+	// upload waits for the server, but the evaluation can continue
+	auto response = uploader.upload("job_1", archive_, "url");
+	ASSERT_EQ(std::future_status::timeout, response.wait_for(std::chrono::milliseconds(10)));
+
+	server_ready.set_value();
+	ASSERT_EQ("OK", response.get().result);
+}
@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "helpers/sha1.h"
+
+
+std::string digest_of(const std::string &text)
+{
+	helpers::sha1 digest;
+	digest.update(text.data(), text.size());
+	return digest.hex_digest();
+}
+
+TEST(sha1_test, known_digests)
+{
+	ASSERT_EQ("da39a3ee5e6b4b0d3255bfef95601890afd80709", digest_of(""));
+	ASSERT_EQ("a9993e364706816aba3e25717850c26c9cd0d89d", digest_of("abc"));
+	ASSERT_EQ("84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+		digest_of("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"));
+	ASSERT_EQ("34aa973cd4c4daa4f61eeb2bdbad27316534016f", digest_of(std::string(1000000, 'a')));
+}
+
+TEST(sha1_test, chunked_update)
+{
+	std::string text = "The quick brown fox jumps over the lazy dog";
+	for (std::size_t chunk = 1; chunk <= text.size(); ++chunk) {
+		helpers::sha1 digest;
+		for (std::size_t pos = 0; pos < text.size(); pos += chunk) {
+			digest.update(text.data() + pos, std::min(chunk, text.size() - pos));
+		}
+		ASSERT_EQ("2fd4e1c67a2d28fced849ee1bb76e7391b93eb12", digest.hex_digest());
+	}
+}
@@ -0,0 +1,76 @@
+/*
+ * Microbenchmark of process creation, it is not a part of the test suites.
+ * It compares latency of fork + exec, which was used to launch isolate, with helpers::spawn_process
+ * at different sizes of resident memory of the calling process.
+ *
+ * Usage: spawn_benchmark [iterations] [program]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "helpers/process.h"
+
+
+namespace
+{
+	using clock_type = std::chrono::steady_clock;
+
+	pid_t fork_exec(const std::vector<std::string> &args)
+	{
+		std::vector<char *> argv;
+		for (auto &arg : args) { argv.push_back(const_cast<char *>(arg.c_str())); }
+		argv.push_back(nullptr);
+
+		pid_t pid = fork();
+		if (pid == 0) {
+			execvp(argv[0], argv.data());
+			_exit(127);
+		}
+		return pid;
+	}
+
+	template <typename spawn_fn>
+	double measure(spawn_fn spawn, const std::vector<std::string> &args, std::size_t iterations)
+	{
+		auto started = clock_type::now();
+		for (std::size_t i = 0; i < iterations; ++i) {
+			pid_t pid = spawn(args);
+			if (pid == -1) {
+				std::cerr << "Process cannot be started: " << strerror(errno) << std::endl;
+				exit(1);
+			}
+			int status;
+			waitpid(pid, &status, 0);
+		}
+		std::chrono::duration<double, std::micro> duration = clock_type::now() - started;
+		return duration.count() / iterations;
+	}
+} // namespace
+
+int main(int argc, char **argv)
+{
+	std::size_t iterations = argc > 1 ? std::stoul(argv[1]) : 200;
+	std::vector<std::string> args = {argc > 2 ? argv[2] : "true"};
+
+	std::vector<char> ballast;
+	std::cout << "rss_mib\tfork_exec_us\tspawn_us" << std::endl;
+	for (std::size_t mib : {0, 64, 256, 1024}) {
+		// touch every page, so that the memory is really resident
+		ballast.resize(mib << 20);
+		for (std::size_t i = 0; i < ballast.size(); i += 4096) { ballast[i] = 1; }
+
+		double forked = measure(fork_exec, args, iterations);
+		double spawned = measure(
+			[](const std::vector<std::string> &a) { return helpers::spawn_process(a); }, args, iterations);
+		std::cout << mib << "\t" << forked << "\t" << spawned << std::endl;
+	}
+
+	return 0;
+}
@@ -4,6 +4,7 @@
 #include <fstream>
 
 #include "tasks/internal/archivate_task.h"
+#include "archives/archivator.h"
 #include "tasks/internal/cp_task.h"
 #include "tasks/internal/extract_task.h"
 #include "tasks/internal/mkdir_task.h"
@@ -75,6 +76,25 @@ TEST(Tasks, InternalArchivateTask)
 	EXPECT_NO_THROW(archivate_task(1, get_two_args()));
 }
 
+TEST(Tasks, InternalArchivateTaskZstd)
+{
+	auto dir = fs::temp_directory_path() / fs::unique_path("recodex_archivate_%%%%-%%%%");
+	fs::create_directories(dir / "output");
+	std::ofstream((dir / "output" / "out.txt").string()) << "output";
+
+	auto meta = get_task_meta();
+	meta->cmd_args = {(dir / "output").string(), (dir / "output.tar.zst").string()};
+	auto results = archivate_task(1, meta, 2).run();
+	EXPECT_EQ(task_status::OK, results->status);
+
+	// suffix selects the format
+	fs::create_directories(dir / "extracted");
+	archivator::decompress((dir / "output.tar.zst").string(), (dir / "extracted").string());
+	EXPECT_TRUE(fs::is_regular_file(dir / "extracted" / "output" / "out.txt"));
+
+	fs::remove_all(dir);
+}
+
 TEST(Tasks, InternalCpTask)
 {
 	EXPECT_THROW(cp_task(1, get_three_args()), task_exception);
@@ -160,6 +180,74 @@ TEST(Tasks, InternalFetchTask)
 	EXPECT_NO_THROW(fetch_task(1, get_two_args(), nullptr));
 }
 
+// writes name of the fetched file into the destination
+void write_fetched_name(const std::string &name, const std::string &dst_path)
+{
+	std::ofstream(dst_path) << name;
+}
+
+std::string read_file_content(const fs::path &path)
+{
+	std::ifstream file(path.string());
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+TEST(Tasks, InternalFetchTaskPrefetch)
+{
+	auto dir = fs::temp_directory_path() / fs::unique_path();
+	fs::create_directories(dir);
+	auto fileman = std::make_shared<mock_file_manager>();
+	std::vector<std::shared_ptr<fetch_task>> tasks;
+	for (auto name : {"first", "second", "missing"}) {
+		auto meta = get_task_meta();
+		meta->cmd_args = {name, (dir / name).string()};
+		tasks.push_back(std::make_shared<fetch_task>(1, meta, fileman));
+	}
+
+	// prefetched files are not fetched again, failure of prefetching is the failure of the task
+	EXPECT_CALL(*fileman, get_file("first", _)).WillOnce(Invoke(write_fetched_name));
+	EXPECT_CALL(*fileman, get_file("second", _)).WillOnce(Invoke(write_fetched_name));
+	EXPECT_CALL(*fileman, get_file("missing", _)).WillOnce(Throw(fm_exception("not found")));
+
+	fetch_task::prefetch(tasks, dir / "staging");
+	// nothing is moved into place before the task is run
+	EXPECT_EQ(task_status::OK, tasks[0]->run()->status);
+	EXPECT_FALSE(fs::exists(dir / "second"));
+	EXPECT_EQ(task_status::OK, tasks[1]->run()->status);
+	auto failed = tasks[2]->run();
+	EXPECT_EQ(task_status::FAILED, failed->status);
+	EXPECT_EQ("Cannot fetch files. Error: not found", failed->error_message);
+	EXPECT_EQ("first", read_file_content(dir / "first"));
+	EXPECT_EQ("second", read_file_content(dir / "second"));
+
+	fs::remove_all(dir);
+}
+
+TEST(Tasks, InternalFetchTaskPrefetchSharedDestination)
+{
+	auto dir = fs::temp_directory_path() / fs::unique_path();
+	fs::create_directories(dir);
+	auto fileman = std::make_shared<mock_file_manager>();
+	std::vector<std::shared_ptr<fetch_task>> tasks;
+	for (auto name : {"input1", "input2"}) {
+		auto meta = get_task_meta();
+		meta->cmd_args = {name, (dir / "input").string()};
+		tasks.push_back(std::make_shared<fetch_task>(1, meta, fileman));
+	}
+
+	// only the first file is prefetched, the second one is fetched in its turn
+	EXPECT_CALL(*fileman, get_file("input1", _)).WillOnce(Invoke(write_fetched_name));
+	EXPECT_CALL(*fileman, get_file("input2", (dir / "input").string())).WillOnce(Invoke(write_fetched_name));
+
+	fetch_task::prefetch(tasks, dir / "staging");
+	EXPECT_EQ(task_status::OK, tasks[0]->run()->status);
+	EXPECT_EQ("input1", read_file_content(dir / "input"));
+	EXPECT_EQ(task_status::OK, tasks[1]->run()->status);
+	EXPECT_EQ("input2", read_file_content(dir / "input"));
+
+	fs::remove_all(dir);
+}
+
 TEST(Tasks, InternalExistsTask)
 {
 	EXPECT_THROW(exists_task(1, get_zero_args()), task_exception);
@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <atomic>
+
+#include "helpers/thread_pool.h"
+
+
+TEST(thread_pool_test, at_least_one_thread)
+{
+	helpers::thread_pool pool(0);
+	ASSERT_EQ(1u, pool.size());
+}
+
+TEST(thread_pool_test, all_jobs_executed)
+{
+	std::atomic<std::size_t> counter(0);
+	{
+		helpers::thread_pool pool(4);
+		ASSERT_EQ(4u, pool.size());
+		for (std::size_t i = 0; i < 100; ++i) {
+			pool.enqueue([&counter]() { ++counter; });
+		}
+		// destructor waits for all enqueued jobs
+	}
+	ASSERT_EQ(100u, counter.load());
+}
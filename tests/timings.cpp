@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <stdexcept>
+#include <thread>
+
+#include "helpers/timings.h"
+
+
+TEST(timings_test, phase_timer)
+{
+	helpers::phase_timings timings;
+	{
+		helpers::phase_timer first(timings, "first");
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		first.stop();
+		first.stop();
+
+		helpers::phase_timer second(timings, "second");
+	}
+
+	ASSERT_EQ((std::size_t) 2, timings.size());
+	EXPECT_EQ("first", timings[0].first);
+	EXPECT_GE(timings[0].second, 0.01);
+	EXPECT_EQ("second", timings[1].first);
+	EXPECT_LT(timings[1].second, timings[0].second);
+}
+
+TEST(timings_test, phase_timer_exception)
+{
+	helpers::phase_timings timings;
+	try {
+		helpers::phase_timer timer(timings, "failing");
+		throw std::runtime_error("failure");
+	} catch (std::runtime_error &) {
+	}
+
+	ASSERT_EQ((std::size_t) 1, timings.size());
+	EXPECT_EQ("failing", timings[0].first);
+}
+
+TEST(timings_test, add_timings)
+{
+	helpers::phase_timings totals;
+	helpers::add_timings(totals, {{"init", 1.0}, {"run", 2.0}});
+	helpers::add_timings(totals, {{"run", 0.5}, {"output", 0.25}});
+
+	helpers::phase_timings expected = {{"init", 1.0}, {"run", 2.5}, {"output", 0.25}};
+	EXPECT_EQ(expected, totals);
+}
+
+TEST(timings_test, format_timings)
+{
+	EXPECT_EQ("", helpers::format_timings({}));
+	EXPECT_EQ("download 0.120 s, run 1.500 s", helpers::format_timings({{"download", 0.12}, {"run", 1.5}}));
+}
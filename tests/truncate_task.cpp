@@ -55,3 +55,14 @@ TEST_F(truncate_task_test, small_file)
 
 	ASSERT_EQ(16384u, fs::file_size(root / "file_a"));
 }
+
+TEST_F(truncate_task_test, hardlinked_file)
+{
+	fs::create_hard_link(root / "file_a", root / "file_b");
+	task_meta->cmd_args[1] = "2";
+	task->run();
+
+	ASSERT_EQ(2048u, fs::file_size(root / "file_a"));
+	ASSERT_EQ(16384u, fs::file_size(root / "file_b"));
+	ASSERT_EQ(1u, fs::hard_link_count(root / "file_b"));
+}
@@ -27,6 +27,11 @@ TEST(worker_config, load_yaml_basic)
 						   "      password: 654321\n"
 						   "file-cache:\n"
 						   "    cache-dir: /tmp/isoeval/cache\n"
+						   "    max-size: 1073741824\n"
+						   "    hardlinks: true\n"
+						   "box-pool:\n"
+						   "    size: 3\n"
+						   "    first-box-id: 20\n"
 						   "logger:\n"
 						   "    file: /var/log/isoeval\n"
 						   "    level: emerg\n"
@@ -55,6 +60,19 @@ TEST(worker_config, load_yaml_basic)
 						   "max-output-length: 1024\n"
 						   "max-carboncopy-length: 1048576\n"
 						   "cleanup-submission: true\n"
+						   "max-parallel-tasks: 4\n"
+						   "sandbox-data-mode: rename\n"
+						   "prefetch-next-job: true\n"
+						   "result-upload:\n"
+						   "    queue-size: 5\n"
+						   "    retries: 7\n"
+						   "result-archive:\n"
+						   "    format: tar.zst\n"
+						   "    level: 9\n"
+						   "compression-threads: 3\n"
+						   "metrics-endpoint: tcp://127.0.0.1:9100\n"
+						   "slots: 2\n"
+						   "box-cgroup-root: /sys/fs/cgroup/isolate.slice/isolate.service\n"
 						   "...");
 
 	worker_config config(yaml);
@@ -101,6 +119,8 @@ TEST(worker_config, load_yaml_basic)
 	ASSERT_EQ((std::size_t) 8, config.get_worker_id());
 	ASSERT_EQ("/tmp/working_dir", config.get_working_directory());
 	ASSERT_STREQ("/tmp/isoeval/cache", config.get_cache_dir().c_str());
+	ASSERT_EQ((std::size_t) 1073741824, config.get_cache_max_size());
+	ASSERT_EQ(true, config.get_cache_hardlinks());
 	ASSERT_EQ(expected_headers, config.get_headers());
 	ASSERT_EQ("group_1", config.get_hwgroup());
 	ASSERT_EQ(expected_limits, config.get_limits());
@@ -111,6 +131,43 @@ TEST(worker_config, load_yaml_basic)
 	ASSERT_EQ((std::size_t) 1024, config.get_max_output_length());
 	ASSERT_EQ((std::size_t) 1048576, config.get_max_carboncopy_length());
 	ASSERT_EQ(true, config.get_cleanup_submission());
+	ASSERT_EQ((std::size_t) 4, config.get_max_parallel_tasks());
+	ASSERT_EQ((std::size_t) 3, config.get_box_pool_size());
+	ASSERT_EQ((std::size_t) 20, config.get_box_pool_first_id());
+	ASSERT_EQ(sandbox_data_mode::RENAME, config.get_sandbox_data_mode());
+	ASSERT_EQ(true, config.get_prefetch_next_job());
+	ASSERT_EQ((std::size_t) 5, config.get_upload_queue_size());
+	ASSERT_EQ((std::size_t) 7, config.get_upload_retries());
+	ASSERT_EQ("tar.zst", config.get_result_format());
+	ASSERT_EQ(9, config.get_result_compression_level());
+	ASSERT_EQ((std::size_t) 3, config.get_compression_threads());
+	ASSERT_EQ("tcp://127.0.0.1:9100", config.get_metrics_endpoint());
+	ASSERT_EQ((std::size_t) 2, config.get_slots());
+	ASSERT_EQ("/sys/fs/cgroup/isolate.slice/isolate.service", config.get_box_cgroup_root());
+
+	auto slot = config.get_slot_config(1);
+	ASSERT_EQ((std::size_t) 9, slot->get_worker_id());
+	ASSERT_EQ((std::size_t) 23, slot->get_box_pool_first_id());
+	ASSERT_EQ((std::size_t) 3, slot->get_box_pool_size());
+	ASSERT_EQ("/tmp/working_dir", slot->get_working_directory());
+	ASSERT_THROW(config.get_slot_config(2), config_error);
+}
+
+/**
+ * Pool of more boxes without first box identifier causes an exception, pools of workers would overlap
+ */
+TEST(worker_config, box_pool_without_first_id)
+{
+	auto yaml = YAML::Load("worker-id: 1\n"
+						   "broker-uri: tcp://localhost:1234\n"
+						   "headers:\n"
+						   "    env:\n"
+						   "        - c\n"
+						   "hwgroup: group_1\n"
+						   "box-pool:\n"
+						   "    size: 3\n");
+
+	ASSERT_THROW(worker_config config(yaml), config_error);
 }
 
 /**